@@ -88,6 +88,9 @@ public:
 
     virtual void publishAlgoperformance() const {}
 
+    /* 当前绩效消息(MsgAlgoPerformance/MsgShotPerformance), 多日回测汇总用 */
+    virtual std::shared_ptr<google::protobuf::Message> encodePerformanceMessage() const { return nullptr; }
+
     OnAlgoPerformanceUpdate onAlgoPerformanceUpdate{ nullptr };
 
     virtual void release() {};
@@ -98,6 +101,8 @@ public:
 
     std::atomic<bool>  hasStarted;
 
+    std::function<void()>  releaseSchedulerSlot{ nullptr };   // 回测: 归还 BacktestScheduler 执行槽位
+
     template<class T>  
     requires std::is_base_of_v<Trader, T>
     std::shared_ptr<T> keep_alive_this() {
@@ -26,7 +26,7 @@ void AlgoPerformance::performanceSummay(const MarketDepth* md) {
 
             if ((arrivePrice == 0 || arriveMarketAmount == 0 || arriveMarketVolume == 0) && md->amount > 0) {
                 arriveMarketTime = boost::posix_time::to_simple_string(md->quoteTime);
-                arrivePrice = md->price > 0 ? md->price : std::max(md->askPrice1, md->bidPrice1);
+                arrivePrice = md->price > 0 ? md->price : std::max(md->askPrices[0], md->bidPrices[0]);
                 arriveMarketAmount = md->amount;
                 arriveMarketVolume = md->volume;
                 SPDLOG_INFO("[{}]arriveMarketTime:{},arrivePrice:{:.2f}", algoOrderId, arriveMarketTime, arrivePrice);
@@ -63,7 +63,7 @@ void AlgoPerformance::onOrderRequest(const OrderPtr& order, const MarketDepth* m
 
     amt += order->orderQty * order->orderPrice;
 
-    if ((order->isBuy() && order->orderPrice < md->askPrice1) || (!order->isBuy() && order->orderPrice > md->bidPrice1 and md->bidPrice1>0)) {
+    if ((order->isBuy() && order->orderPrice < md->askPrices[0]) || (!order->isBuy() && order->orderPrice > md->bidPrices[0] and md->bidPrices[0]>0)) {
 
         qtyMaker += order->orderQty;
 
@@ -261,14 +261,14 @@ std::pair<int, int> AlgoPerformance::getQtyPendingAtBestPrice(const MarketDepth*
     //std::cout << "getQtyPendingAtBestPrice:" << orderId2Order.size() << std::endl;
     if (isBuy) {
         for (const auto& [orderId, order] : orderId2Order) {
-            qtyAtBest += order->orderPrice == md->bidPrice1 && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
-            qtyOutOfBest += order->orderPrice < md->bidPrice1 && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
+            qtyAtBest += order->orderPrice == md->bidPrices[0] && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
+            qtyOutOfBest += order->orderPrice < md->bidPrices[0] && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
         }
     }
     else {
         for (const auto& [orderId, order] : orderId2Order) {
-            qtyAtBest    += order->orderPrice == md->askPrice1 && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
-            qtyOutOfBest += order->orderPrice > md->askPrice1 && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
+            qtyAtBest    += order->orderPrice == md->askPrices[0] && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
+            qtyOutOfBest += order->orderPrice > md->askPrices[0] && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
         }
     }
     return std::make_pair(qtyAtBest, qtyOutOfBest);
@@ -290,8 +290,8 @@ std::tuple<int, int, std::vector<OrderId_t>> AlgoPerformance::getOrderDataXXBest
     if (isBuy) {
         for (auto it = orderId2Order.begin(); it != orderId2Order.end();it++) {
             const auto& [orderId, order] = *it;
-            qtyAtBest += order->orderPrice >= md->bidPrice1 && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
-            if (order->orderPrice < md->bidPrice1 && !order->isFinalStatus()) {
+            qtyAtBest += order->orderPrice >= md->bidPrices[0] && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
+            if (order->orderPrice < md->bidPrices[0] && !order->isFinalStatus()) {
                 qtyOutOfBest += (order->orderQty - order->filledQty);
                 outOfBestPriceOrderIds.push_back(order->orderId);
             }
@@ -300,8 +300,8 @@ std::tuple<int, int, std::vector<OrderId_t>> AlgoPerformance::getOrderDataXXBest
     else {
         for (auto it = orderId2Order.begin(); it != orderId2Order.end(); it++) {
             const auto& [orderId, order] = *it;
-            qtyAtBest += order->orderPrice <= md->askPrice1 && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
-            if (order->orderPrice > md->askPrice1 && !order->isFinalStatus()) {
+            qtyAtBest += order->orderPrice <= md->askPrices[0] && !order->isFinalStatus() ? (order->orderQty - order->filledQty) : 0;
+            if (order->orderPrice > md->askPrices[0] && !order->isFinalStatus()) {
                 qtyOutOfBest += (order->orderQty - order->filledQty);
                 outOfBestPriceOrderIds.push_back(order->orderId);
             }
@@ -17,7 +17,6 @@ AlgoTrader::AlgoTrader(const std::shared_ptr<AlgoOrder>& _algoOrderPtr
     , algoPerf{ _algoOrderPtr.get(), ssinfoPtr }
 
     , timer(*contextPtr)
-    , wait2Resume(*contextPtr, _algoOrderPtr->algoOrderId)
     , curSlicerIndex(-1)
     , startTime(_algoOrderPtr->startTime)
     , endTime(_algoOrderPtr->endTime)
@@ -195,6 +194,8 @@ asio::awaitable<void> AlgoTrader::start() {
 
         OrderBookRequest orderRouter_req(algoOrderPtr->getOrderBookKey(), algoOrderPtr->getQuoteMode(), contextPtr, quoteFeedPtr);
 
+        orderRouter_req.fillModel = static_cast<FillModel>(algoOrderPtr->getOrDefault("SIM_FillModel", 0));
+
         orderBookPtr = OrderService::getInstance().createOrderBookIfNotExist(orderRouter_req, algoPerf.errMsg);
 
         if (orderBookPtr == nullptr) {
@@ -210,7 +211,6 @@ asio::awaitable<void> AlgoTrader::start() {
     auto onTrade        = nullptr;
 
     auto onMarketDepth = [self](MarketDepth* md) { self->onMarketDepth(md); };
-    co_OnMarketDepthCallback co_onMarketDepth = [self](MarketDepth* md) -> asio::awaitable<int> { co_return co_await self->co_onMarketDepth(md); };
 
     auto subscribeOrderUpdate = std::make_shared<SubscribeOrder_t>(algoOrderId, onOrderUpdate, onTrade,contextPtr);
 
@@ -226,7 +226,7 @@ asio::awaitable<void> AlgoTrader::start() {
     auto subscribeMarketDepth = std::make_shared<SubMarketDepth_t>(algoOrderId
         , std::unordered_set<Symbol_t>{algoOrderPtr->symbol}
         , onMarketDepth
-        , co_onMarketDepth
+        , nullptr
         , algoOrderPtr->getAcctKey()
         , false
         ,contextPtr);
@@ -280,7 +280,11 @@ void AlgoTrader::stop(const std::string& reason) {
         }
     }
 
-    wait2Resume.clear();
+    if (quoteFeedPtr) {
+        if (auto clockPtr = quoteFeedPtr->virtualClock()) {
+            clockPtr->cancel(algoOrderId);
+        }
+    }
 
     SPDLOG_INFO("{},mds:{},last md:{}", algoPerf.to_string(), mdcounts,agcommon::getDateTimeInt(m_md->quoteTime));
     
@@ -391,11 +395,11 @@ void AlgoTrader::placeOrder(const int qty, const double price,bool checkMinAmtPe
 
         algoPerf.onOrderRequest(order, m_md.get());
 
-        SPDLOG_DEBUG("[OrderNew]{},bid1/ask1:{},{},qtime:{},total qty:{}", order->to_string(), m_md->bidPrice1, m_md->askPrice1, agcommon::getTimeStr(m_md->quoteTime),algoPerf.qty);
+        SPDLOG_DEBUG("[OrderNew]{},bid1/ask1:{},{},qtime:{},total qty:{}", order->to_string(), m_md->bidPrices[0], m_md->askPrices[0], agcommon::getTimeStr(m_md->quoteTime),algoPerf.qty);
         
         if (not orderBookPtr->placeOrder(order.get())) {
 
-            SPDLOG_WARN("[OrderFailed]{},bid1/ask1:{},{},qtime:{}", order->to_string(), m_md->bidPrice1, m_md->askPrice1, agcommon::getTimeStr(m_md->quoteTime));
+            SPDLOG_WARN("[OrderFailed]{},bid1/ask1:{},{},qtime:{}", order->to_string(), m_md->bidPrices[0], m_md->askPrices[0], agcommon::getTimeStr(m_md->quoteTime));
             
             order->status = agcommon::OrderStatus::REJECTED;
 
@@ -458,7 +462,7 @@ void AlgoTrader::onMarketDepth(MarketDepth* newMd) {  //shoud dispatch in trader
 
     //executeSignal(newMd,m_md.get());      // quick act on predict LOB change if possible
 
-    m_md = MarketDepthKeepAlivePtr(newMd);
+    m_md = MarketDepth::keepAlive(newMd);
 
     mdcounts++;
 
@@ -467,47 +471,28 @@ void AlgoTrader::onMarketDepth(MarketDepth* newMd) {  //shoud dispatch in trader
 /*executeSignal: demo only */
 void AlgoTrader::executeSignal(const MarketDepth* newMd, const MarketDepth* last_md) {
 
-    if (newMd->flow > 200 * 10000 and newMd->askPrice1 > last_md->askPrice1) {
+    if (newMd->flow > 200 * 10000 and newMd->askPrices[0] > last_md->askPrices[0]) {
 
         if (algoPerf.isBuy) {
-            slicePolicyOnSignal(PolicyAction::TAKE, newMd->askPrice1);  //take now
+            slicePolicyOnSignal(PolicyAction::TAKE, newMd->askPrices[0]);  //take now
         }
         else {
-            slicePolicyOnSignal(PolicyAction::MAKE, newMd->askPrice3);  //make at high
+            slicePolicyOnSignal(PolicyAction::MAKE, newMd->askPrices[2]);  //make at high
         }
     }
-    if (newMd->flow < -200 * 10000 and newMd->bidPrice1 < last_md->bidPrice1) {
+    if (newMd->flow < -200 * 10000 and newMd->bidPrices[0] < last_md->bidPrices[0]) {
 
         if (algoPerf.isBuy) {
 
-            slicePolicyOnSignal(PolicyAction::MAKE, newMd->bidPrice3);  //make at low
+            slicePolicyOnSignal(PolicyAction::MAKE, newMd->bidPrices[2]);  //make at low
         }
         else {
-            slicePolicyOnSignal(PolicyAction::TAKE, newMd->bidPrice1); // take now
+            slicePolicyOnSignal(PolicyAction::TAKE, newMd->bidPrices[0]); // take now
         }
     }
 
 }
 
-asio::awaitable<int> AlgoTrader::co_onMarketDepth(const MarketDepth* _md) {
-
-        if (algoOrderPtr->isBackTestOrder()) {
-            if (!AlgoStatus::isRunning(algoPerf.algoStatus)) {
-                SPDLOG_DEBUG("[aId:{}]{}", algoOrderId, algoPerf.algoStatus);
-                wait2Resume.clear();
-            }
-            else {
-                if (agcommon::addDuration(_md->quoteTime,3.0) >= replayNextQuoteTime) {
-                    SPDLOG_DEBUG("[aId:{}]onMarketDepth quoteTime:{} > strategy:{}", algoOrderId
-                        , agcommon::getDateTimeStr(_md->quoteTime), agcommon::getDateTimeStr(replayNextQuoteTime));
-                    co_await wait2Resume.wait();
-                }
-            }
-        }
-
-        co_return algoPerf.algoStatus;
-};
-
 asio::awaitable<void> AlgoTrader::schedual() {
         
         publishAlgoperformance();
@@ -631,7 +616,7 @@ asio::awaitable<void> AlgoTrader::executeSlicer(Slicer& slicer) {
         int marketVolAtLimitPrice = 0;
         if (algoOrderPtr->priceLimit > 0) {
             int qtyAtLimitPrice   = algoPerf.getQtyAtLimitPrice(algoOrderPtr->priceLimit);
-            marketVolAtLimitPrice = m_md->getPricezVol(algoOrderPtr->priceLimit);
+            marketVolAtLimitPrice = m_md->getPricezVol(m_md->toTicks(algoOrderPtr->priceLimit));
             qtyAtBestPrice = std::max(qtyAtBestPrice, qtyAtLimitPrice);
         }
         int32_t beforLastUpper = algoOrderPtr->qtyTarget - ssinfoPtr->getOrderInitQty();
@@ -714,10 +699,10 @@ asio::awaitable<void> AlgoTrader::slicePolicy(Slicer& slicer) {
     }
     std::string lob = std::format("{},bid/ask:{:.3f}@{},{:.3f}@{}"
         , agcommon::getTimeInt(m_md->quoteTime)
-        , m_md->bidPrice1
-        , m_md->bidVol1
-        , m_md->askPrice1
-        , m_md->askVol1);
+        , m_md->bidPrices[0]
+        , m_md->bidVols[0]
+        , m_md->askPrices[0]
+        , m_md->askVols[0]);
 
     int qty2Make_round = slicer.rounds_remain > 0 ? slicer.qty2make_remain / slicer.rounds_remain : slicer.qty2make_remain;
     int qty2Take_round = slicer.rounds_remain > 0 ? slicer.qty2take_remain / slicer.rounds_remain : slicer.qty2take_remain;
@@ -769,10 +754,10 @@ asio::awaitable<void> AlgoTrader::lastSlicePolicy(Slicer& slicer) {
 
     std::string lob = std::format("{},bid/ask:{:.3f}@{},{:.3f}@{}"
         , agcommon::getTimeInt(m_md->quoteTime)
-        , m_md->bidPrice1
-        , m_md->bidVol1
-        , m_md->askPrice1
-        , m_md->askVol1);
+        , m_md->bidPrices[0]
+        , m_md->bidVols[0]
+        , m_md->askPrices[0]
+        , m_md->askVols[0]);
 
     if (slicer.rounds_remain == 1) {
 
@@ -902,7 +887,7 @@ double AlgoTrader::getPriceCover4Take(int qty, double coverRate) {
 
     if (algoPerf.isBuy) {
 
-        price = m_md->askPrice1;
+        price = m_md->askPrices[0];
         auto ask_price2Vol = m_md->getAskQuotes();
 
         for (const auto& item : ask_price2Vol) {
@@ -917,7 +902,7 @@ double AlgoTrader::getPriceCover4Take(int qty, double coverRate) {
             }
         }
     } else {
-        price = m_md->bidPrice1;
+        price = m_md->bidPrices[0];
         auto  bid_price2Vol = m_md->getBidQuotes();
 
         for (const auto& item : bid_price2Vol) {
@@ -940,10 +925,10 @@ int32_t AlgoTrader::getQtyShinkImpact(int32_t qty2take) {
     int32_t maxMarketImpactVol = 0;
 
     if (algoPerf.isBuy) {
-        maxMarketImpactVol = (int32_t)((m_md->askVol1 + m_md->askVol2) * AlgoConstants::MAXShotImpactVolRate);
+        maxMarketImpactVol = (int32_t)((m_md->askVols[0] + m_md->askVols[1]) * AlgoConstants::MAXShotImpactVolRate);
     }
     else {
-        maxMarketImpactVol = (int32_t)((m_md->bidVol1 + m_md->bidVol2) * AlgoConstants::MAXShotImpactVolRate);
+        maxMarketImpactVol = (int32_t)((m_md->bidVols[0] + m_md->bidVols[1]) * AlgoConstants::MAXShotImpactVolRate);
     }
 
     if (qty2take - maxMarketImpactVol >= ssinfoPtr->getOrderInitQty()) {
@@ -953,21 +938,14 @@ int32_t AlgoTrader::getQtyShinkImpact(int32_t qty2take) {
     return ssinfoPtr->floor2FitLotSize(qty2take);
 }
 
+/* 按最小变动价位取档位价, 委托价落在价位网格上, 不带 float 行情的尾差 */
 double AlgoTrader::getPrice4Make(int qty2Make) {
 
-    if (algoPerf.makerFilledRate > 80.0) {
-        if (agcommon::isBuy(algoOrderPtr->tradeSide)) {
-            return m_md->bidPrice2;
-        } else {
-            return m_md->askPrice2;
-        }
-    } else {
-        if (agcommon::isBuy(algoOrderPtr->tradeSide)) {
-            return m_md->bidPrice1;
-        } else {
-            return m_md->askPrice1;
-        }
-    }
+    const auto level = algoPerf.makerFilledRate > 80.0 ? 1 : 0;
+
+    const auto ticks = agcommon::isBuy(algoOrderPtr->tradeSide) ? m_md->bidTicks[level] : m_md->askTicks[level];
+
+    return m_md->priceTick.toPrice(ticks);
 }
 
 asio::awaitable<void> AlgoTrader::awaitMarketTime(double seconds) {
@@ -984,8 +962,11 @@ asio::awaitable<void> AlgoTrader::awaitMarketTime(double seconds) {
 
         if (not AlgoStatus::isFinalStatus(algoPerf.algoStatus)) {
 
-            if (replayNextQuoteTime > m_md->quoteTime) {
-                co_await wait2Resume.wait();
+            auto clockPtr = quoteFeedPtr ? quoteFeedPtr->virtualClock() : nullptr;
+
+            if (clockPtr) {
+                /* 已到时刻也登记, 本时间戳回放完后恢复 */
+                co_await clockPtr->sleepUntil(algoOrderId, replayNextQuoteTime);
             }
             else {
                 co_await asio::post(*contextPtr, asio::use_awaitable);
@@ -1050,7 +1031,7 @@ void AlgoTrader::publishAlgoperformance() const {
 
 std::shared_ptr<AlgoMsg::MsgAlgoPerformance> AlgoTrader::encode2AlgoMessage() const {
 
-    auto msgPtr = std::make_shared<AlgoMsg::MsgAlgoPerformance>();
+    auto msgPtr = MessagePool::getInstance().create<AlgoMsg::MsgAlgoPerformance>();
 
     msgPtr->set_algo_order_id(algoOrderPtr->algoOrderId);
     msgPtr->set_client_algo_order_id(algoOrderPtr->clientAlgoOrderId);
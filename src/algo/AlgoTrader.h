@@ -5,7 +5,6 @@
 #include "Algo.h"
 #include "AlgoPerformance.h"
 #include "common.h"
-#include "waiting.h"
 #include "IdGenerator.h"
 
 class SecurityStaticInfo;
@@ -57,8 +56,6 @@ public:
 
     void onOrderUpdate(const Order* order) override;
 
-    asio::awaitable<int> co_onMarketDepth(const MarketDepth* md);
-
     std::shared_ptr<AlgoMsg::MsgAlgoPerformance> encode2AlgoMessage() const;
 
     const AlgoPerformance& getAlgoPerf() const {
@@ -67,6 +64,8 @@ public:
 
     void publishAlgoperformance() const override;
 
+    std::shared_ptr<google::protobuf::Message> encodePerformanceMessage() const override { return encode2AlgoMessage(); }
+
     void setQuoteFeed(const std::shared_ptr<QuoteFeed>& ptr);
 
     void setOrderBook(const std::shared_ptr<OrderBook>& ptr);
@@ -126,5 +125,4 @@ private:
 
     // back test only
     OrderTime_t         replayNextQuoteTime;
-    Wait2Resume         wait2Resume;
 };
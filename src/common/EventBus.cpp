@@ -0,0 +1,64 @@
+#include "EventBus.h"
+
+uint64_t HopLatency::percentileUs(double p) const {
+
+    uint64_t total = 0;
+    for (auto& bucket : m_buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    auto target = static_cast<uint64_t>(std::ceil(total * p));
+    uint64_t acc = 0;
+
+    for (size_t i = 0; i < Buckets; ++i) {
+        acc += m_buckets[i].load(std::memory_order_relaxed);
+        if (acc >= target) {
+            return i == 0 ? 1 : (uint64_t(1) << i);
+        }
+    }
+    return uint64_t(1) << (Buckets - 1);
+}
+
+std::string HopLatency::to_string() const {
+
+    auto events  = m_events.load(std::memory_order_relaxed);
+    auto batches = m_batches.load(std::memory_order_relaxed);
+    auto avgUs   = events > 0 ? m_sumNs.load(std::memory_order_relaxed) / 1000.0 / events : 0.0;
+
+    return fmt::format("{} events:{},inline:{},batches:{},avgBatch:{:.1f},avg:{:.1f}us,p50<{}us,p99<{}us,max:{:.1f}us"
+        , m_name
+        , events
+        , m_inlines.load(std::memory_order_relaxed)
+        , batches
+        , batches > 0 ? events * 1.0 / batches : 0.0
+        , avgUs
+        , percentileUs(0.5)
+        , percentileUs(0.99)
+        , m_maxNs.load(std::memory_order_relaxed) / 1000.0);
+}
+
+std::shared_ptr<HopLatency> EventBusStat::hop(const std::string& name) {
+
+    std::scoped_lock lock(m_mutex);
+
+    auto& hopPtr = m_hops[name];
+    if (not hopPtr) {
+        hopPtr = std::make_shared<HopLatency>(name);
+    }
+    return hopPtr;
+}
+
+std::string EventBusStat::statInfo() {
+
+    std::scoped_lock lock(m_mutex);
+
+    std::string info{};
+    for (auto& [name, hopPtr] : m_hops) {
+        info += hopPtr->to_string();
+        info += ";";
+    }
+    return info;
+}
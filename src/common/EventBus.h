@@ -0,0 +1,195 @@
+#pragma once
+
+#include <map>
+#include <array>
+#include <bit>
+#include "typedefs.h"
+#include "concurrentqueue.h"
+
+/*
+* 线程间事件通道: 生产者入 moodycamel 无锁队列, 消费者 executor 上每批只投递一次 drain, 批量取出后交给批处理 handler
+*   - 事件按值存放于队列块中, 不再为每个事件构造 asio handler / std::function
+*   - 消费者线程内且队列为空时可直接内联处理(canRunInline), 与原 asio::dispatch 语义一致
+*   - 每跳(hop)记录入队到处理的延迟, 同名 hop 的通道共享统计, 由 EventBusStat 汇总输出
+* Event 需有 int64_t enqueueNs 成员
+*/
+
+inline int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class HopLatency {
+
+public:
+
+    static constexpr size_t Buckets = 24;      // 按 us 取 log2 分桶, 最后一桶 >= 2^22us
+
+    explicit HopLatency(const std::string& name) :m_name(name) {}
+
+    /* 消费者每批调用一次 */
+    inline void recordBatch(const std::array<uint64_t, Buckets>& buckets, uint64_t count, int64_t sumNs, int64_t maxNs) {
+
+        m_events.fetch_add(count, std::memory_order_relaxed);
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+        m_sumNs.fetch_add(sumNs, std::memory_order_relaxed);
+
+        auto curMax = m_maxNs.load(std::memory_order_relaxed);
+        while (maxNs > curMax and not m_maxNs.compare_exchange_weak(curMax, maxNs, std::memory_order_relaxed)) {}
+
+        for (size_t i = 0; i < Buckets; ++i) {
+            if (buckets[i] > 0) {
+                m_buckets[i].fetch_add(buckets[i], std::memory_order_relaxed);
+            }
+        }
+    }
+
+    inline void recordInline() { m_inlines.fetch_add(1, std::memory_order_relaxed); }
+
+    static inline size_t bucketOf(int64_t latencyNs) {
+        auto us = static_cast<uint64_t>(std::max<int64_t>(latencyNs, 0) / 1000);
+        return std::min<size_t>(us == 0 ? 0 : std::bit_width(us), Buckets - 1);
+    }
+
+    /* 分桶上界近似分位数, us */
+    uint64_t percentileUs(double p) const;
+
+    std::string to_string() const;
+
+private:
+
+    std::string                                     m_name;
+
+    std::atomic<uint64_t>                           m_events{ 0 };
+    std::atomic<uint64_t>                           m_batches{ 0 };
+    std::atomic<uint64_t>                           m_inlines{ 0 };
+    std::atomic<int64_t>                            m_sumNs{ 0 };
+    std::atomic<int64_t>                            m_maxNs{ 0 };
+
+    std::array<std::atomic<uint64_t>, Buckets>      m_buckets{};
+};
+
+class EventBusStat {
+
+public:
+
+    static EventBusStat& getInstance() {
+        static EventBusStat instance{};
+        return instance;
+    }
+
+    std::shared_ptr<HopLatency> hop(const std::string& name);
+
+    std::string statInfo();
+
+private:
+
+    EventBusStat() = default;
+
+    std::mutex                                              m_mutex;
+
+    std::map<std::string, std::shared_ptr<HopLatency>>      m_hops{};
+};
+
+template <typename Event, typename Executor>
+class EventChannel : public std::enable_shared_from_this<EventChannel<Event, Executor>> {
+
+public:
+
+    static constexpr size_t BatchSize  = 64;
+
+    static constexpr size_t MaxBatchesPerDrain = 16;   // 单次 drain 上限, 之后重新投递, 避免长期占用消费者线程
+
+    using Handler_t = std::function<void(Event* events, size_t count)>;
+
+    static std::shared_ptr<EventChannel> create(const std::string& hopName, const Executor& executor, Handler_t&& handler) {
+        return std::make_shared<EventChannel>(hopName, executor, std::move(handler));
+    }
+
+    EventChannel(const std::string& hopName, const Executor& executor, Handler_t&& handler)
+        : m_executor(executor)
+        , m_handler(std::move(handler))
+        , m_latency(EventBusStat::getInstance().hop(hopName)) {
+    }
+
+    EventChannel(const EventChannel&) = delete;
+    EventChannel& operator=(const EventChannel&) = delete;
+
+    /* 在消费者线程内且无积压, 调用方可直接处理, 不经队列 */
+    inline bool canRunInline() const {
+        return m_executor.running_in_this_thread() and not m_scheduled.load(std::memory_order_acquire);
+    }
+
+    inline void recordInline() { m_latency->recordInline(); }
+
+    void publish(Event&& event) {
+
+        event.enqueueNs = steadyNowNs();
+
+        m_queue.enqueue(std::move(event));
+
+        _schedule();
+    }
+
+    inline size_t sizeApprox() const { return m_queue.size_approx(); }
+
+private:
+
+    void _schedule() {
+
+        if (not m_scheduled.exchange(true, std::memory_order_acq_rel)) {
+            asio::post(m_executor, [self = this->shared_from_this()]() { self->_drain(); });
+        }
+    }
+
+    void _drain() {
+
+        for (size_t round = 0; round < MaxBatchesPerDrain; ++round) {
+
+            auto count = m_queue.try_dequeue_bulk(m_batch.begin(), BatchSize);
+
+            if (count == 0) {
+                m_scheduled.store(false, std::memory_order_release);
+
+                /* 清标志与生产者入队之间的竞争: 再看一次 */
+                if (m_queue.size_approx() == 0 or m_scheduled.exchange(true, std::memory_order_acq_rel)) {
+                    return;
+                }
+                continue;
+            }
+
+            auto now = steadyNowNs();
+
+            std::array<uint64_t, HopLatency::Buckets> buckets{};
+            int64_t sumNs = 0, maxNs = 0;
+
+            for (size_t i = 0; i < count; ++i) {
+                auto latency = now - m_batch[i].enqueueNs;
+                sumNs += latency;
+                maxNs  = std::max(maxNs, latency);
+                buckets[HopLatency::bucketOf(latency)]++;
+            }
+            m_latency->recordBatch(buckets, count, sumNs, maxNs);
+
+            m_handler(m_batch.data(), count);
+
+            for (size_t i = 0; i < count; ++i) {
+                m_batch[i] = Event{};      // 释放事件持有的引用
+            }
+        }
+
+        /* 仍有积压, 让出线程后继续 */
+        asio::post(m_executor, [self = this->shared_from_this()]() { self->_drain(); });
+    }
+
+    Executor                                m_executor;
+
+    Handler_t                               m_handler;
+
+    std::shared_ptr<HopLatency>             m_latency;
+
+    moodycamel::ConcurrentQueue<Event>      m_queue{ BatchSize * 4 };
+
+    std::atomic<bool>                       m_scheduled{ false };
+
+    std::array<Event, BatchSize>            m_batch{};      // 仅消费者访问
+};
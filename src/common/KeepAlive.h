@@ -6,6 +6,7 @@
 
 #include <jemalloc/jemalloc.h>
 #include <iostream>
+#include "MemoryContainer.h"
 
 struct JemallocAllocator {
     using size_type = std::size_t;          // 表示内存块大小的无符号整数类型
@@ -36,6 +37,15 @@ class KeepAlivePool {
 public:
     std::atomic<uint32_t>  m_refcount{ 0 };
 
+    bool                   m_inArena{ false };      // 分配自 MonotonicArena, 引用归零时只析构不归还内存
+
+    KeepAlivePool() = default;
+
+    /* 拷贝得到的是新对象, 引用计数从 0 开始 */
+    KeepAlivePool(const KeepAlivePool&) {}
+
+    KeepAlivePool& operator=(const KeepAlivePool&) { return *this; }
+
     inline uint32_t retainAlive() {
 
         return m_refcount.fetch_add(1) + 1;
@@ -52,20 +62,48 @@ public:
         }
     }
 
+    /* 按类型的线程缓存 slab 池, 各平台一致 */
+    using Pool_t = SlabPool<T>;
+
     template<typename... TArgs>
     inline static T* create(TArgs&&... mArgs)
     {
-#ifdef _WIN32
-        auto ptr = static_cast<T*>(je_malloc(sizeof(T)));   //static_cast<T*>(SinglePool::malloc());
-#else
-        auto ptr = static_cast<T*>(std::malloc(sizeof(T)));
-#endif
+        auto ptr = static_cast<T*>(Pool_t::allocate());
+        new(ptr) T(std::forward<TArgs>(mArgs)...);
+        ptr->retainAlive();
+        return ptr;
+    }
+
+    /* 在 arena 中创建, refcount 1; arena release 前须已 release */
+    template<typename... TArgs>
+    inline static T* createIn(MonotonicArena& arena, TArgs&&... mArgs)
+    {
+        auto ptr = static_cast<T*>(arena.allocate(sizeof(T), alignof(T)));
         new(ptr) T(std::forward<TArgs>(mArgs)...);
+        ptr->m_inArena = true;
         ptr->retainAlive();
-        totalAliveObjectCount.fetch_add(1);
         return ptr;
     }
 
+    /* 需要在回调之外持有对象时使用: arena 对象拷贝到池中再持有, 其余直接增加引用 */
+    inline static boost::intrusive_ptr<T> keepAlive(T* obj)
+    {
+        if (obj and obj->m_inArena) {
+            return boost::intrusive_ptr<T>(create(*obj), false);
+        }
+        return boost::intrusive_ptr<T>(obj);
+    }
+
+    /* 同 keepAlive; slot 为池对象且仅由 slot 持有时, arena 对象原地拷入复用, 不再逐次分配 */
+    inline static void keepAliveInto(boost::intrusive_ptr<T>& slot, T* obj)
+    {
+        if (obj and obj->m_inArena and slot and slot.get() != obj and not slot->m_inArena and slot->m_refcount.load() == 1) {
+            *slot = *obj;
+            return;
+        }
+        slot = keepAlive(obj);
+    }
+
     friend void intrusive_ptr_add_ref(T* obj) {
         obj->retainAlive();
     }
@@ -78,7 +116,10 @@ public:
 
 public:
 
-    inline static std::atomic<uint64_t> totalAliveObjectCount = 0; 
+    /* 存活对象数, 由各线程计数汇总 */
+    inline static int64_t aliveObjectCount() { return Pool_t::stat().aliveCount; }
+
+    inline static SlabPoolStat poolStat() { return Pool_t::stat(); }
 
 private:
 
@@ -86,14 +127,13 @@ private:
     {
         if (!mObj)
             return;
+        auto inArena = mObj->m_inArena;
+
         mObj->~T();
-        totalAliveObjectCount.fetch_sub(1);
 
-#ifdef _WIN32
-        je_free(mObj);
-#else 
-        std::free(mObj);
-#endif
+        if (not inArena) {
+            Pool_t::deallocate(mObj);
+        }
     }
 
     struct SharedDeleter
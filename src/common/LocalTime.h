@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include "boost/date_time.hpp"
+
+/*
+* 交易所本地时间(北京时间)整数表示: 1970-01-01 00:00:00 本地时刻起的纳秒数
+*   tick 的 created_at(UTC 秒) 只需一次乘加, 不经时区对象及日历换算
+*   按日/时段计算为整数取模, 可直接比较排序
+*   与 ptime 的互转只在需要 ptime 的边界(日志/协议/订单)进行
+*/
+using QuoteNs_t = int64_t;
+
+namespace agcommon {
+
+    namespace qtime {
+
+        constexpr int64_t NsPerUs  = 1'000;
+        constexpr int64_t NsPerMs  = 1'000'000;
+        constexpr int64_t NsPerSec = 1'000'000'000;
+        constexpr int64_t NsPerDay = 86'400 * NsPerSec;
+
+        constexpr int64_t ShanghaiUtcOffsetSec = 8 * 3600;
+
+        constexpr QuoteNs_t MinNs = std::numeric_limits<QuoteNs_t>::min();
+        constexpr QuoteNs_t MaxNs = std::numeric_limits<QuoteNs_t>::max();
+
+        /* created_at(UTC 秒) -> 本地纳秒 */
+        constexpr QuoteNs_t fromUtcSeconds(int64_t utcSeconds) {
+            return (utcSeconds + ShanghaiUtcOffsetSec) * NsPerSec;
+        }
+
+        constexpr QuoteNs_t hms(int h, int m, int s = 0) {
+            return ((h * 60 + m) * 60 + s) * NsPerSec;
+        }
+
+        constexpr int64_t floorDiv(int64_t a, int64_t b) {
+            return a / b - ((a % b != 0) and ((a < 0) != (b < 0)));
+        }
+
+        constexpr QuoteNs_t dayStart(QuoteNs_t ns) { return floorDiv(ns, NsPerDay) * NsPerDay; }
+
+        constexpr QuoteNs_t timeOfDay(QuoteNs_t ns) { return ns - dayStart(ns); }
+
+        constexpr double toSeconds(QuoteNs_t duration) { return static_cast<double>(duration) / NsPerSec; }
+
+        constexpr QuoteNs_t fromSeconds(double secs) { return static_cast<QuoteNs_t>(secs * NsPerSec); }
+
+        inline const boost::posix_time::ptime& epoch() {
+            static const boost::posix_time::ptime e(boost::gregorian::date(1970, 1, 1));
+            return e;
+        }
+
+        /* 微秒精度, 与 ptime 一致 */
+        inline boost::posix_time::ptime toPtime(QuoteNs_t ns) {
+            if (ns == MinNs) {
+                return boost::posix_time::min_date_time;
+            }
+            if (ns == MaxNs) {
+                return boost::posix_time::max_date_time;
+            }
+            return epoch() + boost::posix_time::microseconds(floorDiv(ns, NsPerUs));
+        }
+
+        /* 特殊值及超出 int64 纳秒范围(约 1678~2262 年)的时刻取 MinNs/MaxNs */
+        inline QuoteNs_t fromPtime(const boost::posix_time::ptime& pt) {
+
+            constexpr int64_t LimitUs = MaxNs / NsPerUs;
+
+            if (pt.is_special()) {
+                return pt.is_pos_infinity() ? MaxNs : MinNs;
+            }
+            auto us = (pt - epoch()).total_microseconds();
+            if (us <= -LimitUs) {
+                return MinNs;
+            }
+            if (us >= LimitUs) {
+                return MaxNs;
+            }
+            return us * NsPerUs;
+        }
+
+        /* yyyymmdd, 公历换算只用整数运算 */
+        constexpr uint32_t toDateInt(QuoteNs_t ns) {
+
+            int64_t z   = floorDiv(ns, NsPerDay) + 719468;
+            int64_t era = floorDiv(z, 146097);
+            auto doe = static_cast<uint32_t>(z - era * 146097);
+            auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            auto mp  = (5 * doy + 2) / 153;
+            auto d   = doy - (153 * mp + 2) / 5 + 1;
+            auto m   = mp < 10 ? mp + 3 : mp - 9;
+            auto y   = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+
+            return static_cast<uint32_t>(y * 10000 + m * 100 + d);
+        }
+
+        /* hhmmss */
+        constexpr uint32_t toTimeInt(QuoteNs_t ns) {
+            auto secs = static_cast<uint32_t>(timeOfDay(ns) / NsPerSec);
+            return secs / 3600 * 10000 + secs % 3600 / 60 * 100 + secs % 60;
+        }
+
+        /* yyyymmddhhmmss */
+        constexpr uint64_t toDateTimeInt(QuoteNs_t ns) {
+            return static_cast<uint64_t>(toDateInt(ns)) * 1'000'000 + toTimeInt(ns);
+        }
+    }
+}
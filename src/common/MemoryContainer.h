@@ -2,6 +2,12 @@
 
 #include <stack>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <memory_resource>
+#include "typedefs.h"
 #include "concurrentqueue.h"
 #include <boost/lockfree/queue.hpp>
 #include <boost/pool/singleton_pool.hpp>
@@ -98,6 +104,208 @@ private:
 template <typename T, std::size_t N>
 /*static*/moodycamel::ConcurrentQueue<T*> CocurrentPool<T, N>::pool = moodycamel::ConcurrentQueue<T*>(N);
 
+struct SlabPoolStat {
+
+    int64_t     aliveCount{ 0 };    // 已分配未释放
+
+    int64_t     freeCount { 0 };    // 空闲块: 全局队列 + 各线程缓存
+
+    uint64_t    slabCount { 0 };
+
+    uint64_t    slabBytes { 0 };
+
+    inline std::string to_string() const {
+        return fmt::format("alive:{},free:{},slabs:{},{}MB", aliveCount, freeCount, slabCount, slabBytes / 1024 / 1024);
+    }
+};
+
+/*
+* thread safe. 按类型的 slab 分配器, 基于 CocurrentPool 的全局空闲队列增加线程本地缓存:
+*  分配/释放先走线程本地空闲链表, 无锁无原子 RMW; 本地为空时从全局队列批量取, 再不够则新分配一个 slab;
+*  本地超过 LocalCacheMax 时批量归还一半. 线程退出时本地缓存归还全局
+*  计数按线程记录(仅本线程写), 统计时汇总. slab 不归还系统, 由进程生命周期持有
+*/
+template <typename T, std::size_t SlabObjects = 4096, std::size_t LocalCacheMax = 2048>
+class SlabPool {
+
+public:
+
+    static constexpr std::size_t BlockSize = (std::max(sizeof(T), sizeof(void*)) + alignof(std::max_align_t) - 1)
+        / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    static void* allocate() {
+
+        auto& cache = localCache();
+
+        if (cache.freeList.empty()) {
+            refill(cache);
+        }
+        auto ptr = cache.freeList.back();
+        cache.freeList.pop_back();
+
+        cache.allocs.store(cache.allocs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cache.cached.store(cache.freeList.size(), std::memory_order_relaxed);
+        return ptr;
+    }
+
+    static void deallocate(void* ptr) {
+
+        auto& cache = localCache();
+
+        cache.freeList.push_back(ptr);
+
+        if (cache.freeList.size() > LocalCacheMax) {
+            auto n = cache.freeList.size() / 2;
+            globalFree().enqueue_bulk(cache.freeList.end() - n, n);
+            cache.freeList.resize(cache.freeList.size() - n);
+        }
+
+        cache.frees.store(cache.frees.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cache.cached.store(cache.freeList.size(), std::memory_order_relaxed);
+    }
+
+    static SlabPoolStat stat() {
+
+        auto& reg = registry();
+
+        SlabPoolStat st{};
+        {
+            std::scoped_lock lock(reg.mutex);
+
+            st.aliveCount = reg.retiredAllocs - reg.retiredFrees;
+            for (auto cache : reg.caches) {
+                st.aliveCount += cache->allocs.load(std::memory_order_relaxed) - cache->frees.load(std::memory_order_relaxed);
+                st.freeCount  += cache->cached.load(std::memory_order_relaxed);
+            }
+        }
+        st.freeCount += globalFree().size_approx();
+        st.slabCount  = slabCount().load();
+        st.slabBytes  = st.slabCount * SlabObjects * BlockSize;
+        return st;
+    }
+
+private:
+
+    struct ThreadCache {
+
+        std::vector<void*>      freeList{};
+
+        std::atomic<int64_t>    allocs{ 0 };
+        std::atomic<int64_t>    frees { 0 };
+        std::atomic<int64_t>    cached{ 0 };
+
+        ThreadCache() {
+            freeList.reserve(LocalCacheMax + 1);
+            auto& reg = registry();
+            std::scoped_lock lock(reg.mutex);
+            reg.caches.push_back(this);
+        }
+
+        ~ThreadCache() {
+            if (not freeList.empty()) {
+                globalFree().enqueue_bulk(freeList.begin(), freeList.size());
+            }
+            auto& reg = registry();
+            std::scoped_lock lock(reg.mutex);
+            reg.retiredAllocs += allocs.load();
+            reg.retiredFrees  += frees.load();
+            std::erase(reg.caches, this);
+        }
+    };
+
+    struct Registry {
+        std::mutex                  mutex;
+        std::vector<ThreadCache*>   caches{};
+        int64_t                     retiredAllocs{ 0 };
+        int64_t                     retiredFrees { 0 };
+    };
+
+    static ThreadCache& localCache() {
+        thread_local ThreadCache cache{};
+        return cache;
+    }
+
+    static Registry& registry() {
+        static Registry reg{};
+        return reg;
+    }
+
+    static moodycamel::ConcurrentQueue<void*>& globalFree() {
+        static moodycamel::ConcurrentQueue<void*> pool(SlabObjects);
+        return pool;
+    }
+
+    static std::atomic<uint64_t>& slabCount() {
+        static std::atomic<uint64_t> count{ 0 };
+        return count;
+    }
+
+    static void refill(ThreadCache& cache) {
+
+        constexpr std::size_t batch = LocalCacheMax / 2;
+
+        cache.freeList.resize(batch);
+        auto n = globalFree().try_dequeue_bulk(cache.freeList.begin(), batch);
+        cache.freeList.resize(n);
+
+        if (n > 0) {
+            return;
+        }
+
+        /* 新 slab: 一半留本线程, 其余放入全局队列 */
+        auto memory = static_cast<char*>(::operator new(SlabObjects * BlockSize));
+        slabCount().fetch_add(1);
+
+        std::vector<void*> blocks(SlabObjects);
+        for (std::size_t i = 0; i < SlabObjects; ++i) {
+            blocks[i] = memory + i * BlockSize;
+        }
+        auto keep = std::min(batch, SlabObjects);
+        cache.freeList.assign(blocks.begin(), blocks.begin() + keep);
+        if (SlabObjects > keep) {
+            globalFree().enqueue_bulk(blocks.begin() + keep, SlabObjects - keep);
+        }
+    }
+};
+
+/*
+* not thread safe. 单调分配区: 顺序 bump 分配, 对象不单独归还, release 时整体释放
+* 用于生命周期一致的一批对象(如一次回放中的 MarketDepth)
+*/
+class MonotonicArena {
+
+public:
+
+    explicit MonotonicArena(std::size_t initialBytes = 1 << 20) : m_resource(initialBytes) {}
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    inline void* allocate(std::size_t bytes, std::size_t alignment) {
+        m_bytes += bytes;
+        m_count++;
+        return m_resource.allocate(bytes, alignment);
+    }
+
+    inline void release() {
+        m_resource.release();
+        m_bytes = 0;
+        m_count = 0;
+    }
+
+    inline std::size_t bytes() const { return m_bytes; }
+
+    inline std::size_t count() const { return m_count; }
+
+private:
+
+    std::pmr::monotonic_buffer_resource     m_resource;
+
+    std::size_t                             m_bytes{ 0 };
+
+    std::size_t                             m_count{ 0 };
+};
+
 /*thread safe*/
 template <typename T>
 class BenchmarkPool {
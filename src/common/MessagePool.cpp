@@ -0,0 +1,80 @@
+#include "MessagePool.h"
+
+std::shared_ptr<google::protobuf::Arena> MessagePool::_acquireArena() {
+
+    std::unique_ptr<PooledArena> pooled{ nullptr };
+    {
+        std::scoped_lock lock(m_state->mutex);
+
+        if (not m_state->arenas.empty()) {
+            pooled = std::move(m_state->arenas.back());
+            m_state->arenas.pop_back();
+            m_state->arenaReused++;
+        }
+        else {
+            m_state->arenaCreated++;
+        }
+    }
+    if (not pooled) {
+        pooled = std::make_unique<PooledArena>();
+    }
+
+    auto arena = &pooled->arena;
+
+    return std::shared_ptr<google::protobuf::Arena>(arena, [state = m_state, raw = pooled.release()](google::protobuf::Arena*) {
+
+        std::unique_ptr<PooledArena> pooled{ raw };
+
+        pooled->arena.Reset();      // 析构其上的消息, 保留初始块
+
+        std::scoped_lock lock(state->mutex);
+        if (state->arenas.size() < MaxPooledArenas) {
+            state->arenas.push_back(std::move(pooled));
+        }
+    });
+}
+
+std::shared_ptr<MessagePool::Frame> MessagePool::acquireFrame(size_t size) {
+
+    std::unique_ptr<Frame> frame{ nullptr };
+    {
+        std::scoped_lock lock(m_state->mutex);
+
+        if (not m_state->frames.empty()) {
+            frame = std::move(m_state->frames.back());
+            m_state->frames.pop_back();
+            m_state->frameReused++;
+        }
+        else {
+            m_state->frameCreated++;
+        }
+    }
+    if (not frame) {
+        frame = std::make_unique<Frame>();
+    }
+    frame->resize(size);
+
+    return std::shared_ptr<Frame>(frame.release(), [state = m_state](Frame* raw) {
+
+        std::unique_ptr<Frame> frame{ raw };
+
+        if (frame->capacity() > MaxPooledFrameBytes) {
+            return;
+        }
+        frame->clear();
+
+        std::scoped_lock lock(state->mutex);
+        if (state->frames.size() < MaxPooledFrames) {
+            state->frames.push_back(std::move(frame));
+        }
+    });
+}
+
+std::string MessagePool::to_string() {
+
+    std::scoped_lock lock(m_state->mutex);
+
+    return fmt::format("arena created:{},reused:{},idle:{};frame created:{},reused:{},idle:{}"
+        , m_state->arenaCreated, m_state->arenaReused, m_state->arenas.size()
+        , m_state->frameCreated, m_state->frameReused, m_state->frames.size());
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <google/protobuf/arena.h>
+#include "typedefs.h"
+
+/*
+* 出站消息内存池
+*   - protobuf Arena: 消息在带初始块的 Arena 上创建, shared_ptr 以别名方式持有 Arena,
+*     最后一个引用释放时 Reset 并归还, 复用后初始块内的消息不再分配堆内存
+*   - 发送帧: 4 字节长度头 + MessagePkg, 序列化一次后由各会话共享, 释放时保留容量归还
+*   池状态由 shared_ptr 持有, 进程退出时晚于池释放的引用仍可安全归还
+*/
+class MessagePool {
+
+public:
+
+    using Frame = std::vector<unsigned char>;
+
+    static constexpr size_t ArenaInitialBlockSize = 1024;
+
+    static constexpr size_t MaxPooledArenas       = 1024;
+
+    static constexpr size_t MaxPooledFrames       = 1024;
+
+    static constexpr size_t MaxPooledFrameBytes   = 64 * 1024;     // 更大的帧用完即释放
+
+    static MessagePool& getInstance() {
+        static MessagePool instance{};
+        return instance;
+    }
+
+    /* T 在池化 Arena 上创建, 返回的 shared_ptr 共享 Arena 的生命周期 */
+    template <typename T>
+    std::shared_ptr<T> create() {
+        auto arenaPtr = _acquireArena();
+        auto msg      = google::protobuf::Arena::CreateMessage<T>(arenaPtr.get());
+        return std::shared_ptr<T>(std::move(arenaPtr), msg);
+    }
+
+    /* size 字节的帧, 内容未初始化 */
+    std::shared_ptr<Frame> acquireFrame(size_t size);
+
+    std::string to_string();
+
+private:
+
+    struct PooledArena {
+
+        std::unique_ptr<char[]>     initialBlock{ new char[ArenaInitialBlockSize] };
+
+        google::protobuf::Arena     arena{ initialBlock.get(), ArenaInitialBlockSize };
+    };
+
+    struct State {
+
+        std::mutex                                  mutex;
+
+        std::vector<std::unique_ptr<PooledArena>>   arenas{};
+
+        std::vector<std::unique_ptr<Frame>>         frames{};
+
+        uint64_t    arenaCreated{ 0 };
+        uint64_t    arenaReused{ 0 };
+        uint64_t    frameCreated{ 0 };
+        uint64_t    frameReused{ 0 };
+    };
+
+    MessagePool() = default;
+
+    std::shared_ptr<google::protobuf::Arena> _acquireArena();
+
+    std::shared_ptr<State>  m_state{ std::make_shared<State>() };
+};
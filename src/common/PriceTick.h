@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+/*
+* 定点价格: 以最小变动价位(price_tick)为单位的整数
+*   盘口档位比较/撮合判断为整数运算, 不受 float 行情转 double 的误差影响
+*   金额/均价等连续量仍用 double, 只在边界处换算
+*/
+using PriceTicks_t = int32_t;
+
+namespace agcommon {
+
+    class PriceTick {
+
+    public:
+
+        /* tickSize 未知(<=0)时取 0.001, 可表示全部 A 股价格 */
+        static constexpr double FinestTickSize = 0.001;
+
+        constexpr PriceTick() = default;
+
+        explicit PriceTick(double tickSize) {
+            if (tickSize > 0.0) {
+                m_tickSize = tickSize;
+                m_ticksPerUnit = std::round(1.0 / tickSize);
+            }
+        }
+
+        /* SecurityStaticInfo 无 price_tick 时的缺省规则, 未知交易所返回 0 */
+        static double defaultTickSize(const std::string& symbol) {
+            if (symbol.ends_with("SZ")) {
+                return (symbol.starts_with("0") or symbol.starts_with("2") or symbol.starts_with("3")) ? 0.01 : 0.001;
+            }
+            if (symbol.ends_with("SH")) {
+                return symbol.starts_with("6") ? 0.01 : 0.001;
+            }
+            return 0.0;
+        }
+
+        static PriceTick ofSymbol(const std::string& symbol) { return PriceTick(defaultTickSize(symbol)); }
+
+        inline PriceTicks_t toTicks(double price) const {
+            return static_cast<PriceTicks_t>(std::llround(price * m_ticksPerUnit));
+        }
+
+        /* 整数除法结果为最接近的 double, 与 roundPrice 一致 */
+        inline double toPrice(PriceTicks_t ticks) const { return ticks / m_ticksPerUnit; }
+
+        inline double tickSize() const { return m_tickSize; }
+
+    private:
+
+        double  m_tickSize{ FinestTickSize };
+
+        double  m_ticksPerUnit{ 1000.0 };
+    };
+}
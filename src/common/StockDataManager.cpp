@@ -3,6 +3,11 @@
 #include <highfive/highfive.hpp>
 
 #include "Configs.h"
+#include "ReplayTickStore.h"
+#include "ContextService.h"
+#include "TickCache.h"
+#include "TickSnapshot.h"
+#include <latch>
 
 std::string symbolH5Key(const std::string& symbol) {
     if (symbol.ends_with("SZ")) {
@@ -693,21 +698,163 @@ const Time2Symbol2MinuteBarMap& StockDataManager::cacheMinuteBar(const int trade
 
 }
 
-/* use hdf5[threadsafe],so is threadsafe */
+namespace {
+
+    struct TickLoadItem {
+
+        Symbol_t    symbol{};
+
+        uint32_t    symbolIdx{ 0 };
+
+        uint32_t    seriesIdx{ 0 };
+
+        float       preClose{ 0 };
+
+        int64_t     shareCirc{ 0 };
+    };
+
+    /* 一个交易日内的一组 symbol, 由一个 loader 线程读取 */
+    struct TickLoadTask {
+
+        uint32_t            tradeDate{ 0 };
+
+        std::string         filePath{};     // h5, 无 h5 时为空
+
+        std::shared_ptr<TickSnapshotFile>   snapshotPtr{ nullptr };
+
+        QuoteNs_t           mc{ 0 };    // 午间休市区间
+        QuoteNs_t           ao{ 0 };
+
+        std::vector<TickLoadItem>       items{};
+
+        std::vector<ReplayTickRecord>   records{};
+
+        std::chrono::steady_clock::time_point begin{};
+        std::chrono::steady_clock::time_point end{};
+    };
+
+    int32_t getTickLoadThreads() {
+
+        auto threads = agcommon::Configs::getConfigs().getConfigOrDefault("DATACONFIG", "H5LoadThreads", 0);
+
+        if (threads <= 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+        }
+        return threads;
+    }
+}
+
+std::shared_ptr<TickSnapshotFile> StockDataManager::getTickSnapshot(const uint32_t trade_dt) {
+
+    std::scoped_lock<std::mutex> lock(m_mutex);
+
+    if (auto it = date2TickSnapshot.find(trade_dt); it != date2TickSnapshot.end()) {
+        if (auto snapshotPtr = it->second.lock()) {
+            return snapshotPtr;
+        }
+    }
+
+    auto snapshotPtr = TickSnapshotFile::open(TickSnapshotFile::snapshotPath(agcommon::Configs::getConfigs().getTickH5Dir(), trade_dt));
+
+    if (snapshotPtr) {
+        date2TickSnapshot[trade_dt] = snapshotPtr;
+        SPDLOG_INFO("map tick snapshot {},ticks:{},bytes:{}", trade_dt, snapshotPtr->tickCount(), snapshotPtr->byteSize());
+    }
+    return snapshotPtr;
+}
+
+std::unordered_map<Symbol_t, uint64_t> StockDataManager::getSymbolTickCounts(const std::unordered_set<Symbol_t>& symbols
+    , const uint32_t trade_dt
+    , TickCountSource& source) {
+
+    std::unordered_map<Symbol_t, uint64_t> symbol2Count{};
+    symbol2Count.reserve(symbols.size());
+
+    if (auto snapshotPtr = getTickSnapshot(trade_dt)) {
+        for (auto& symbol : symbols) {
+            if (auto count = snapshotPtr->tickCountOf(symbol); count > 0) {
+                symbol2Count.emplace(symbol, count);
+            }
+        }
+        source = TickCountSource::Snapshot;
+        return symbol2Count;
+    }
+
+    /* 与 cacheFromH5TickWindow 相同的文件匹配: Tick*{yyyymmdd}.h5 */
+    std::filesystem::path h5Path{};
+    std::error_code ec;
+    auto dtStr = std::to_string(trade_dt);
+
+    for (const auto& file : std::filesystem::directory_iterator(agcommon::Configs::getConfigs().getTickH5Dir(), ec)) {
+        auto fileName = file.path().filename().string();
+        if (file.is_regular_file() and fileName.starts_with("Tick") and fileName.ends_with(".h5") and file.path().stem().string().ends_with(dtStr)) {
+            h5Path = file.path();
+            break;
+        }
+    }
+
+    if (not h5Path.empty()) {
+        try {
+            /* 只读 dataset 维度, 不读数据 */
+            HighFive::File file(h5Path.string(), HighFive::File::ReadOnly);
+            for (auto& symbol : symbols) {
+                auto dataSetName = symbolH5Key(symbol);
+                if (not file.exist(dataSetName)) {
+                    continue;
+                }
+                auto dims = file.getDataSet(dataSetName).getDimensions();
+                if (not dims.empty() and dims[0] > 0) {
+                    symbol2Count.emplace(symbol, dims[0]);
+                }
+            }
+            source = TickCountSource::H5;
+            return symbol2Count;
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("read tick dims {} failed:{}", h5Path.string(), e.what());
+            symbol2Count.clear();
+        }
+    }
+
+    for (auto& [symbol, bar] : getDailyBarBlock(trade_dt, symbols)) {
+        if (bar and bar->volume > 0) {
+            symbol2Count.emplace(symbol, static_cast<uint64_t>(bar->volume));
+        }
+    }
+    source = symbol2Count.empty() ? TickCountSource::None : TickCountSource::DailyBar;
+    return symbol2Count;
+}
+
+std::pair<QuoteTime_t, QuoteTime_t> StockDataManager::getTickLoadRange(const QuoteTime_t& startTime, const QuoteTime_t& endTime) {
+
+    auto marketCloseAuctionBeginTime = agcommon::AshareMarketTime::getClosingCallAuctionBeginTime(endTime);
+
+    auto addOnSeconds  = endTime > marketCloseAuctionBeginTime ? 185 : 30;
+
+    /* addMarketDuration 限制在当日开收盘之间, 不会跨日 */
+    return { agcommon::AshareMarketTime::addMarketDuration(startTime, -30)
+        , agcommon::AshareMarketTime::addMarketDuration(endTime, addOnSeconds) };
+}
+
 size_t StockDataManager::cacheFromH5Tick(const std::unordered_set<Symbol_t>& symbols
     , const QuoteTime_t& startTime
     , const QuoteTime_t& endTime
-    , std::map<QuoteTime_t, UnorderMarketDepthRawPtrMap>& quoteTime2Symbol2md)
+    , ReplayTickStore& tickStore)
 {
-    auto marketCloseAuctionBeginTime = agcommon::AshareMarketTime::getClosingCallAuctionBeginTime(endTime);
-    std::string startDateStr = agcommon::geISODateStr(startTime); //yyyymmdd
-    std::string endDateStr   = agcommon::geISODateStr(endTime);
-
-    auto addOnSeconds  = endTime > marketCloseAuctionBeginTime ? 185 : 30;
+    auto [loadBeg, loadEnd] = getTickLoadRange(startTime, endTime);
 
-    auto startTime_30 = agcommon::AshareMarketTime::addMarketDuration(startTime, -30);
+    return cacheFromH5TickWindow(symbols, loadBeg, loadEnd, tickStore);
+}
 
-    auto endTime_30   = agcommon::AshareMarketTime::addMarketDuration(endTime, addOnSeconds);
+/* use hdf5[threadsafe],so is threadsafe. (day, symbol) 分块并行读取, 每个任务独立 file handle 及输出
+*  有 Tick{yyyymmdd}.tks 快照时优先映射快照(零拷贝), 快照中没有的 symbol 再读 h5 */
+size_t StockDataManager::cacheFromH5TickWindow(const std::unordered_set<Symbol_t>& symbols
+    , const QuoteTime_t& startTime_30
+    , const QuoteTime_t& endTime_30
+    , ReplayTickStore& tickStore)
+{
+    std::string startDateStr = agcommon::geISODateStr(startTime_30); //yyyymmdd
+    std::string endDateStr   = agcommon::geISODateStr(endTime_30);
 
     auto tickH5FilePath = agcommon::Configs::getConfigs().getTickH5Dir();
 
@@ -717,95 +864,242 @@ size_t StockDataManager::cacheFromH5Tick(const std::unordered_set<Symbol_t>& sym
         return 0;
     }
 
-    auto dir = std::filesystem::directory_iterator(tickH5FilePath);
+    std::map<std::string, std::string> dt2File{};
 
-    size_t totalLines = 0;
-    std::vector<h5data::Tick> ticks(5000);
-    auto files = std::filesystem::directory_iterator(dir);
-
-    for (const auto& file : files)
+    for (const auto& file : std::filesystem::directory_iterator(tickH5FilePath))
     {
-        auto fileNameWithPath = file.path().string();
         auto fileName = file.path().filename().string();
-        if (fileName.size() < 11) {
+        auto stem     = file.path().stem().string();
+        if (stem.size() < 12 or not file.is_regular_file() or not fileName.starts_with("Tick")) {
             continue;
         }
-        auto dt = fileName.substr(fileName.size() - 11).substr(0, 8);
+        auto dt = stem.substr(stem.size() - 8);
 
-        if (file.is_regular_file() and fileName.ends_with(".h5") and fileName.starts_with("Tick") and dt >= startDateStr and dt <= endDateStr)
-        {
+        if (dt < startDateStr or dt > endDateStr) {
+            continue;
+        }
+        if (fileName.ends_with(".h5")) {
+            dt2File[dt] = file.path().string();
+        }
+        else if (fileName.ends_with(".tks")) {
+            dt2File.try_emplace(dt, "");
+        }
+    }
+
+    auto toCreatedAt = [](const QuoteTime_t& qt) {
+        return static_cast<uint32_t>((qt - boost::posix_time::hours(8) - boost::posix_time::from_time_t(0)).total_seconds());
+    };
+
+    const auto numThreads = getTickLoadThreads();
+
+    std::vector<TickLoadTask> tasks{};
+
+    for (const auto& [dt, filePath] : dt2File) {
 
-            HighFive::File pfile(fileNameWithPath, HighFive::File::ReadOnly);
+        auto tmp = agcommon::parseDateTimeStr(dt + "T093000");
+        if (not tmp) {
+            continue;
+        }
+        auto& refTime = *tmp;
+        auto mc = agcommon::AshareMarketTime::getMarketMorningCloseTime(refTime);
+        auto ao = agcommon::AshareMarketTime::getMarketAfternoonOpenTime(refTime);
+
+        auto dtint   = agcommon::get_int(dt);
+        auto ssinfos = getSecurityBlockInfo(dtint);
+
+        auto snapshotPtr = getTickSnapshot(dtint);
+        if (not snapshotPtr and filePath.empty()) {
+            continue;
+        }
+
+        std::vector<TickLoadItem> dayItems{};
+        dayItems.reserve(symbols.size());
+
+        for (auto& symbol : symbols) {
 
-            auto tmp = agcommon::parseDateTimeStr(dt + "T093000");
-            if (not tmp) {
+            auto ssinfo_it = ssinfos.find(symbol);
+            if (ssinfo_it == ssinfos.end()) {
                 continue;
             }
-            auto& refTime = *tmp;
-            auto mo = agcommon::AshareMarketTime::getOpeningCallAuctionBeginTime(refTime);
-            auto mc = agcommon::AshareMarketTime::getMarketMorningCloseTime(refTime);
-            auto ao = agcommon::AshareMarketTime::getMarketAfternoonOpenTime(refTime);
-            auto ac = agcommon::AshareMarketTime::getMarketCloseTime(refTime);
+            auto& ssinfo = ssinfo_it->second;
+            auto symbolIdx = tickStore.addSymbol(symbol);
+            tickStore.setPriceTick(symbolIdx, ssinfo->tickSize);
+            dayItems.push_back(TickLoadItem{ symbol, symbolIdx, tickStore.addSeriesSlot()
+                , static_cast<float>(ssinfo->preClosePrice), ssinfo->unLAShare });
+        }
 
-            //SPDLOG_INFO("{},{},{},{}", agcommon::getDateTimeStr(mo), agcommon::getDateTimeStr(mc), agcommon::getDateTimeStr(ao), agcommon::getDateTimeStr(ac));
-            auto dtint   = agcommon::get_int(dt);
-            auto ssinfos = getSecurityBlockInfo(dtint);
+        if (dayItems.empty()) {
+            continue;
+        }
 
-            for (auto& symbol : symbols) {
+        auto chunkSize = (dayItems.size() + numThreads - 1) / numThreads;
 
-                auto ssinfo_it = ssinfos.find(symbol);
-                if (ssinfo_it == ssinfos.end()) {
-                    continue;
-                }
-                auto& ssinfo = ssinfo_it->second;
-                auto dataSetName = symbolH5Key(symbol);
+        for (size_t beg = 0; beg < dayItems.size(); beg += chunkSize) {
 
-                if (not pfile.exist(dataSetName)) {
-                    SPDLOG_WARN("dataset not exist {},{}", dt, dataSetName);
-                    continue;
-                }
+            auto& task = tasks.emplace_back();
+            task.tradeDate = dtint;
+            task.filePath  = filePath;
+            task.snapshotPtr = snapshotPtr;
+            task.mc = agcommon::qtime::fromPtime(mc);
+            task.ao = agcommon::qtime::fromPtime(ao);
+            task.items.assign(dayItems.begin() + beg, dayItems.begin() + std::min(beg + chunkSize, dayItems.size()));
+        }
+    }
 
-                auto dataset = pfile.getDataSet(dataSetName);
-                std::vector<size_t> dims = dataset.getDimensions();
+    if (tasks.empty()) {
+        SPDLOG_INFO("read Tick {} symbols:{}-{},no data file", symbols.size(), startDateStr, endDateStr);
+        return 0;
+    }
 
-                dataset.read<std::vector<h5data::Tick>>(ticks);
-                SPDLOG_DEBUG("file:{},dataSet:{},date:{},length:{},closePrice:{:.3f}", fileName, dataSetName, dt, dims[0], ssinfo->preClosePrice);
+    auto loaderContextPtr = ContextService::getInstance().createContext("H5TickLoader", numThreads);
 
-                for (const auto& tick : ticks) {
-                    auto quoteTime = agcommon::AshareMarketTime::convert2ShanghaiTZ(tick.created_at);
-                    if (quoteTime > startTime_30 and quoteTime < endTime_30) {
-                        if (quoteTime > mc and quoteTime < ao) {
-                            continue;
-                        }
-                        auto md = MarketDepth::create(&tick, ssinfo->preClosePrice, ssinfo->unLAShare);
+    /* stage 1: 各任务通过 TickCache 取 (day, symbol) 序列, 未命中才打开 h5 读取; 索引写入独立的 records */
+    std::latch readDone(tasks.size());
+
+    /* 逐 tick 过滤只做整数比较 */
+    const auto startNs_30 = agcommon::qtime::fromPtime(startTime_30);
+    const auto endNs_30   = agcommon::qtime::fromPtime(endTime_30);
+
+    for (auto& task : tasks) {
+
+        asio::post(*loaderContextPtr, [&task, &tickStore, &readDone, &startTime_30, &endTime_30, startNs_30, endNs_30, &toCreatedAt]() {
+
+            task.begin = std::chrono::steady_clock::now();
+
+            std::optional<HighFive::File> pfile{};
+
+            if (task.snapshotPtr and task.snapshotPtr->symbolCount() > 0) {
+                auto dayTicks = task.snapshotPtr->countTicksBetween(toCreatedAt(startTime_30), toCreatedAt(endTime_30));
+                task.records.reserve(dayTicks * task.items.size() / task.snapshotPtr->symbolCount());
+            }
+
+            /* 单个 (day, symbol) 读取失败只跳过该项, 不影响同一任务内其余 symbol */
+            for (const auto& item : task.items) {
 
-                        auto [qit, qInserted] = quoteTime2Symbol2md.try_emplace(md->quoteTime);
+                TickSeriesPtr seriesPtr = nullptr;
+                try {
+                    seriesPtr = TickCache::getInstance().getOrLoad(task.tradeDate, item.symbol, [&]() -> TickSeriesPtr {
 
-                        auto& symbol2md = qit->second;
+                        auto series = std::make_shared<TickSeries>();
+                        series->tradeDate = task.tradeDate;
+                        series->symbol    = item.symbol;
+                        series->preClose  = item.preClose;
+                        series->shareCirc = item.shareCirc;
 
-                        if (qInserted) {
-                            symbol2md.reserve(symbols.size() / 8);
+                        if (task.snapshotPtr) {
+                            if (auto ticks = task.snapshotPtr->getTicks(item.symbol); not ticks.empty()) {
+                                series->ticks       = ticks;
+                                series->snapshotPtr = task.snapshotPtr;
+                                return series;
+                            }
+                        }
+                        if (task.filePath.empty()) {
+                            return nullptr;
+                        }
+                        if (not pfile) {
+                            pfile.emplace(task.filePath, HighFive::File::ReadOnly);
                         }
-                        auto [sit,mdInserted] = symbol2md.try_emplace(symbol, md);
-                        if (mdInserted) {
-                            ++totalLines;
+                        auto dataSetName = symbolH5Key(item.symbol);
+
+                        if (not pfile->exist(dataSetName)) {
+                            SPDLOG_WARN("dataset not exist {},{}", task.tradeDate, dataSetName);
+                            return nullptr;
                         }
-                        else {
-                            SPDLOG_WARN("double tick:, {},{}", symbol, agcommon::getDateTimeInt(md->quoteTime));
+
+                        pfile->getDataSet(dataSetName).read<std::vector<h5data::Tick>>(series->storage);
+                        series->storage.shrink_to_fit();
+                        series->ticks = series->storage;
+
+                        return series;
+                    });
+                }
+                catch (const std::exception& e) {
+                    SPDLOG_ERROR("read Tick {} {} failed:{}", task.filePath, item.symbol, e.what());
+                    continue;
+                }
+
+                if (not seriesPtr) {
+                    continue;
+                }
+
+                tickStore.setSeries(item.seriesIdx, seriesPtr);
+
+                for (const auto& tick : seriesPtr->ticks) {
+                    auto quoteNs = agcommon::qtime::fromUtcSeconds(tick.created_at);
+                    if (quoteNs > startNs_30 and quoteNs < endNs_30) {
+                        if (quoteNs > task.mc and quoteNs < task.ao) {
+                            continue;
                         }
-                     
+                        task.records.push_back(ReplayTickRecord{ tick.created_at, item.symbolIdx, item.seriesIdx, &tick });
                     }
                 }
+            }
+            task.end = std::chrono::steady_clock::now();
+
+            readDone.count_down();
+        });
+    }
 
-                ticks.clear();
+    readDone.wait();
+
+    /* stage 2: 按交易日合并并排序, 各交易日并行, 之后按日期顺序拼接, seal 时无需再全量排序 */
+    std::map<uint32_t, std::vector<TickLoadTask*>> date2Tasks{};
+    for (auto& task : tasks) {
+        date2Tasks[task.tradeDate].push_back(&task);
+    }
+
+    std::vector<std::vector<ReplayTickRecord>> dayRecords(date2Tasks.size());
+
+    std::latch sortDone(date2Tasks.size());
+
+    size_t dayIdx = 0;
+    for (auto& [tradeDate, dayTasks] : date2Tasks) {
+
+        asio::post(*loaderContextPtr, [&records = dayRecords[dayIdx++], tradeDate, &dayTasks, &sortDone]() {
+
+            agcommon::TimeCost tc(std::format("[H5TickLoader]{}", tradeDate), "", false);
+
+            size_t lines = 0;
+            for (auto taskPtr : dayTasks) {
+                lines += taskPtr->records.size();
+                tc.start = std::min(tc.start, taskPtr->begin);
             }
-        }
+            records.reserve(lines);
+            for (auto taskPtr : dayTasks) {
+                records.insert(records.end(), taskPtr->records.begin(), taskPtr->records.end());
+                std::vector<ReplayTickRecord>().swap(taskPtr->records);
+            }
+            std::sort(records.begin(), records.end(), ReplayTickStore::tickOrder);
+
+            tc.timeAt();
+            tc.logTimeCost(fmt::format("tasks:{},lines:{}", dayTasks.size(), lines));
+
+            sortDone.count_down();
+        });
     }
 
-    SPDLOG_INFO("read Tick {} symbols:{}-{},lines:{}"
+    sortDone.wait();
+
+    size_t totalLines = 0;
+    for (const auto& records : dayRecords) {
+        totalLines += records.size();
+    }
+    tickStore.reserve(totalLines);
+    for (auto& records : dayRecords) {
+        tickStore.append(std::move(records));
+    }
+
+    totalLines = tickStore.seal();
+
+    SPDLOG_INFO("read Tick {} symbols:{}-{},days:{},tasks:{},threads:{},lines:{},timestamps:{},cache:{}"
         , symbols.size()
         , agcommon::getDateTimeStr(startTime_30), agcommon::getDateTimeStr(endTime_30)
+        , date2Tasks.size()
+        , tasks.size()
+        , numThreads
         , totalLines
+        , tickStore.timeSize()
+        , TickCache::getInstance().statInfo()
         );
 
     return totalLines;
@@ -827,6 +1121,9 @@ size_t StockDataManager::cacheFromH5Tick(const std::unordered_set<Symbol_t>& sym
 
     auto endTime_30   = agcommon::AshareMarketTime::addMarketDuration(endTime, addOnSeconds);
 
+    const auto startNs_30 = agcommon::qtime::fromPtime(startTime_30);
+    const auto endNs_30   = agcommon::qtime::fromPtime(endTime_30);
+
     auto tickH5FilePath = agcommon::Configs::getConfigs().getTickH5Dir();
 
     if (not std::filesystem::exists(tickH5FilePath)) {
@@ -865,6 +1162,8 @@ size_t StockDataManager::cacheFromH5Tick(const std::unordered_set<Symbol_t>& sym
                 auto mc = agcommon::AshareMarketTime::getMarketMorningCloseTime(refTime);
                 auto ao = agcommon::AshareMarketTime::getMarketAfternoonOpenTime(refTime);
                 auto ac = agcommon::AshareMarketTime::getMarketCloseTime(refTime);
+                const auto mcNs = agcommon::qtime::fromPtime(mc);
+                const auto aoNs = agcommon::qtime::fromPtime(ao);
                 //SPDLOG_INFO("{},{},{},{}", agcommon::getDateTimeStr(mo), agcommon::getDateTimeStr(mc), agcommon::getDateTimeStr(ao), agcommon::getDateTimeStr(ac));
                 auto dtint = agcommon::get_int(dt);
                 auto ssinfos = getSecurityBlockInfo(dtint);
@@ -889,11 +1188,12 @@ size_t StockDataManager::cacheFromH5Tick(const std::unordered_set<Symbol_t>& sym
                     SPDLOG_DEBUG("file:{},dataSet:{},date:{},length:{},closePrice:{:.3f}", fileName, dataSetName, dt, dims[0], ssinfo->preClosePrice);
 
                     for (const auto& tick : ticks) {
-                        auto quoteTime = agcommon::AshareMarketTime::convert2ShanghaiTZ(tick.created_at);
-                        if (quoteTime > startTime_30 and quoteTime < endTime_30) {
-                            if (quoteTime > mc and quoteTime < ao) {
+                        auto quoteNs = agcommon::qtime::fromUtcSeconds(tick.created_at);
+                        if (quoteNs > startNs_30 and quoteNs < endNs_30) {
+                            if (quoteNs > mcNs and quoteNs < aoNs) {
                                 continue;
                             }
+                            auto quoteTime = agcommon::qtime::toPtime(quoteNs);
                             const auto tickPtr = &tick;
                             auto it = quoteTime2Symbol2md.find(quoteTime);
                             if (it == quoteTime2Symbol2md.end()) {
@@ -7,6 +7,10 @@
 #include "H5DataTypes.h"
 #include "MarketDepth.h"
 
+class ReplayTickStore;
+
+class TickSnapshotFile;
+
 
 using SecurityInfoHashMap = std::unordered_map<Symbol_t, std::shared_ptr<SecurityStaticInfo>>;
 
@@ -18,6 +22,13 @@ using Time2Symbol2MinuteBarMap = std::map<QuoteTime_t, std::unordered_map<Symbol
 
 std::string symbolH5Key(const std::string& symbol);
 
+enum class TickCountSource {
+    None,
+    Snapshot,       // Tick{yyyymmdd}.tks 目录
+    H5,             // Tick{yyyymmdd}.h5 dataset 维度
+    DailyBar        // 日线成交量, 非 tick 数, 只能做相对比较
+};
+
 class StockDataManager {
 
 public:
@@ -65,10 +76,28 @@ public:
     const Time2Symbol2MinuteBarMap& getMinuteBar(const uint32_t trade_dt);
 
     /*Tick*/
+    // Tick{yyyymmdd}.tks 快照映射, 不存在返回 nullptr
+    std::shared_ptr<TickSnapshotFile> getTickSnapshot(const uint32_t trade_dt);
+
+    // 各 symbol 当日 tick 数估计, 用于回测任务成本; 依次取快照目录/h5 dataset 维度/日线成交量, 取不到的 symbol 不在结果中
+    std::unordered_map<Symbol_t, uint64_t> getSymbolTickCounts(const std::unordered_set<Symbol_t>& symbols
+        , const uint32_t trade_dt
+        , TickCountSource& source);
+
+    // 回放加载区间: 起点前移 30s, 终点后移 30s(收盘集合竞价后 185s), 开区间
+    static std::pair<QuoteTime_t, QuoteTime_t> getTickLoadRange(const QuoteTime_t& startTime, const QuoteTime_t& endTime);
+
     size_t cacheFromH5Tick(const std::unordered_set<Symbol_t>& symbol
         , const QuoteTime_t& startTime
         , const QuoteTime_t& endTime
-        , std::map<QuoteTime_t, UnorderMarketDepthRawPtrMap>& quoteTime2Symbol2md
+        , ReplayTickStore& tickStore
+    );
+
+    // 按 getTickLoadRange 得到的开区间 (loadBeg, loadEnd) 加载, 流式回放按窗口调用
+    size_t cacheFromH5TickWindow(const std::unordered_set<Symbol_t>& symbol
+        , const QuoteTime_t& loadBeg
+        , const QuoteTime_t& loadEnd
+        , ReplayTickStore& tickStore
     );
 
     size_t cacheFromH5Tick(const std::unordered_set<Symbol_t>& symbol
@@ -100,6 +129,8 @@ private:
 
     std::unordered_map<int, Time2Symbol2MinuteBarMap>   date2Time2MinuteBars{};
 
+    std::unordered_map<uint32_t, std::weak_ptr<TickSnapshotFile>> date2TickSnapshot{};
+
     inline std::pair<int32_t,int32_t> getIndexName2Tag(const std::string& indexName) {
         auto index_tag = -1;
         auto size_hint = 0;
@@ -15,21 +15,6 @@ SecurityStaticInfo::SecurityStaticInfo(const Symbol_t& _symbol) :
     }
 
     if (tickSize == 0.0) {
-        if (symbol.ends_with("SZ")) {
-            if (symbol.substr(0, 1) == "0" || symbol.substr(0, 1) == "2" || symbol.substr(0, 1) == "3") {
-                tickSize = 0.01;
-            }
-            else {
-                tickSize = 0.001;
-            }
-        }
-        if (symbol.ends_with("SH")) {
-            if (symbol.substr(0, 1) == "6") {
-                tickSize = 0.01;
-            }
-            else {
-                tickSize = 0.001;
-            }
-        }
+        tickSize = agcommon::PriceTick::defaultTickSize(symbol);
     }
 }
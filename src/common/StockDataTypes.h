@@ -1,6 +1,7 @@
 #pragma once
 
 #include "typedefs.h"
+#include "PriceTick.h"
 #include <boost/unordered_map.hpp>
 
 struct DailyBar {
@@ -98,6 +99,9 @@ public:
             return 0.0;
         }
     }
+
+    inline agcommon::PriceTick priceTick() const { return agcommon::PriceTick(tickSize); }
+
     inline std::string getIndexBelongName() const {
 
         if (belongIndex == 1) {
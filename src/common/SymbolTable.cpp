@@ -0,0 +1,43 @@
+#include "SymbolTable.h"
+
+SymbolId_t SymbolTable::intern(const Symbol_t& symbol) {
+    {
+        std::shared_lock lock(m_mutex);
+        if (auto it = m_symbol2Id.find(symbol); it != m_symbol2Id.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock(m_mutex);
+
+    if (auto it = m_symbol2Id.find(symbol); it != m_symbol2Id.end()) {
+        return it->second;
+    }
+
+    auto symbolId = m_size.load(std::memory_order_relaxed);
+    if (symbolId >= ChunkSize * MaxChunks) {
+        SPDLOG_CRITICAL("SymbolTable full:{}", symbolId);
+        throw std::length_error("SymbolTable full");
+    }
+
+    auto& chunk = m_chunks[symbolId >> ChunkBits];
+    if (chunk.load(std::memory_order_relaxed) == nullptr) {
+        chunk.store(new Symbol_t[ChunkSize], std::memory_order_release);      // 进程内常驻, 不释放
+    }
+    chunk.load(std::memory_order_relaxed)[symbolId & (ChunkSize - 1)] = symbol;
+
+    m_symbol2Id.emplace(symbol, static_cast<SymbolId_t>(symbolId));
+    m_size.store(symbolId + 1, std::memory_order_release);
+
+    return static_cast<SymbolId_t>(symbolId);
+}
+
+SymbolId_t SymbolTable::find(const Symbol_t& symbol) const {
+
+    std::shared_lock lock(m_mutex);
+
+    if (auto it = m_symbol2Id.find(symbol); it != m_symbol2Id.end()) {
+        return it->second;
+    }
+    return InvalidSymbolId;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <deque>
+#include <shared_mutex>
+#include "typedefs.h"
+
+constexpr SymbolId_t InvalidSymbolId = std::numeric_limits<SymbolId_t>::max();
+
+/*
+* 进程内 symbol 表: 代码字符串 -> 稠密 SymbolId, 只增不删
+*   热路径以 SymbolId 为键, 字符串只在 protobuf/TCP 边界及日志使用
+*   intern 加锁; name 无锁, 分块存放, 已分配的字符串地址不变
+*/
+class SymbolTable {
+
+public:
+
+    static SymbolTable& getInstance() {
+        static SymbolTable instance{};
+        return instance;
+    }
+
+    static constexpr size_t ChunkBits  = 12;
+    static constexpr size_t ChunkSize  = size_t(1) << ChunkBits;
+    static constexpr size_t MaxChunks  = 1024;         // 上限 4M 个 symbol
+
+    SymbolId_t intern(const Symbol_t& symbol);
+
+    /* 未登记返回 InvalidSymbolId */
+    SymbolId_t find(const Symbol_t& symbol) const;
+
+    inline const Symbol_t& name(SymbolId_t symbolId) const {
+        assert(symbolId < size());
+        return m_chunks[symbolId >> ChunkBits].load(std::memory_order_acquire)[symbolId & (ChunkSize - 1)];
+    }
+
+    inline size_t size() const { return m_size.load(std::memory_order_acquire); }
+
+private:
+
+    SymbolTable() = default;
+
+    mutable std::shared_mutex                       m_mutex;
+
+    std::unordered_map<Symbol_t, SymbolId_t>        m_symbol2Id{};
+
+    std::array<std::atomic<Symbol_t*>, MaxChunks>   m_chunks{};
+
+    std::atomic<size_t>                             m_size{ 0 };
+};
+
+/* 按 SymbolId 下标存放的逐 symbol 状态; deque 扩容不移动已有元素, 引用保持有效 */
+template <typename T>
+class SymbolVector {
+
+public:
+
+    inline T& operator[](SymbolId_t symbolId) {
+        assert(symbolId != InvalidSymbolId);
+        if (symbolId >= m_items.size()) {
+            m_items.resize(static_cast<size_t>(symbolId) + 1);
+        }
+        return m_items[symbolId];
+    }
+
+    inline T* find(SymbolId_t symbolId) {
+        return symbolId < m_items.size() ? &m_items[symbolId] : nullptr;
+    }
+
+    inline const T* find(SymbolId_t symbolId) const {
+        return symbolId < m_items.size() ? &m_items[symbolId] : nullptr;
+    }
+
+    /* 下标即 SymbolId, 含未使用的空位 */
+    inline size_t size() const { return m_items.size(); }
+
+    inline void clear() { m_items.clear(); }
+
+    template <typename F>
+    inline void forEach(F&& f) {
+        for (size_t i = 0; i < m_items.size(); ++i) {
+            f(static_cast<SymbolId_t>(i), m_items[i]);
+        }
+    }
+
+private:
+
+    std::deque<T>   m_items{};
+};
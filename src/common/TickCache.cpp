@@ -0,0 +1,154 @@
+#include "TickCache.h"
+#include "Configs.h"
+
+TickCache::TickCache() {
+
+    auto budgetMB = agcommon::Configs::getConfigs().getConfigOrDefault("DATACONFIG", "TickCacheMB", 4096);
+
+    m_byteBudget = static_cast<size_t>(std::max(0, budgetMB)) * 1024 * 1024;
+
+    SPDLOG_INFO("TickCache byte budget:{}MB", budgetMB);
+}
+
+TickSeriesPtr TickCache::getOrLoad(uint32_t tradeDate, const Symbol_t& symbol, const Loader_t& loader) {
+
+    auto key = Key_t(tradeDate, symbol);
+
+    std::promise<TickSeriesPtr> loadPromise;
+
+    /* 等待的加载失败时不继承其异常, 重新检查后由本线程加载; 失败只影响本 key 本次调用 */
+    for (;;) {
+
+        std::shared_future<TickSeriesPtr> loadingFuture{};
+        {
+            std::unique_lock lock(m_mutex);
+
+            if (auto it = m_entries.find(key); it != m_entries.end()) {
+                m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+                m_hits++;
+                return it->second.seriesPtr;
+            }
+
+            if (auto it = m_loading.find(key); it != m_loading.end()) {
+                loadingFuture = it->second;
+                m_hits++;
+            }
+            else {
+                m_misses++;
+                m_loading.emplace(key, loadPromise.get_future().share());
+                break;
+            }
+        }
+
+        try {
+            return loadingFuture.get();
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("TickCache wait {},{} failed:{},reload", tradeDate, symbol, e.what());
+        }
+    }
+
+    TickSeriesPtr seriesPtr = nullptr;
+    try {
+        seriesPtr = loader();
+    }
+    catch (...) {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_loading.erase(key);
+        }
+        loadPromise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::scoped_lock lock(m_mutex);
+        m_loading.erase(key);
+        if (seriesPtr) {
+            _put(key, seriesPtr);
+        }
+    }
+    loadPromise.set_value(seriesPtr);
+
+    return seriesPtr;
+}
+
+TickSeriesPtr TickCache::get(uint32_t tradeDate, const Symbol_t& symbol) {
+
+    std::scoped_lock lock(m_mutex);
+
+    if (auto it = m_entries.find(Key_t(tradeDate, symbol)); it != m_entries.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+        m_hits++;
+        return it->second.seriesPtr;
+    }
+    m_misses++;
+    return nullptr;
+}
+
+void TickCache::setByteBudget(size_t bytes) {
+
+    std::scoped_lock lock(m_mutex);
+
+    m_byteBudget = bytes;
+
+    _evict();
+}
+
+void TickCache::clear() {
+
+    std::scoped_lock lock(m_mutex);
+
+    m_entries.clear();
+    m_lru.clear();
+    m_bytes = 0;
+}
+
+std::string TickCache::statInfo() {
+
+    std::scoped_lock lock(m_mutex);
+
+    return fmt::format("entries:{},bytes:{}MB/{}MB,hits:{},misses:{},evictions:{}"
+        , m_entries.size(), m_bytes / 1024 / 1024, m_byteBudget / 1024 / 1024, m_hits, m_misses, m_evictions);
+}
+
+/* lock held */
+void TickCache::_put(const Key_t& key, const TickSeriesPtr& seriesPtr) {
+
+    if (m_entries.contains(key)) {
+        return;
+    }
+    m_lru.push_front(key);
+
+    m_entries.emplace(key, Entry{ seriesPtr, m_lru.begin() });
+
+    m_bytes += seriesPtr->byteSize();
+
+    _evict();
+}
+
+/*
+* lock held. 淘汰到预算以内, 仅释放缓存的引用
+* 仍被引用的条目(回放中的 ReplayTickStore, 或刚加载完尚在返回给调用方)淘汰也不释放内存, 跳过, 引用释放后的下次淘汰再处理
+*/
+void TickCache::_evict() {
+
+    for (auto lruIt = m_lru.end(); m_bytes > m_byteBudget and lruIt != m_lru.begin();) {
+
+        --lruIt;
+
+        auto it = m_entries.find(*lruIt);
+        if (it == m_entries.end()) {
+            lruIt = m_lru.erase(lruIt);
+            continue;
+        }
+        if (it->second.seriesPtr.use_count() > 1) {
+            continue;
+        }
+        m_bytes -= it->second.seriesPtr->byteSize();
+        m_entries.erase(it);
+        m_evictions++;
+
+        lruIt = m_lru.erase(lruIt);
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <list>
+#include <span>
+#include <future>
+#include "typedefs.h"
+#include "H5DataTypes.h"
+
+class TickSnapshotFile;
+
+/*
+* 进程内共享的 tick 缓存, key: (交易日, symbol), value: 当日该 symbol 全部 tick(只读)
+* 回测通过 shared_ptr 持有只读视图, LRU 淘汰只释放缓存自身的引用, 超出字节预算时按最久未用淘汰到预算以内, 仍被回测引用的条目跳过
+*/
+
+struct TickSeries {
+
+    uint32_t                    tradeDate{ 0 };
+
+    Symbol_t                    symbol{};
+
+    float                       preClose { 0 };
+
+    int64_t                     shareCirc{ 0 };
+
+    std::span<const h5data::Tick>   ticks{};        // 指向 storage 或 snapshot 映射区
+
+    std::vector<h5data::Tick>       storage{};      // 从 h5 读取时持有数据
+
+    std::shared_ptr<TickSnapshotFile>   snapshotPtr{ nullptr };   // 从快照映射时保持映射有效, 零拷贝
+
+    /* 映射区由 OS 按页管理, 不计入预算 */
+    inline size_t byteSize() const { return sizeof(TickSeries) + symbol.capacity() + storage.capacity() * sizeof(h5data::Tick); }
+};
+
+using TickSeriesPtr = std::shared_ptr<const TickSeries>;
+
+class TickCache {
+
+public:
+
+    using Key_t    = std::pair<uint32_t, Symbol_t>;
+
+    using Loader_t = std::function<TickSeriesPtr()>;
+
+    static TickCache& getInstance() {
+        static TickCache instance{};
+        return instance;
+    }
+
+    TickCache(const TickCache&) = delete;
+    TickCache& operator=(const TickCache&) = delete;
+
+    /* 命中直接返回; 同一 key 正在被其他线程加载时等待其结果(该加载失败时自行重新加载); 否则调用 loader 加载并放入缓存. loader 返回 nullptr 不缓存, 抛出的异常只传给本次调用 */
+    TickSeriesPtr getOrLoad(uint32_t tradeDate, const Symbol_t& symbol, const Loader_t& loader);
+
+    TickSeriesPtr get(uint32_t tradeDate, const Symbol_t& symbol);
+
+    void setByteBudget(size_t bytes);
+
+    void clear();
+
+    std::string statInfo();
+
+private:
+
+    TickCache();
+
+    ~TickCache() = default;
+
+    struct KeyHash {
+        std::size_t operator()(const Key_t& key) const {
+            return std::hash<Symbol_t>()(key.second) ^ (std::hash<uint32_t>()(key.first) << 1);
+        }
+    };
+
+    struct Entry {
+        TickSeriesPtr                   seriesPtr{ nullptr };
+        std::list<Key_t>::iterator      lruIt{};
+    };
+
+    void _put(const Key_t& key, const TickSeriesPtr& seriesPtr);
+
+    void _evict();
+
+    std::mutex                                  m_mutex;
+
+    size_t                                      m_byteBudget{ 0 };
+
+    size_t                                      m_bytes{ 0 };
+
+    std::list<Key_t>                            m_lru{};         // front: 最近使用
+
+    std::unordered_map<Key_t, Entry, KeyHash>   m_entries{};
+
+    std::unordered_map<Key_t, std::shared_future<TickSeriesPtr>, KeyHash>  m_loading{};
+
+    uint64_t    m_hits{ 0 };
+    uint64_t    m_misses{ 0 };
+    uint64_t    m_evictions{ 0 };
+};
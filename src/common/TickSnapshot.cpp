@@ -0,0 +1,187 @@
+#include "TickSnapshot.h"
+#include <fstream>
+#include <cstring>
+
+namespace bip = boost::interprocess;
+
+TickSnapshotFile::TickSnapshotFile(bip::file_mapping&& file, bip::mapped_region&& region)
+    : m_file(std::move(file))
+    , m_region(std::move(region)) {
+
+    auto base = static_cast<const char*>(m_region.get_address());
+
+    m_header = reinterpret_cast<const tksnap::Header*>(base);
+    m_dir    = std::span<const tksnap::DirEntry>(reinterpret_cast<const tksnap::DirEntry*>(base + m_header->dirOffset), m_header->symbolCount);
+    m_times  = std::span<const tksnap::TimeEntry>(reinterpret_cast<const tksnap::TimeEntry*>(base + m_header->timeOffset), m_header->timeCount);
+    m_ticks  = reinterpret_cast<const h5data::Tick*>(base + m_header->tickOffset);
+}
+
+std::shared_ptr<TickSnapshotFile> TickSnapshotFile::open(const std::filesystem::path& filePath) {
+
+    if (not std::filesystem::is_regular_file(filePath)) {
+        return nullptr;
+    }
+
+    try {
+        bip::file_mapping   file(filePath.string().c_str(), bip::read_only);
+        bip::mapped_region  region(file, bip::read_only);
+
+        auto size = region.get_size();
+
+        if (size < sizeof(tksnap::Header)) {
+            SPDLOG_ERROR("tick snapshot too small:{},{}", filePath.string(), size);
+            return nullptr;
+        }
+
+        auto header = static_cast<const tksnap::Header*>(region.get_address());
+
+        if (std::memcmp(header->magic, tksnap::Magic, sizeof(tksnap::Magic)) != 0
+            or header->version  != tksnap::Version
+            or header->tickSize != sizeof(h5data::Tick)) {
+            SPDLOG_ERROR("tick snapshot invalid header:{},version:{},tickSize:{}", filePath.string(), header->version, header->tickSize);
+            return nullptr;
+        }
+
+        if (header->dirOffset  + header->symbolCount * sizeof(tksnap::DirEntry) > size
+            or header->timeOffset + header->timeCount * sizeof(tksnap::TimeEntry) > size
+            or header->tickOffset + header->tickCount * sizeof(h5data::Tick) > size) {
+            SPDLOG_ERROR("tick snapshot truncated:{},size:{}", filePath.string(), size);
+            return nullptr;
+        }
+
+        /* 回放为顺序访问 */
+        region.advise(bip::mapped_region::advice_sequential);
+
+        return std::make_shared<TickSnapshotFile>(std::move(file), std::move(region));
+    }
+    catch (const std::exception& e) {
+        SPDLOG_ERROR("open tick snapshot {} failed:{}", filePath.string(), e.what());
+    }
+    return nullptr;
+}
+
+std::filesystem::path TickSnapshotFile::snapshotPath(const std::filesystem::path& tickDir, uint32_t tradeDate) {
+
+    return tickDir / fmt::format("Tick{}.tks", tradeDate);
+}
+
+const tksnap::DirEntry* TickSnapshotFile::_findEntry(const Symbol_t& symbol) const {
+
+    auto it = std::lower_bound(m_dir.begin(), m_dir.end(), symbol, [](const tksnap::DirEntry& entry, const Symbol_t& s) {
+        return std::strncmp(entry.symbol, s.c_str(), tksnap::SymbolLen) < 0;
+        });
+
+    if (it == m_dir.end() or std::strncmp(it->symbol, symbol.c_str(), tksnap::SymbolLen) != 0) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+std::span<const h5data::Tick> TickSnapshotFile::getTicks(const Symbol_t& symbol) const {
+
+    auto entry = _findEntry(symbol);
+    if (not entry) {
+        return {};
+    }
+    return std::span<const h5data::Tick>(m_ticks + entry->tickIndex, entry->tickCount);
+}
+
+uint64_t TickSnapshotFile::tickCountOf(const Symbol_t& symbol) const {
+
+    auto entry = _findEntry(symbol);
+    return entry ? entry->tickCount : 0;
+}
+
+size_t TickSnapshotFile::countTicksBetween(uint32_t begCreatedAt, uint32_t endCreatedAt) const {
+
+    auto beg = std::upper_bound(m_times.begin(), m_times.end(), begCreatedAt, [](uint32_t t, const tksnap::TimeEntry& entry) {
+        return t < entry.createdAt;
+        });
+
+    size_t count = 0;
+    for (auto it = beg; it != m_times.end() and it->createdAt < endCreatedAt; ++it) {
+        count += it->tickCount;
+    }
+    return count;
+}
+
+bool TickSnapshotFile::write(const std::filesystem::path& filePath
+    , uint32_t tradeDate
+    , const std::map<Symbol_t, std::vector<h5data::Tick>>& series
+    , std::string& errMsg) {
+
+    std::vector<tksnap::DirEntry> dir{};
+    std::map<uint32_t, uint32_t>  time2Count{};
+
+    uint64_t tickCount = 0;
+
+    for (const auto& [symbol, ticks] : series) {
+
+        if (symbol.size() >= tksnap::SymbolLen) {
+            errMsg = fmt::format("symbol too long:{}", symbol);
+            return false;
+        }
+        if (not std::is_sorted(ticks.begin(), ticks.end(), [](const h5data::Tick& a, const h5data::Tick& b) { return a.created_at < b.created_at; })) {
+            errMsg = fmt::format("ticks not sorted by created_at:{}", symbol);
+            return false;
+        }
+
+        tksnap::DirEntry entry{};
+        std::memcpy(entry.symbol, symbol.data(), symbol.size());
+        entry.tickIndex = tickCount;
+        entry.tickCount = ticks.size();
+        entry.firstCreatedAt = ticks.empty() ? 0 : ticks.front().created_at;
+        entry.lastCreatedAt  = ticks.empty() ? 0 : ticks.back().created_at;
+        dir.push_back(entry);
+
+        for (const auto& tick : ticks) {
+            time2Count[tick.created_at] += 1;
+        }
+        tickCount += ticks.size();
+    }
+
+    tksnap::Header header{};
+    std::memcpy(header.magic, tksnap::Magic, sizeof(tksnap::Magic));
+    header.version     = tksnap::Version;
+    header.tickSize    = sizeof(h5data::Tick);
+    header.tradeDate   = tradeDate;
+    header.symbolCount = static_cast<uint32_t>(dir.size());
+    header.timeCount   = static_cast<uint32_t>(time2Count.size());
+    header.tickCount   = tickCount;
+    header.dirOffset   = sizeof(tksnap::Header);
+    header.timeOffset  = header.dirOffset  + dir.size() * sizeof(tksnap::DirEntry);
+    header.tickOffset  = header.timeOffset + time2Count.size() * sizeof(tksnap::TimeEntry);
+
+    /* 先写临时文件再 rename, 避免回测读到半个文件 */
+    auto tmpPath = filePath;
+    tmpPath += ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (not out) {
+            errMsg = fmt::format("open {} failed", tmpPath.string());
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(dir.data()), dir.size() * sizeof(tksnap::DirEntry));
+
+        for (const auto& [createdAt, count] : time2Count) {
+            tksnap::TimeEntry entry{ createdAt, count };
+            out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        }
+        for (const auto& [symbol, ticks] : series) {
+            out.write(reinterpret_cast<const char*>(ticks.data()), ticks.size() * sizeof(h5data::Tick));
+        }
+        if (not out) {
+            errMsg = fmt::format("write {} failed", tmpPath.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, filePath, ec);
+    if (ec) {
+        errMsg = fmt::format("rename {} failed:{}", tmpPath.string(), ec.message());
+        return false;
+    }
+    return true;
+}
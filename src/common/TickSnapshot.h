@@ -0,0 +1,104 @@
+#pragma once
+
+#include <span>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "typedefs.h"
+#include "H5DataTypes.h"
+
+/*
+* 每日 tick 快照文件(Tick{yyyymmdd}.tks), 可直接 mmap, 读取零拷贝:
+*
+*   Header | DirEntry[symbolCount] (按 symbol 排序) | TimeEntry[timeCount] (按 created_at 排序) | h5data::Tick[tickCount]
+*
+* tick 区按 symbol 分组, 组内按 created_at 排序, 布局与 h5data::Tick 一致; 所有区段 8 字节对齐
+* 由 tickSnapshotConverter 从 Tick*.h5 生成
+*/
+
+namespace tksnap {
+
+    constexpr char     Magic[8] = { 'A','G','T','I','C','K','S','1' };
+
+    constexpr uint32_t Version  = 1;
+
+    constexpr size_t   SymbolLen = 16;
+
+    struct Header {
+        char        magic[8];
+        uint32_t    version;
+        uint32_t    tickSize;           // sizeof(h5data::Tick), 布局校验
+        uint32_t    tradeDate;
+        uint32_t    symbolCount;
+        uint32_t    timeCount;
+        uint32_t    reserved;
+        uint64_t    tickCount;
+        uint64_t    dirOffset;
+        uint64_t    timeOffset;
+        uint64_t    tickOffset;
+    };
+
+    struct DirEntry {
+        char        symbol[SymbolLen];  // 000001.SZ, '\0' 结尾
+        uint64_t    tickIndex;          // tick 区下标
+        uint64_t    tickCount;
+        uint32_t    firstCreatedAt;
+        uint32_t    lastCreatedAt;
+    };
+
+    struct TimeEntry {
+        uint32_t    createdAt;
+        uint32_t    tickCount;          // 该时刻全市场 tick 数
+    };
+}
+
+class TickSnapshotFile {
+
+public:
+
+    /* 文件不存在或校验失败返回 nullptr */
+    static std::shared_ptr<TickSnapshotFile> open(const std::filesystem::path& filePath);
+
+    /* series: symbol -> 当日 ticks(按 created_at 排序) */
+    static bool write(const std::filesystem::path& filePath
+        , uint32_t tradeDate
+        , const std::map<Symbol_t, std::vector<h5data::Tick>>& series
+        , std::string& errMsg);
+
+    static std::filesystem::path snapshotPath(const std::filesystem::path& tickDir, uint32_t tradeDate);
+
+    inline uint32_t tradeDate() const { return m_header->tradeDate; }
+
+    inline uint64_t tickCount() const { return m_header->tickCount; }
+
+    inline uint32_t symbolCount() const { return m_header->symbolCount; }
+
+    inline size_t   byteSize()  const { return m_region.get_size(); }
+
+    std::span<const h5data::Tick> getTicks(const Symbol_t& symbol) const;
+
+    /* 不存在返回 0, 只读目录不触碰 tick 区 */
+    uint64_t tickCountOf(const Symbol_t& symbol) const;
+
+    inline std::span<const tksnap::TimeEntry> timeIndex() const { return m_times; }
+
+    /* (begCreatedAt, endCreatedAt) 开区间内的 tick 总数, 用于预分配 */
+    size_t countTicksBetween(uint32_t begCreatedAt, uint32_t endCreatedAt) const;
+
+    TickSnapshotFile(boost::interprocess::file_mapping&& file, boost::interprocess::mapped_region&& region);
+
+private:
+
+    const tksnap::DirEntry* _findEntry(const Symbol_t& symbol) const;
+
+    boost::interprocess::file_mapping       m_file;
+
+    boost::interprocess::mapped_region      m_region;
+
+    const tksnap::Header*                   m_header{ nullptr };
+
+    std::span<const tksnap::DirEntry>       m_dir{};
+
+    std::span<const tksnap::TimeEntry>      m_times{};
+
+    const h5data::Tick*                     m_ticks{ nullptr };
+};
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include "VirtualClock.h"
+
+void VirtualClock::_push(uint64_t waiterId, QuoteNs_t wakeNs, std::function<void()>&& resume) {
+    {
+        std::scoped_lock lock(m_mutex);
+
+        if (not m_closed) {
+            ++m_sleeps;
+            m_heap.push_back(Waiter{ wakeNs, m_seq++, waiterId, std::move(resume) });
+            std::push_heap(m_heap.begin(), m_heap.end(), std::greater<>{});
+            return;
+        }
+    }
+    resume();
+}
+
+bool VirtualClock::_popDue(QuoteNs_t quoteNs, bool all, Waiter& waiter) {
+
+    std::scoped_lock lock(m_mutex);
+
+    if (m_heap.empty() or (not all and m_heap.front().wakeNs >= quoteNs)) {
+        return false;
+    }
+
+    std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<>{});
+    waiter = std::move(m_heap.back());
+    m_heap.pop_back();
+    ++m_wakes;
+    return true;
+}
+
+size_t VirtualClock::advanceTo(QuoteNs_t quoteNs) {
+
+    size_t count = 0;
+    Waiter waiter{};
+
+    /* 恢复在锁外执行, 被唤醒协程可能再次登记, 早于 quoteNs 的在本轮继续恢复 */
+    while (_popDue(quoteNs, false, waiter)) {
+        waiter.resume();
+        ++count;
+    }
+    return count;
+}
+
+size_t VirtualClock::cancel(uint64_t waiterId) {
+
+    std::scoped_lock lock(m_mutex);
+
+    size_t count = 0;
+    for (auto& waiter : m_heap) {
+        if (waiter.waiterId == waiterId) {
+            waiter.wakeNs = agcommon::qtime::MinNs;
+            ++count;
+        }
+    }
+    if (count > 0) {
+        std::make_heap(m_heap.begin(), m_heap.end(), std::greater<>{});
+    }
+    return count;
+}
+
+size_t VirtualClock::close() {
+    {
+        std::scoped_lock lock(m_mutex);
+        m_closed = true;
+    }
+
+    size_t count = 0;
+    Waiter waiter{};
+
+    while (_popDue(agcommon::qtime::MinNs, true, waiter)) {
+        waiter.resume();
+        ++count;
+    }
+    return count;
+}
+
+size_t VirtualClock::size() {
+    std::scoped_lock lock(m_mutex);
+    return m_heap.size();
+}
+
+std::string VirtualClock::to_string() {
+    std::scoped_lock lock(m_mutex);
+    return fmt::format("sleeps:{},wakes:{},pending:{}", m_sleeps, m_wakes, m_heap.size());
+}
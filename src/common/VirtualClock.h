@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include "typedefs.h"
+
+/*
+* 回测仿真时钟: 协程登记唤醒时刻进入最小堆, 回放循环在两个时间戳之间取出到期者依次恢复
+*   - 按 (唤醒时刻, 登记序号) 恢复, 与线程调度无关, 同一数据重复回放结果一致
+*   - 恢复在回放线程内 dispatch, 被唤醒协程运行到下一次挂起后才继续回放, 不经定时器
+*   - 回放结束(close)后 sleepUntil 立即返回
+*/
+class VirtualClock {
+
+public:
+
+    VirtualClock() = default;
+
+    VirtualClock(const VirtualClock&) = delete;
+    VirtualClock& operator=(const VirtualClock&) = delete;
+
+    /* 挂起到仿真时间越过 wakeTime: 回放到第一个晚于 wakeTime 的时间戳前恢复, 此时最新行情不晚于 wakeTime */
+    template <typename CompletionToken = asio::use_awaitable_t<>>
+    auto sleepUntil(uint64_t waiterId, const QuoteTime_t& wakeTime, CompletionToken&& token = {}) {
+
+        return asio::async_initiate<CompletionToken, void()>(
+            [this, waiterId, wakeTime](auto handler) {
+                /* handler 仅可移动, 包一层以存入 std::function */
+                auto handlerPtr = std::make_shared<decltype(handler)>(std::move(handler));
+                _push(waiterId, agcommon::qtime::fromPtime(wakeTime), [handlerPtr]() { asio::dispatch(std::move(*handlerPtr)); });
+            }, token);
+    }
+
+    /* 恢复唤醒时刻早于 quoteNs 的协程, 回放 quoteNs 之前调用 */
+    size_t advanceTo(QuoteNs_t quoteNs);
+
+    /* waiterId 的挂起提前到下一次 advanceTo/close 恢复, 算法停止时调用; 不在调用方栈内恢复 */
+    size_t cancel(uint64_t waiterId);
+
+    /* 恢复全部挂起并关闭 */
+    size_t close();
+
+    size_t size();
+
+    std::string to_string();
+
+private:
+
+    struct Waiter {
+
+        QuoteNs_t               wakeNs{ 0 };
+
+        uint64_t                seq{ 0 };
+
+        uint64_t                waiterId{ 0 };
+
+        std::function<void()>   resume{ nullptr };
+
+        inline bool operator>(const Waiter& other) const {
+            return std::tie(wakeNs, seq) > std::tie(other.wakeNs, other.seq);
+        }
+    };
+
+    void _push(uint64_t waiterId, QuoteNs_t wakeNs, std::function<void()>&& resume);
+
+    /* 取出堆顶到期者, 无则返回 false */
+    bool _popDue(QuoteNs_t quoteNs, bool all, Waiter& waiter);
+
+    std::mutex              m_mutex;
+
+    std::vector<Waiter>     m_heap{};       // std::greater 最小堆
+
+    uint64_t                m_seq{ 0 };
+
+    bool                    m_closed{ false };
+
+    uint64_t                m_sleeps{ 0 };
+
+    uint64_t                m_wakes{ 0 };
+};
@@ -170,7 +170,14 @@ namespace agcommon
     返回整数 yyyymmddhhmmss
 */
     uint64_t getDateTimeInt(const posix_time::ptime& pt) {
-        return std::stoull(geISODateStr(pt) + getTimeStr(pt));
+        if (pt.is_special()) {
+            return 0;
+        }
+        auto ns = qtime::fromPtime(pt);
+        if (ns == qtime::MinNs or ns == qtime::MaxNs) {
+            return std::stoull(geISODateStr(pt) + getTimeStr(pt));    // min_date_time 等超出纳秒范围
+        }
+        return qtime::toDateTimeInt(ns);
     }
 
 /*
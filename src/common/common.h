@@ -329,11 +329,56 @@ namespace agcommon {
         }
 
         static posix_time::ptime convert2ShanghaiTZ(uint32_t timestamp) {
-            static boost::local_time::time_zone_ptr shanghai_zone(new boost::local_time::posix_time_zone("CST+8"));
-            std::time_t time = static_cast<std::time_t>(timestamp);
-            boost::posix_time::ptime pt = boost::posix_time::from_time_t(time);
-            pt = pt + shanghai_zone->base_utc_offset();
-            return pt;
+            return qtime::toPtime(qtime::fromUtcSeconds(timestamp));
+        }
+
+        /* QuoteNs_t 版本, 只做整数运算, 行情逐 tick 路径使用 */
+        static constexpr QuoteNs_t getMarketOpenTime(QuoteNs_t refTime)              { return qtime::dayStart(refTime) + qtime::hms(9, 30); }
+
+        static constexpr QuoteNs_t getMarketMorningCloseTime(QuoteNs_t refTime)      { return qtime::dayStart(refTime) + qtime::hms(11, 30); }
+
+        static constexpr QuoteNs_t getMarketAfternoonOpenTime(QuoteNs_t refTime)     { return qtime::dayStart(refTime) + qtime::hms(13, 0); }
+
+        static constexpr QuoteNs_t getClosingCallAuctionBeginTime(QuoteNs_t refTime) { return qtime::dayStart(refTime) + qtime::hms(14, 57); }
+
+        static constexpr QuoteNs_t getMarketCloseTime(QuoteNs_t refTime)             { return qtime::dayStart(refTime) + qtime::hms(15, 0); }
+
+        static constexpr bool isAfternoonBreakTime(QuoteNs_t refTime) {
+            return refTime > getMarketMorningCloseTime(refTime) and refTime < getMarketAfternoonOpenTime(refTime);
+        }
+
+        static constexpr bool isInMarketContinueTradingTime(QuoteNs_t refTime) {
+            return refTime >= getMarketOpenTime(refTime) and refTime <= getClosingCallAuctionBeginTime(refTime);
+        }
+
+        /* 同 getMarketDuration(ptime, ptime), 秒 */
+        static constexpr double getMarketDuration(QuoteNs_t startTime, QuoteNs_t endTime) {
+
+            if (startTime > endTime)
+                return 0;
+
+            auto marketOpenTime          = getMarketOpenTime(startTime);
+            auto marketCloseTime         = getMarketCloseTime(startTime);
+            auto marketMorningCloseTime  = getMarketMorningCloseTime(startTime);
+            auto marketAfternoonOpenTime = getMarketAfternoonOpenTime(startTime);
+
+            endTime = endTime < marketCloseTime ? endTime : marketCloseTime;
+
+            int64_t duration = endTime - startTime;
+
+            if (startTime < marketOpenTime) {
+                duration -= marketOpenTime - startTime;
+            }
+            if (endTime > marketMorningCloseTime && endTime < marketAfternoonOpenTime) {
+                duration = marketMorningCloseTime - startTime;
+            }
+            else if (startTime < marketMorningCloseTime && endTime >= marketAfternoonOpenTime) {
+                duration = duration - (marketAfternoonOpenTime - marketMorningCloseTime);
+            }
+            else if (startTime > marketMorningCloseTime && startTime <= marketAfternoonOpenTime && endTime >= marketAfternoonOpenTime) {
+                duration = endTime - marketAfternoonOpenTime;
+            }
+            return qtime::toSeconds(duration);
         }
 
     };
@@ -9,6 +9,7 @@
 
 #include <spdlog/spdlog.h>
 #include "AlgoMessages.pb.h"
+#include "LocalTime.h"
 
 #include <iostream>
 
@@ -47,6 +48,7 @@ using OrderType_t       = char;
 using ClientAlgoOrderId_t = std::string;
 
 using Symbol_t      = std::string;
+using SymbolId_t    = uint32_t;       // SymbolTable 分配的进程内稠密下标
 using PositionKey_t = std::pair<std::string, std::string>;
 
 using Broker_t = uint64_t;
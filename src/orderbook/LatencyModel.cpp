@@ -0,0 +1,55 @@
+#include "LatencyModel.h"
+#include "Configs.h"
+
+LatencyModel::LatencyModel(uint64_t seed) :m_rng(seed) {
+
+    auto& configs = agcommon::Configs::getConfigs();
+
+    auto mode = configs.getConfigOrDefault("LATENCY", "Mode", 0);
+    m_mode    = mode >= 0 and mode <= static_cast<int>(Mode::PerExchange) ? static_cast<Mode>(mode) : Mode::None;
+    m_sigma   = configs.getConfigOrDefault("LATENCY", "Sigma", 0.5);
+
+    static const std::array<std::string, Kinds> kindNames   { "OrderMs", "CancelMs", "QuoteMs" };
+    static const std::array<std::string, 3>     exchangeSuff{ "", "_SHSE", "_SZSE" };
+
+    for (size_t k = 0; k < Kinds; ++k) {
+
+        auto defaultMs = configs.getConfigOrDefault("LATENCY", kindNames[k], 0.0);
+
+        for (size_t e = 0; e < exchangeSuff.size(); ++e) {
+            m_baseMs[e][k] = (e == 0 or m_mode != Mode::PerExchange)
+                ? defaultMs
+                : configs.getConfigOrDefault("LATENCY", kindNames[k] + exchangeSuff[e], defaultMs);
+        }
+    }
+}
+
+int64_t LatencyModel::sampleUs(LatencyKind kind, agcommon::MarketExchange exchange) {
+
+    auto baseMs = m_baseMs[exchangeIdx(exchange)][static_cast<size_t>(kind)];
+
+    if (m_mode == Mode::None or baseMs <= 0) {
+        return 0;
+    }
+    if (m_mode == Mode::LogNormal) {
+        baseMs *= std::exp(m_sigma * m_normal(m_rng));
+    }
+    return static_cast<int64_t>(baseMs * 1000);
+}
+
+QuoteTime_t LatencyModel::arrivalTime(const QuoteTime_t& submitTime, LatencyKind kind, agcommon::MarketExchange exchange) {
+
+    auto us = sampleUs(LatencyKind::Quote, exchange) + sampleUs(kind, exchange);
+
+    return submitTime + boost::posix_time::microseconds(us);
+}
+
+std::string LatencyModel::to_string() const {
+
+    return fmt::format("mode:{},order:{}ms,cancel:{}ms,quote:{}ms,sigma:{}"
+        , static_cast<int>(m_mode)
+        , m_baseMs[0][static_cast<size_t>(LatencyKind::Order)]
+        , m_baseMs[0][static_cast<size_t>(LatencyKind::Cancel)]
+        , m_baseMs[0][static_cast<size_t>(LatencyKind::Quote)]
+        , m_sigma);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <random>
+#include "typedefs.h"
+#include "common.h"
+
+enum class LatencyKind : uint8_t {
+
+    Order   = 0,    // 下单到达撮合
+    Cancel  = 1,    // 撤单到达撮合
+    Quote   = 2,    // 行情到达策略, 计入下单/撤单的到达时间
+};
+
+/*
+* 模拟撮合延迟, [LATENCY] 配置:
+*   Mode        0: 关闭 1: 固定 2: 对数正态(中位数为配置值, 形状参数 Sigma) 3: 按交易所固定
+*   OrderMs/CancelMs/QuoteMs                默认延迟
+*   OrderMs_SHSE/OrderMs_SZSE/...           Mode 3 时按交易所覆盖, 未配置取默认
+* 随机数按 seed 确定, 同一回测重复运行结果一致; 非线程安全, 每个撮合分片一份
+*/
+class LatencyModel {
+
+public:
+
+    enum class Mode : uint8_t {
+        None        = 0,
+        Fixed       = 1,
+        LogNormal   = 2,
+        PerExchange = 3,
+    };
+
+    explicit LatencyModel(uint64_t seed);
+
+    inline bool enabled() const { return m_mode != Mode::None; }
+
+    /* 采样一次延迟, 微秒 */
+    int64_t sampleUs(LatencyKind kind, agcommon::MarketExchange exchange);
+
+    /* 提交请求的仿真时刻 -> 到达撮合的仿真时刻, 含行情延迟 */
+    QuoteTime_t arrivalTime(const QuoteTime_t& submitTime, LatencyKind kind, agcommon::MarketExchange exchange);
+
+    std::string to_string() const;
+
+private:
+
+    static constexpr size_t Kinds = 3;
+
+    /* 0: 默认 1: SHSE 2: SZSE */
+    static inline size_t exchangeIdx(agcommon::MarketExchange exchange) {
+        switch (exchange) {
+        case agcommon::MarketExchange::SHSE: return 1;
+        case agcommon::MarketExchange::SZSE: return 2;
+        default: return 0;
+        }
+    }
+
+    Mode                                        m_mode{ Mode::None };
+
+    std::array<std::array<double, Kinds>, 3>    m_baseMs{};
+
+    double                                      m_sigma{ 0.5 };
+
+    std::mt19937_64                             m_rng;
+
+    std::normal_distribution<double>            m_normal{ 0.0, 1.0 };
+};
@@ -1,12 +1,14 @@
 #include"Order.h"
 
 Order::Order(const Order& other)
-    : orderId(other.orderId),
+    : KeepAlivePool<Order>(other),
+    orderId(other.orderId),
     orderTime(other.orderTime),
     brokerId(other.brokerId),
     acctType(other.acctType),
     acct(other.acct),
     symbol(other.symbol),
+    symbolId(other.symbolId),
     tradeSide(other.tradeSide),
     status(other.status),
     orderQty(other.orderQty),
@@ -36,6 +38,7 @@ Order& Order::operator=(const Order& other) {
         acctType = other.acctType;
         acct = other.acct;
         symbol = other.symbol;
+        symbolId = other.symbolId;
         tradeSide = other.tradeSide;
         status = other.status;
         orderQty = other.orderQty;
@@ -110,12 +113,14 @@ std::string Order::to_string_simple() const {
 }
 
 Trade::Trade(const Trade& oth)
-    : tradeId(oth.tradeId),
+    : KeepAlivePool<Trade>(oth),
+    tradeId(oth.tradeId),
     orderId(oth.orderId),
     brokerId(oth.brokerId),
     acctType(oth.acctType),
     acct(oth.acct),
     symbol(oth.symbol),
+    symbolId(oth.symbolId),
     tradeSide(oth.tradeSide),
     filledQty(oth.filledQty),
     price(oth.price),
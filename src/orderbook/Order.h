@@ -3,6 +3,7 @@
 #include "typedefs.h"
 #include "common.h"
 #include "KeepAlive.h"
+#include "SymbolTable.h"
 
 using BrokerOrderNo_t = std::string;
 
@@ -22,6 +23,8 @@ struct Order :KeepAlivePool<Order> {
 
     Symbol_t    symbol         {};
 
+    SymbolId_t  symbolId       { InvalidSymbolId };     // 进入 orderbook 时登记
+
     int         tradeSide      {0};
 
     int         status         { agcommon::OrderStatus::UNSENT };
@@ -130,6 +133,8 @@ struct Trade: KeepAlivePool<Trade> {
 
     Symbol_t    symbol{};
 
+    SymbolId_t  symbolId{ InvalidSymbolId };
+
     int         tradeSide{ 0 };
 
     int         filledQty{ 0 };
@@ -164,4 +169,14 @@ public:
         }
         return OrderBookKey_t(acctType, acct, brokerId);
     }
-};
\ No newline at end of file
+};
+
+/* OrderBook -> 订阅者(trader) 事件, order 与 trade 二选一, 同一通道内保持先后顺序 */
+struct OrderBookEvent {
+
+    boost::intrusive_ptr<Order>     order{ nullptr };
+
+    boost::intrusive_ptr<Trade>     trade{ nullptr };
+
+    int64_t                         enqueueNs{ 0 };
+};
@@ -5,14 +5,27 @@
 
 struct Order;
 struct Trade;
+struct OrderBookEvent;
 class QuoteFeed;
 class MarketDepth;
 
+template <typename Event, typename Executor>
+class EventChannel;
+
+using OrderBookEventChannel = EventChannel<OrderBookEvent, asio::io_context::executor_type>;
+
 typedef std::function<void(const Order* )> OnOrderUpdateCallback;
 typedef std::function<void(const Trade* )> OnTradeCallback;
 
 using SubscribeOrderKey_t = std::variant<uint64_t, OrderBookKey_t>;
 
+/* 模拟撮合模型 */
+enum class FillModel : uint8_t {
+
+    VolumePercent   = 0,    // 主动单按可见档位量 20% 成交, 被动单按总成交量消耗排队量
+    QueuePosition   = 1,    // 按快照估计本单在价位上的排队位置, 见 QueuePositionModel
+};
+
 struct OrderBookRequest {
 
     OrderBookKey_t              orderBookKey;
@@ -22,6 +35,8 @@ struct OrderBookRequest {
     AsioContextPtr              runContextPtr;   // 回测时需与算法所在asioContext一致
 
     std::shared_ptr<QuoteFeed>  quoteFeedPtr{nullptr};    // 模拟/回测模式时不能为nullptr,
+
+    FillModel                   fillModel{ FillModel::VolumePercent };  // 仅模拟/回测, 同一 orderBookKey 以首次创建为准
 };
 
 struct SubscribeOrder_t {
@@ -33,6 +48,8 @@ struct SubscribeOrder_t {
     OnTradeCallback         onTrade{ nullptr };
 
     AsioContextPtr          callBackContextPtr{ nullptr };
+
+    std::shared_ptr<OrderBookEventChannel>  eventChannel{ nullptr };    // 有 callBackContextPtr 时由 OrderBook 创建
 };
 
 class OrderBook: public std::enable_shared_from_this<OrderBook> {
@@ -3,6 +3,9 @@
 #include "QuoteFeedService.h"
 #include "IdGenerator.h"
 #include "StockDataManager.h"
+#include "ContextService.h"
+#include "Configs.h"
+#include "EventBus.h"
 
 
 OrderBookSim::OrderBookSim(const OrderBookRequest& req):
@@ -10,8 +13,22 @@ OrderBookSim::OrderBookSim(const OrderBookRequest& req):
     , algoPlacerPtr(std::make_shared<AlgoPlacer>(req.runContextPtr)){
 
     if (req.quoteMode == agcommon::QuoteMode::SIMLIVE) {
-        symbol2UnFinishedOrders.reserve(10000);
-        localOrderId2Order.reserve(50000);
+
+        auto shardCount = agcommon::Configs::getConfigs().getConfigOrDefault("ORDERBOOK", "MatchShards", 0);
+        if (shardCount <= 0) {
+            shardCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 2);
+        }
+
+        auto matchContextPtr = ContextService::getInstance().createContext("OrderBookSim_match", shardCount);
+
+        for (int i = 0; i < shardCount; i++) {
+            auto& shard = m_shards.emplace_back(std::make_unique<MatchShard>(i, asio::io_context::strand(*matchContextPtr), i + 1));
+            shard->localOrderId2Order.reserve(50000 / shardCount + 1);
+        }
+        m_orderId2Shard.reserve(50000);
+    }
+    else {
+        m_shards.emplace_back(std::make_unique<MatchShard>(0, m_strand, 1));
     }
 };
 
@@ -23,9 +40,24 @@ void OrderBookSim::run() {
 
     if (m_request.quoteFeedPtr) {
 
-        SPDLOG_INFO("{} OrderBookSim start.", m_request.orderBookKey);
+        SPDLOG_INFO("{} OrderBookSim start,shards:{},latency:{}", m_request.orderBookKey, m_shards.size(), m_shards[0]->latency.to_string());
         auto self = shared_from_this();
 
+        for (auto& shard : m_shards) {
+            shard->mdChannel = MarketDepthStrandChannel::create("quote->orderbook", shard->strand
+                , [weakSelf = std::weak_ptr<OrderBookSim>(self), shardPtr = shard.get()](MarketDepthEvent* events, size_t count) {
+                    if (auto self = weakSelf.lock(); self and not self->isStopped()) {
+                        for (size_t i = 0; i < count; ++i) {
+                            auto& md = events[i].md;
+                            shardPtr->mds[md->symbolId] = md;
+                            self->simOrderMatchFill(*shardPtr, md.get());
+                            self->_advanceClock(*shardPtr, md.get());
+                        }
+                        self->reconcileAssets(*shardPtr);
+                    }
+                });
+        }
+
         OnDelayTestCallback onDelayTest = std::bind(&OrderBook::onDelayTest, self, std::placeholders::_1);;
 
         m_request.quoteFeedPtr->regesterOrderBookCallback(m_request.orderBookKey
@@ -50,18 +82,44 @@ void OrderBookSim::stop() {
         self->release();
      };
 
-    asio::dispatch(m_strand, task);
+    /* 先在各分片清空在途请求, 全部完成后再停止 */
+    auto remaining = std::make_shared<std::atomic<size_t>>(m_shards.size());
+
+    for (auto& shard : m_shards) {
+
+        asio::dispatch(shard->strand, [self = shared_from_this(), shardPtr = shard.get(), remaining, task]() {
+
+            self->_flushPendings(*shardPtr);
+
+            if (remaining->fetch_sub(1) == 1) {
+                asio::dispatch(self->m_strand, task);
+            }
+        });
+    }
 }
 
 void OrderBookSim::release() {
 
     if (isStopped()) {
 
-        localOrderId2Order.clear();
+        {
+            std::scoped_lock lock(m_orderIdMutex);
+            m_orderId2Shard.clear();
+        }
+
+        for (auto& shard : m_shards) {
+
+            asio::dispatch(shard->strand, [self = shared_from_this(), shardPtr = shard.get()]() {
+
+                shardPtr->localOrderId2Order.clear();
+
+                shardPtr->symbol2UnFinishedOrders.clear();
 
-        symbol2UnFinishedOrders.clear();
+                shardPtr->mds.clear();
 
-        m_mds.clear();
+                shardPtr->pendings = {};
+            });
+        }
     }
 }
 
@@ -77,6 +135,25 @@ SubscribeOrderKey_t OrderBookSim::_subscribe(std::shared_ptr<SubscribeOrder_t> s
 
     bool isinserted = false;
 
+    /* 回调在其它 context 时, 经事件通道批量投递 */
+    if (subPtr->callBackContextPtr and not subPtr->eventChannel) {
+        subPtr->eventChannel = OrderBookEventChannel::create("orderbook->trader", subPtr->callBackContextPtr->get_executor()
+            , [weakSub = std::weak_ptr<SubscribeOrder_t>(subPtr)](OrderBookEvent* events, size_t count) {
+                if (auto sub = weakSub.lock()) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (events[i].order) {
+                            sub->onOrderUpdate(events[i].order.get());
+                        }
+                        else if (events[i].trade) {
+                            sub->onTrade(events[i].trade.get());
+                        }
+                    }
+                }
+            });
+    }
+
+    std::unique_lock lock(m_subMutex);
+
     if (std::holds_alternative<uint64_t>(subPtr->subscribeKey)) {
 
         auto subscribeKey = std::get<uint64_t>(subPtr->subscribeKey);
@@ -111,6 +188,8 @@ void OrderBookSim::unSubscribe(const SubscribeOrderKey_t& subscribeKey) {
 
 void OrderBookSim::_unSubscribe(const SubscribeOrderKey_t& subscribeKey) {
 
+    std::unique_lock lock(m_subMutex);
+
     if (std::holds_alternative<uint64_t>(subscribeKey)) {
 
         auto int_subscribeKey = std::get<uint64_t>(subscribeKey);
@@ -135,6 +214,26 @@ void OrderBookSim::_unSubscribe(const SubscribeOrderKey_t& subscribeKey) {
     }
 }
 
+std::shared_ptr<SubscribeOrder_t> OrderBookSim::_findSubscriber(const uint64_t algoOrderId) {
+
+    std::shared_lock lock(m_subMutex);
+
+    if (auto it = m_algoKey2OrderUpdateCallBack.find(algoOrderId); it != m_algoKey2OrderUpdateCallBack.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<SubscribeOrder_t> OrderBookSim::_findSubscriber(const OrderBookKey_t& orderBookKey) {
+
+    std::shared_lock lock(m_subMutex);
+
+    if (auto it = m_orderBookKey2OrderUpdateCallBack.find(orderBookKey); it != m_orderBookKey2OrderUpdateCallBack.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
 std::shared_ptr<OrderBookSim> OrderBookSim::shared_from_this()
 {
     return std::static_pointer_cast<OrderBookSim>(OrderBook::shared_from_this());
@@ -142,45 +241,50 @@ std::shared_ptr<OrderBookSim> OrderBookSim::shared_from_this()
 
 void OrderBookSim::addAcctAsset(const AcctKey_t& acctKey, AssetInfo& asset) {
 
-    asio::dispatch(m_strand, [self = shared_from_this(), this, asset]() {
+    std::scoped_lock lock(m_assetMutex);
 
-        acctAssetInfos.try_emplace(asset.acctKey, asset);
-    });
+    acctAssetInfos.try_emplace(asset.acctKey, asset);
 }
 
 void OrderBookSim::addPosition(const PositionInfo& position) {
 
-    asio::dispatch(m_strand, [self = shared_from_this(), this, position]() {
+    auto& shard = shardOf(SymbolTable::getInstance().intern(position.symbol));
+
+    asio::dispatch(shard.strand, [self = shared_from_this(), this, &shard, position]() {
 
         AcctKey_t acctKey = { position.acctType, position.acct, position.brokerId };
 
         SymbolKey_t symbolKey = { acctKey,position.symbol };
 
-        if (acctAssetInfos.find(acctKey) == acctAssetInfos.end()) {
-            double cash = SIMACCT_DEFAUL_CAPITAL;
-            AssetInfo asset;
-            asset.acctKey = acctKey;
-            asset.enabledBalance = cash;
-            asset.currentBalance = cash;
+        {
+            std::scoped_lock lock(m_assetMutex);
+
+            if (acctAssetInfos.find(acctKey) == acctAssetInfos.end()) {
+                double cash = SIMACCT_DEFAUL_CAPITAL;
+                AssetInfo asset;
+                asset.acctKey = acctKey;
+                asset.enabledBalance = cash;
+                asset.currentBalance = cash;
 
-            addAcctAsset(acctKey, asset);
+                acctAssetInfos.try_emplace(acctKey, asset);
+            }
         }
 
-        positionInfos.try_emplace(symbolKey, position);
+        shard.positionInfos.try_emplace(symbolKey, position);
 
         SPDLOG_INFO("Add New Position:{}" + position.to_string());
     });
 }
 
-void OrderBookSim::refreshAssetPosition(const Order& order, const Order& preOrder) {
+void OrderBookSim::refreshAssetPosition(MatchShard& shard, const Order& order, const Order& preOrder) {
 
     AcctKey_t   acctKey   = AcctKey_t(order.acctType ,order.acct, order.brokerId);
 
     SymbolKey_t symbolKey = std::make_pair(acctKey,order.symbol);
 
-    AssetInfo&    ai =   acctAssetInfos[acctKey]; 
+    double&       balanceDelta = shard.balanceDeltas[acctKey];
 
-    PositionInfo& pi =   positionInfos[symbolKey];
+    PositionInfo& pi =   shard.positionInfos[symbolKey];
 
     if (preOrder.orderId==order.orderId) {
 
@@ -193,44 +297,42 @@ void OrderBookSim::refreshAssetPosition(const Order& order, const Order& preOrde
             deltaqty = order.orderQty;
             deltafrozenAmt = order.orderQty * order.orderPrice;
             if (agcommon::isBuy(order.tradeSide)){
-                ai.enabledBalance= ai.enabledBalance + deltafrozenAmt;
+                balanceDelta += deltafrozenAmt;
             } else{
                 pi.enabledQty=pi.enabledQty + deltaqty;
             }
         }
         else{
-        // 撤单及成交 可用资金 及 可用数量更新 
+        // 撤单及成交 可用资金 及 可用数量更新
             if (agcommon::isBuy(order.tradeSide)){
                 pi.enabledQty = pi.enabledQty + deltaqty;
                 pi.currentQty = pi.currentQty + deltaqty;
-                ai.enabledBalance = ai.enabledBalance + cancelqty * order.orderPrice;
+                balanceDelta += cancelqty * order.orderPrice;
             }else{
-                ai.enabledBalance   = ai.enabledBalance + deltaFilledAmt;
+                balanceDelta += deltaFilledAmt;
                 pi.enabledQty = pi.enabledQty + cancelqty;
                 pi.currentQty = pi.currentQty - deltaqty;
             }
         }
-        ai.updTime = agcommon::now();
-        pi.updTime = ai.updTime;
+        pi.updTime = agcommon::now();
 
     } else {
         double frozenAmt = 0;
         int frozenQty = 0;
-        if (const auto it = m_mds.find(order.symbol);it!= m_mds.end()) {
-            const auto& md = it->second;
+        if (const auto mdIt = shard.mds.find(order.symbolId); mdIt and *mdIt) {
+            const auto& md = *mdIt;
             double frozenPrice = 0;
             if (order.orderPrice) {
                 frozenPrice = order.orderPrice;
             } else {
-                frozenPrice = std::max({md->bidPrice1, md->askPrice1, md->price});
+                frozenPrice = std::max({md->bidPrices[0], md->askPrices[0], md->price});
             }
             if (frozenPrice == 0) {
-                SPDLOG_ERROR(order.symbol + "0 Market Price."); 
+                SPDLOG_ERROR(order.symbol + "0 Market Price.");
             }
-            if (agcommon::isBuy(order.tradeSide)) { 
+            if (agcommon::isBuy(order.tradeSide)) {
                 frozenAmt = frozenPrice * order.orderQty;
-                ai.enabledBalance -= frozenAmt;
-                ai.updTime = agcommon::now();
+                balanceDelta -= frozenAmt;
             } else {
                 frozenQty = order.orderQty;
                 pi.enabledQty -= frozenQty;
@@ -241,76 +343,201 @@ void OrderBookSim::refreshAssetPosition(const Order& order, const Order& preOrde
         }
         // ... rest of the code
     }
-    auto md = getMarketDepth(order.symbol);
+    auto md = getMarketDepth(shard, order.symbolId);
     if(md) {
         pi.lastPrice = md->price;
         pi.mktValue = pi.currentQty * md->price;
     }
 }
 
+void OrderBookSim::reconcileAssets(MatchShard& shard) {
+
+    if (shard.balanceDeltas.empty()) {
+        return;
+    }
+
+    auto updTime = agcommon::now();
+
+    std::scoped_lock lock(m_assetMutex);
+
+    for (auto& [acctKey, delta] : shard.balanceDeltas) {
+        auto& ai = acctAssetInfos[acctKey];
+        ai.enabledBalance += delta;
+        ai.updTime = updTime;
+    }
+    shard.balanceDeltas.clear();
+}
+
 bool OrderBookSim::placeOrder(const Order* _order) {
     if (isStopped()) {
         return false;
     }
     auto order = Order::make_intrusive(*_order);
 
-    asio::dispatch(m_strand,[self = shared_from_this(), order]() {  
-        self->_placeOrder(order); });
+    if (order->symbolId == InvalidSymbolId) {
+        order->symbolId = SymbolTable::getInstance().intern(order->symbol);
+    }
+
+    auto& shard = shardOf(order->symbolId);
+
+    bool isExist = false;
+    {
+        std::scoped_lock lock(m_orderIdMutex);
+        isExist = not m_orderId2Shard.emplace(order->orderId, static_cast<uint32_t>(shard.idx)).second;
+    }
+
+    asio::dispatch(shard.strand,[self = shared_from_this(), &shard, order, isExist]() {
+        if (shard.latency.enabled() and not isExist) {
+            self->_deferRequest(shard, order, 0);
+            return;
+        }
+        self->_placeOrder(shard, order, isExist);
+        self->reconcileAssets(shard); });
     return true;
 }
 
-bool OrderBookSim::_placeOrder(const OrderPtr& order) {
+void OrderBookSim::_deferRequest(MatchShard& shard, const OrderPtr& order, const OrderId_t cancelOrderId) {
+
+    /* 回测以回放时钟为提交时刻, 实时模拟以分片已处理行情的最新时间为准 */
+    auto submitTime = isBackTest() and m_request.quoteFeedPtr ? m_request.quoteFeedPtr->getCurrentQuoteTime() : shard.clock;
+
+    auto symbolId = order ? order->symbolId : InvalidSymbolId;
+    if (not order) {
+        if (auto it = shard.localOrderId2Order.find(cancelOrderId); it != shard.localOrderId2Order.end()) {
+            symbolId = it->second.first->symbolId;
+        }
+    }
+
+    auto exchange = agcommon::MarketExchange::unDefined;
+    if (symbolId != InvalidSymbolId) {
+        if (auto md = getMarketDepth(shard, symbolId)) {
+            exchange = md->getMarketExchange();
+        }
+    }
+
+    auto arrival = shard.latency.arrivalTime(submitTime, order ? LatencyKind::Order : LatencyKind::Cancel, exchange);
+
+    arrival = std::max(arrival, shard.lastArrival);
+    shard.lastArrival = arrival;
+
+    shard.pendings.push(PendingRequest{ arrival, shard.pendingSeq++, order, cancelOrderId });
+}
+
+void OrderBookSim::_advanceClock(MatchShard& shard, const MarketDepth* const md) {
+
+    if (md->quoteTime > shard.clock) {
+        shard.clock = md->quoteTime;
+    }
+
+    while (not shard.pendings.empty() and shard.pendings.top().arrival <= shard.clock) {
+
+        auto request = shard.pendings.top();
+        shard.pendings.pop();
+
+        if (request.order) {
+            _placeOrder(shard, request.order, false, request.arrival);
+        }
+        else {
+            _cancelOrderWithOrderId(shard, request.cancelOrderId);
+        }
+    }
+}
+
+void OrderBookSim::_flushPendings(MatchShard& shard) {
+
+    while (not shard.pendings.empty()) {
+
+        auto request = shard.pendings.top();
+        shard.pendings.pop();
+
+        if (request.order) {
+            /* 到达时刻晚于最后一笔行情, 交易所收不到该委托 */
+            request.order->status = agcommon::OrderStatus::REJECTED;
+            request.order->text   = "arrived after quote feed finished.";
+            SPDLOG_WARN("[ORDER_REJECT]in flight at feed finish,{}", request.order->to_string());
+            _onOrderUpdate(request.order.get());
+        }
+        else {
+            _cancelOrderWithOrderId(shard, request.cancelOrderId);
+        }
+    }
+    reconcileAssets(shard);
+}
+
+bool OrderBookSim::_placeOrder(MatchShard& shard, const OrderPtr& order, bool isExist, const QuoteTime_t& arrival) {
 
     if (isStopped()) {
         return false;
     }
-    auto md = getMarketDepth(order->symbol);
+    auto md = getMarketDepth(shard, order->symbolId);
 
-    SPDLOG_DEBUG("[aId:{}]localOrderId2Order.size:{}", order->algoOrderId, localOrderId2Order.size());
+    /* 终态订单已移出 m_orderId2Shard, 重复 orderId 由分片内记录判断; 重复单被拒, 不保留其索引 */
+    if (auto it = shard.localOrderId2Order.find(order->orderId); not isExist and it != shard.localOrderId2Order.end()) {
+        isExist = true;
+        std::scoped_lock lock(m_orderIdMutex);
+        m_orderId2Shard.erase(order->orderId);
+    }
+
+    SPDLOG_DEBUG("[aId:{}]localOrderId2Order.size:{}", order->algoOrderId, shard.localOrderId2Order.size());
     try {
-        if (localOrderId2Order.contains(order->orderId)) {
+        if (isExist) {
             order->status = agcommon::OrderStatus::REJECTED;
-            if (auto it = m_algoKey2OrderUpdateCallBack.find(order->algoOrderId); it != m_algoKey2OrderUpdateCallBack.end()) {
-                auto& subOrderUpdateInfo = it->second;
-                subOrderUpdateInfo->onOrderUpdate(order.get());
+            if (auto subOrderUpdateInfo = _findSubscriber(order->algoOrderId)) {
+                _notifySubscriber(subOrderUpdateInfo, order.get(), nullptr);
             }
-            if (auto it = m_orderBookKey2OrderUpdateCallBack.find(order->getOrderBookKey()); it != m_orderBookKey2OrderUpdateCallBack.end()) {
-                auto& subOrderUpdateInfo = it->second;
-                subOrderUpdateInfo->onOrderUpdate(order.get());
+            if (auto subOrderUpdateInfo = _findSubscriber(order->getOrderBookKey())) {
+                _notifySubscriber(subOrderUpdateInfo, order.get(), nullptr);
             }
             SPDLOG_ERROR("[ORDER_ERROR]OrderId EXIST:{}", order->orderId);
             return false;
         }
         else {
-            uint32_t marketVolPeging = -1;
+            QueueState queueState{};
+
+            /* 分片时钟可能由其他标的推进, 本标的最新行情早于到达时刻时不以该快照撮合/估计排队, 等本标的下一笔行情 */
+            const bool deferred = arrival != boost::posix_time::min_date_time;
+            const MarketDepth* matchMd = md and md->quoteTime >= arrival ? md : nullptr;
+
+            if (deferred and isBackTest()) {
+                order->orderTime = arrival;
+                order->updTime   = arrival;
+            }
             if (md) {
-                if (isBackTest()) {
+                if (isBackTest() and not deferred) {
                     order->orderTime = md->quoteTime ;
                     order->updTime   = md->quoteTime ;
-                    order->quoteTime = md->quoteTime;
                 }
-                else {
-                    order->quoteTime = md->quoteTime;
-                }
-                auto marketVolPeging = md->getPricezVol(order->orderPrice);
+                order->quoteTime = md->quoteTime;
+                auto marketVolPeging = md->getPricezVol(md->toTicks(order->orderPrice));
                 SPDLOG_INFO("[OrderNew]{},bid1/ask1:{:.3f},{:.3f},qtime:{},pegVol:{},tradeVol:{}", order->to_string()
-                    , md->bidPrice1, md->askPrice1
+                    , md->bidPrices[0], md->askPrices[0]
                     , agcommon::getTimeStr(md->quoteTime), marketVolPeging, md->deltaVolume);
             }
 
-            auto& _unfinishs = symbol2UnFinishedOrders[order->symbol];
+            auto& _unfinishs = shard.symbol2UnFinishedOrders[order->symbolId];
+
+            if (m_request.fillModel == FillModel::QueuePosition) {
+                auto tradeDate = agcommon::getDateInt(isBackTest() ? order->orderTime : agcommon::now());
+                auto ssinfo    = StockDataManager::getInstance().getSecurityStaticInfo(order->symbol, tradeDate);
+                QueuePositionModel::onPlaced(queueState, *order, matchMd, ssinfo);
+            }
+
+            auto it = _unfinishs.emplace_hint(_unfinishs.end(), order->orderId, std::pair(order, queueState));
 
-            auto it = _unfinishs.emplace_hint(_unfinishs.end(), order->orderId, std::pair(order, marketVolPeging));
+            shard.localOrderId2Order.emplace(order->orderId, std::pair(order, it));
 
-            localOrderId2Order.emplace(order->orderId, std::pair(order, it));
+            m_orderCount.fetch_add(1, std::memory_order_relaxed);
 
             if (md)
             {
                 Order preOrder{};
 
-                refreshAssetPosition(*order, preOrder);
+                refreshAssetPosition(shard, *order, preOrder);
+            }
 
-                simOrderMatchFill(it, md);  // 如果订单是主动单,模拟及时成交
+            if (matchMd)
+            {
+                simOrderMatchFill(shard, it, matchMd);  // 如果订单是主动单,模拟及时成交
 
                 if (it->second.first->isFinalStatus()) {
 
@@ -333,15 +560,15 @@ bool OrderBookSim::placeAlgoOrder(const Order* _order, float executeDuration /*=
         return false;
     }
 
-    asio::dispatch(m_strand, 
+    asio::dispatch(m_strand,
         [self = shared_from_this(), order = Order::make_intrusive(*_order),executeDuration, isPriceLimit]() {
 
-            if (auto it = self->m_algoKey2OrderUpdateCallBack.find(order->algoOrderId); it != self->m_algoKey2OrderUpdateCallBack.end()) {
+            if (auto subPtr = self->_findSubscriber(order->algoOrderId)) {
 
-                if (it->second->onOrderUpdate) {
+                if (subPtr->onOrderUpdate) {
                     self->algoPlacerPtr->placeAlgoOrder(order.get(),executeDuration,isPriceLimit
-                        ,it->second->onOrderUpdate
-                        ,it->second->callBackContextPtr);
+                        ,subPtr->onOrderUpdate
+                        ,subPtr->callBackContextPtr);
                 }
             }
         }
@@ -353,31 +580,38 @@ bool OrderBookSim::placeAlgoOrder(const Order* _order, float executeDuration /*=
 bool OrderBookSim::cacelAlgoOrder(const OrderId_t& orderId) {
 
     algoPlacerPtr->cancelAlgoOrder(orderId);
-    
+
     return true;
 }
 
 void OrderBookSim::onDelayTest(agcommon::TimeCost& delay) {
 
     auto self = shared_from_this();
-    asio::post(m_strand, [self,this, delay]() mutable {
 
-        size_t totals = localOrderId2Order.size();
+    for (auto& shard : m_shards) {
 
-        size_t fills=0, cancels = 0, finals = 0;
+        asio::post(shard->strand, [self, shardPtr = shard.get(), delay]() mutable {
 
-        for (auto& [orderId,order_pair] : localOrderId2Order) {
-            auto& order = order_pair.first;
-            if (order->isFinalStatus()) {
-                finals++;
-                if (order->status == agcommon::OrderStatus::FILLED)   { fills++; }
-                if (order->status == agcommon::OrderStatus::CANCELED) { cancels++; }
+            size_t totals = shardPtr->localOrderId2Order.size();
+
+            size_t inflights = shardPtr->pendings.size();
+
+            size_t fills=0, cancels = 0, finals = 0;
+
+            for (auto& [orderId,order_pair] : shardPtr->localOrderId2Order) {
+                auto& order = order_pair.first;
+                if (order->isFinalStatus()) {
+                    finals++;
+                    if (order->status == agcommon::OrderStatus::FILLED)   { fills++; }
+                    if (order->status == agcommon::OrderStatus::CANCELED) { cancels++; }
+                }
             }
-		}
-        std::string suftext = fmt::format("orders:{},finals:{},fills:{},cancels:{},pendings:{}", totals, finals, fills, cancels, totals - finals);
+            std::string suftext = fmt::format("shard:{},orders:{},finals:{},fills:{},cancels:{},pendings:{},inflights:{}"
+                , shardPtr->idx, totals, finals, fills, cancels, totals - finals, inflights);
 
-        delay.logTimeCost(suftext);
-    });
+            delay.logTimeCost(suftext);
+        });
+    }
 }
 
 
@@ -385,18 +619,37 @@ bool OrderBookSim::cancelOrderByOrderId(const OrderId_t& orderId) {
     if (isStopped()) {
         return false;
     }
-    asio::dispatch(m_strand, [self = shared_from_this(), orderId]() {  self->_cancelOrderWithOrderId(orderId); });
+
+    size_t shardIdx = 0;
+    if (m_shards.size() > 1) {
+        std::scoped_lock lock(m_orderIdMutex);
+        auto it = m_orderId2Shard.find(orderId);
+        if (it == m_orderId2Shard.end()) {
+            return false;
+        }
+        shardIdx = it->second;
+    }
+
+    auto& shard = *m_shards[shardIdx];
+
+    asio::dispatch(shard.strand, [self = shared_from_this(), &shard, orderId]() {
+        if (shard.latency.enabled()) {
+            self->_deferRequest(shard, nullptr, orderId);
+            return;
+        }
+        self->_cancelOrderWithOrderId(shard, orderId);
+        self->reconcileAssets(shard); });
     return true;
 }
 
-bool OrderBookSim::_cancelOrderWithOrderId(const OrderId_t& orderId){
+bool OrderBookSim::_cancelOrderWithOrderId(MatchShard& shard, const OrderId_t& orderId){
     if (isStopped()) {
         return false;
     }
 
     SPDLOG_DEBUG("*Cancel*orderId:{}", orderId);
 
-    if (auto it = localOrderId2Order.find(orderId);it != localOrderId2Order.end()) {
+    if (auto it = shard.localOrderId2Order.find(orderId);it != shard.localOrderId2Order.end()) {
 
         auto& order = it->second.first;
 
@@ -417,21 +670,21 @@ bool OrderBookSim::_cancelOrderWithOrderId(const OrderId_t& orderId){
             }
 
             order->cancelQty = order->orderQty - order->filledQty;
-            auto md = getMarketDepth(order->symbol);
+            auto md = getMarketDepth(shard, order->symbolId);
 
             if (md and isBackTest()) {
                 order->updTime = md->quoteTime;
                 //orderIt->second.first = order;
             }
 
-            _onOrderUpdate(order.get(), &preOrder);
+            _onOrderUpdate(shard, order.get(), &preOrder);
 
-            auto& _unfinishs = symbol2UnFinishedOrders[order->symbol];
+            auto& _unfinishs = shard.symbol2UnFinishedOrders[order->symbolId];
             auto& _local_it = it->second.second;
 
             if (order->isFinalStatus()) {
                 _unfinishs.erase(it->second.second);
-                
+
             }
             return true;
         }
@@ -439,44 +692,32 @@ bool OrderBookSim::_cancelOrderWithOrderId(const OrderId_t& orderId){
     return false;
 }
 
-void OrderBookSim::_onOrderUpdate(Order* order, const Order* preOrder) {
+void OrderBookSim::_onOrderUpdate(MatchShard& shard, Order* order, const Order* preOrder) {
+
+    refreshAssetPosition(shard, *order, *preOrder);
 
-    refreshAssetPosition(*order, *preOrder);
+    /* 终态订单不会再被撤单, 移出分片索引 */
+    if (order->isFinalStatus()) {
+        std::scoped_lock lock(m_orderIdMutex);
+        m_orderId2Shard.erase(order->orderId);
+    }
 
     _onOrderUpdate(order);
 }
 
 void OrderBookSim::_onOrderUpdate(Order* order) {
 
-    if (auto it = m_algoKey2OrderUpdateCallBack.find(order->algoOrderId); it != m_algoKey2OrderUpdateCallBack.end()) {
-
-        auto& subcribeInfo = it->second;
+    if (auto subcribeInfo = _findSubscriber(order->algoOrderId)) {
 
         if (subcribeInfo->onOrderUpdate) {
-            if (subcribeInfo->callBackContextPtr) {
-
-                asio::dispatch(*subcribeInfo->callBackContextPtr, [subcribeInfo, orderPtr = boost::intrusive_ptr(order)]() {
-                    subcribeInfo->onOrderUpdate(orderPtr.get()); });
-            }
-            else {
-                subcribeInfo->onOrderUpdate(order);
-            }
+            _notifySubscriber(subcribeInfo, order, nullptr);
         }
     }
 
-    if (auto it = m_orderBookKey2OrderUpdateCallBack.find(order->getOrderBookKey()); it != m_orderBookKey2OrderUpdateCallBack.end()) {
-
-        auto& subcribeInfo = it->second;
+    if (auto subcribeInfo = _findSubscriber(order->getOrderBookKey())) {
 
         if (subcribeInfo->onOrderUpdate) {
-            if (subcribeInfo->callBackContextPtr) {
-
-                asio::dispatch(*subcribeInfo->callBackContextPtr, [subcribeInfo, orderPtr = boost::intrusive_ptr(order)]() {
-                    subcribeInfo->onOrderUpdate(orderPtr.get()); });
-            }
-            else {
-                subcribeInfo->onOrderUpdate(order);
-            }
+            _notifySubscriber(subcribeInfo, order, nullptr);
         }
     }
 
@@ -485,96 +726,97 @@ void OrderBookSim::_onOrderUpdate(Order* order) {
 
 void OrderBookSim::_onTrade(Trade* trade) {
 
-    if (auto it = m_algoKey2OrderUpdateCallBack.find(trade->algoOrderId); it != m_algoKey2OrderUpdateCallBack.end()) {
-
-        auto& subcribeInfo = it->second;
+    if (auto subcribeInfo = _findSubscriber(trade->algoOrderId)) {
 
         if (subcribeInfo->onTrade) {
 
-            if (subcribeInfo->callBackContextPtr) {
-
-                asio::dispatch(*subcribeInfo->callBackContextPtr, [subcribeInfo, tradePtr=boost::intrusive_ptr(trade) ]() {
-                    subcribeInfo->onTrade(tradePtr.get()); });
-            }
-            else {
-                subcribeInfo->onTrade(trade);
-            }
+            _notifySubscriber(subcribeInfo, nullptr, trade);
         }
     }
 
-    if (auto it = m_orderBookKey2OrderUpdateCallBack.find(trade->getOrderBookKey()); it != m_orderBookKey2OrderUpdateCallBack.end()) {
-
-        auto& subcribeInfo = it->second;
+    if (auto subcribeInfo = _findSubscriber(trade->getOrderBookKey())) {
 
         if (subcribeInfo->onTrade) {
 
-            if (subcribeInfo->callBackContextPtr) {
-
-                asio::dispatch(*subcribeInfo->callBackContextPtr, [subcribeInfo, tradePtr = boost::intrusive_ptr(trade)]() {
-                    subcribeInfo->onTrade(tradePtr.get()); });
-            }
-            else {
-                subcribeInfo->onTrade(trade);
-            }
+            _notifySubscriber(subcribeInfo, nullptr, trade);
         }
     }
 
     OrderService::getInstance().onTrade(trade);
 }
 
-/* run on m_strand*/
-void OrderBookSim::onMarketDepth(MarketDepth* md) {
+/* 订阅者 context 内且通道无积压时直接回调, 否则入通道, 保持 order/trade 先后顺序 */
+void OrderBookSim::_notifySubscriber(const std::shared_ptr<SubscribeOrder_t>& subcribeInfo, Order* order, Trade* trade) {
 
-    if (isStopped())
+    auto& channel = subcribeInfo->eventChannel;
+
+    if (not channel or channel->canRunInline()) {
+        if (channel) {
+            channel->recordInline();
+        }
+        if (order) {
+            subcribeInfo->onOrderUpdate(order);
+        }
+        else {
+            subcribeInfo->onTrade(trade);
+        }
         return;
+    }
+
+    channel->publish({ boost::intrusive_ptr<Order>(order), boost::intrusive_ptr<Trade>(trade) });
+}
 
-    asio::dispatch(m_strand, [self=shared_from_this(), md = MarketDepthKeepAlivePtr(md)]() {
+/* 按 SymbolId 进入所属分片的 strand */
+void OrderBookSim::onMarketDepth(MarketDepth* md) {
 
-        //agcommon::TimeCost tc(fmt::format("{},{}",agcommon::getDateTimeStr(md->quoteTime), md->price));
+    if (isStopped() or md->symbolId == InvalidSymbolId)
+        return;
 
-        self->m_mds[md->symbol] = md;
+    auto& shard = shardOf(md->symbolId);
 
-        self->simOrderMatchFill(md.get());
-    });
+    if (not shard.mdChannel or shard.mdChannel->canRunInline()) {
+        if (shard.mdChannel) {
+            shard.mdChannel->recordInline();
+        }
+        _onMarketDepth(shard, md);
+        return;
+    }
+
+    shard.mdChannel->publish({ MarketDepth::keepAlive(md) });
 }
 
-void OrderBookSim::_onMarketDepth(MarketDepth* new_md) {
+void OrderBookSim::_onMarketDepth(MatchShard& shard, MarketDepth* new_md) {
     if (isStopped())
         return;
     SPDLOG_DEBUG("orderBook onMarketDepth:{}", new_md->to_string());
-    new_md->retainAlive();
-    auto it = m_mds.find(new_md->symbol);
-    if (it != m_mds.end()) {
-        it->second->release();
-        it->second = new_md;
-    }
-    else {
-        m_mds[new_md->symbol] = new_md;
-    }
-    simOrderMatchFill(new_md);
+    auto& md = shard.mds[new_md->symbolId];
+    MarketDepth::keepAliveInto(md, new_md);     // 上一笔已无他人引用时原地覆盖
+    simOrderMatchFill(shard, md.get());
+    _advanceClock(shard, md.get());
+    reconcileAssets(shard);
 }
 
-MarketDepth* OrderBookSim::getMarketDepth(const Symbol_t& symbol) {
+MarketDepth* OrderBookSim::getMarketDepth(MatchShard& shard, SymbolId_t symbolId) {
 
-    if (auto it = m_mds.find(symbol);it != m_mds.end()) {
-        return it->second.get();
+    if (auto md = shard.mds.find(symbolId)) {
+        return md->get();
     }
     return nullptr;
 }
 
 
-void OrderBookSim::simOrderMatchFill(const MarketDepth* const md) {
+void OrderBookSim::simOrderMatchFill(MatchShard& shard, const MarketDepth* const md) {
 
-    if (not agcommon::AshareMarketTime::isInMarketContinueTradingTime(md->quoteTime)) {
+    if (not agcommon::AshareMarketTime::isInMarketContinueTradingTime(md->quoteNs)) {
         return;
     }
 
-    auto& _unfinishs = symbol2UnFinishedOrders[md->symbol];
+    auto& _unfinishs = shard.symbol2UnFinishedOrders[md->symbolId];
 
     //SPDLOG_INFO("[{}] ORDERS SIZE:{}", md->symbol, _unfinishs.size());
     if (_unfinishs.empty()) {
 
-        for(auto& [symbolKey,pi] : positionInfos){
+        for(auto& [symbolKey,pi] : shard.positionInfos){
             if (pi.symbol == md->symbol) {
                 pi.lastPrice = md->price;
                 pi.mktValue = pi.currentQty * md->price;
@@ -585,7 +827,7 @@ void OrderBookSim::simOrderMatchFill(const MarketDepth* const md) {
 
     for (auto it = _unfinishs.begin(); it != _unfinishs.end();) {
 
-        simOrderMatchFill(it, md);
+        simOrderMatchFill(shard, it, md);
 
         if (it->second.first->isFinalStatus()) {
 
@@ -598,13 +840,15 @@ void OrderBookSim::simOrderMatchFill(const MarketDepth* const md) {
     }
 }
 
-void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const MarketDepth* const md) {
+void OrderBookSim::simOrderMatchFill(MatchShard& shard, UnFinishedOrderMap::iterator& it, const MarketDepth* const md) {
 
     const OrderId_t& orderId = it->first;
 
     OrderPtr        preOrder = it->second.first;
 
-    auto& queueVol = it->second.second;
+    auto& queueVol = it->second.second.queueVol;
+
+    const bool useQueueModel = m_request.fillModel == FillModel::QueuePosition;
 
     auto order  = Order::make_intrusive(*preOrder);
 
@@ -612,10 +856,13 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
 
     int tradeVol = md->deltaVolume;
 
-    auto marketVolPeging = md->getPricezVol(order->orderPrice);
+    /* 委托价换算为最小变动价位整数, 以下与盘口的比较均为整数比较 */
+    const auto orderTicks = md->toTicks(order->orderPrice);
+
+    auto marketVolPeging = md->getPricezVol(orderTicks);
 
-    if (queueVol == -1) {
-        auto marketVolPeging = md->getPricezVol(order->orderPrice);
+    if (queueVol == -1 and not useQueueModel) {
+        auto marketVolPeging = md->getPricezVol(orderTicks);
         queueVol = marketVolPeging > 0 ? marketVolPeging : -1;
 
     }
@@ -626,7 +873,7 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
     }
     if (order->orderPrice == 0) {
         order->status = agcommon::OrderStatus::REJECTED;
-        SPDLOG_ERROR("[{},{}]orderId:{},price:0,askPrice1:{:.3f},bidPrice1:{:.3f},qt:{}", order->acctType, order->acct, order->orderId,md->askPrice1,md->bidPrice1,agcommon::getTimeStr(md->quoteTime));
+        SPDLOG_ERROR("[{},{}]orderId:{},price:0,askPrice1:{:.3f},bidPrice1:{:.3f},qt:{}", order->acctType, order->acct, order->orderId,md->askPrices[0],md->bidPrices[0],agcommon::getTimeStr(md->quoteTime));
     }
 
     auto trade = Trade::make_intrusive();
@@ -635,6 +882,7 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
     trade->acctType = order->acctType;
     trade->acct     = order->acct;
     trade->symbol    = order->symbol;
+    trade->symbolId  = order->symbolId;
     trade->tradeSide = order->tradeSide;
     trade->price = 0;
     trade->filledQty = 0;
@@ -644,16 +892,18 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
 
     if (agcommon::isBuy(order->tradeSide)) {
 
-        bool isAggressFilled = order->orderPrice >= md->askPrice1 && md->askPrice1 > 0;
+        bool isAggressFilled = orderTicks >= md->askTicks[0] && md->askTicks[0] > 0;
 
-        bool isPegFilled = order->orderPrice < md->askPrice1 && md->bidPrice1 > 0 
-            && (order->orderPrice - md->bidPrice1)>-0.00001 && (-0.00001 <= order->orderPrice - md->price);
+        bool isPegFilled = orderTicks < md->askTicks[0] && md->bidTicks[0] > 0
+            && orderTicks >= md->bidTicks[0] && orderTicks >= md->lastTicks;
         
         SPDLOG_DEBUG("[aId:{}]{},isAggressFilled:{},isPegFilled:{},orderPrice:{},{}/{},fillq:{}", order->algoOrderId, order->orderId, isAggressFilled, isPegFilled
-            ,order->orderPrice, md->bidPrice1, md->askPrice1, order->filledQty);
+            ,order->orderPrice, md->bidPrices[0], md->askPrices[0], order->filledQty);
         
         if (isAggressFilled) {
-            auto [matchQty,matchAmout] = md->tryMathWithinPrice(agcommon::QuoteSide::Ask, order->orderPrice, order->orderQty-order->filledQty);
+            auto [matchQty,matchAmout] = useQueueModel
+                ? QueuePositionModel::matchAggressive(md, agcommon::QuoteSide::Ask, orderTicks, order->orderQty - order->filledQty)
+                : md->tryMathWithinPrice(agcommon::QuoteSide::Ask, orderTicks, order->orderQty-order->filledQty);
             trade->filledQty = matchQty;
             trade->filledAmt = matchAmout;
             trade->price     = matchAmout / matchQty;
@@ -662,6 +912,9 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
                 order->status = agcommon::OrderStatus::FILLED;
             }
         }
+        else if (useQueueModel) {
+            _fillPassive(it->second.second, *order, *trade, md);
+        }
         else {
             if (isPegFilled) {
 
@@ -693,12 +946,14 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
 
     else {
 
-        auto isAggressFilled = order->orderPrice <= md->bidPrice1 && order->orderPrice > 0;
-        auto isPegFilled = order->orderPrice > md->bidPrice1 && order->orderPrice <= md->askPrice1 && (md->price - order->orderPrice >= 0.00001);
+        auto isAggressFilled = orderTicks <= md->bidTicks[0] && orderTicks > 0;
+        auto isPegFilled = orderTicks > md->bidTicks[0] && orderTicks <= md->askTicks[0] && md->lastTicks > orderTicks;
         SPDLOG_DEBUG("[aId:{}]{},isAggressFilled:{},isPegFilled:{},orderPrice:{},{}/{},fillq:{}", order->algoOrderId, order->orderId, isAggressFilled, isPegFilled
-            , order->orderPrice, md->bidPrice1, md->askPrice1, order->filledQty);
+            , order->orderPrice, md->bidPrices[0], md->askPrices[0], order->filledQty);
         if (isAggressFilled){
-            auto [matchQty, matchAmout] = md->tryMathWithinPrice(agcommon::QuoteSide::Bid, order->orderPrice, order->orderQty - order->filledQty);
+            auto [matchQty, matchAmout] = useQueueModel
+                ? QueuePositionModel::matchAggressive(md, agcommon::QuoteSide::Bid, orderTicks, order->orderQty - order->filledQty)
+                : md->tryMathWithinPrice(agcommon::QuoteSide::Bid, orderTicks, order->orderQty - order->filledQty);
             trade->filledQty = matchQty;
             trade->filledAmt = matchAmout;
             trade->price = matchAmout / matchQty;
@@ -707,6 +962,9 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
                 order->status = agcommon::OrderStatus::FILLED;
             }
         }
+        else if (useQueueModel) {
+            _fillPassive(it->second.second, *order, *trade, md);
+        }
         else  {
             if (isPegFilled) {
                 queueVol = queueVol - tradeVol;
@@ -735,8 +993,8 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
             order->avgPrice = order->filledAmt / order->filledQty;
         }
     }
-    if (queueVol > 0) {
-        auto marketVolPeging = md->getPricezVol(order->orderPrice);
+    if (queueVol > 0 and not useQueueModel) {
+        auto marketVolPeging = md->getPricezVol(orderTicks);
         if(marketVolPeging >0)
             queueVol = std::min(marketVolPeging, queueVol);
     }
@@ -750,9 +1008,9 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
 
         it->second.first = order;
 
-        localOrderId2Order[order->orderId] = std::pair(order, it);
+        shard.localOrderId2Order[order->orderId] = std::pair(order, it);
 
-        _onOrderUpdate(order.get(), preOrder.get());
+        _onOrderUpdate(shard, order.get(), preOrder.get());
 
         if (trade->filledQty > 0) {
 
@@ -764,3 +1022,18 @@ void OrderBookSim::simOrderMatchFill(UnFinishedOrderMap::iterator& it, const Mar
     }
 
 }
+
+void OrderBookSim::_fillPassive(QueueState& state, Order& order, Trade& trade, const MarketDepth* const md) {
+
+    auto fillQty = QueuePositionModel::matchPassive(state, order, md);
+    if (fillQty <= 0) {
+        return;
+    }
+
+    trade.filledQty  = fillQty;
+    trade.price      = order.orderPrice;
+    trade.filledAmt  = trade.price * fillQty;
+    order.filledQty += fillQty;
+
+    order.status = order.filledQty >= order.orderQty ? agcommon::OrderStatus::FILLED : agcommon::OrderStatus::PARTIALFILLED;
+}
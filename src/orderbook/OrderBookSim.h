@@ -1,5 +1,7 @@
 #pragma once
 
+#include <shared_mutex>
+#include <queue>
 #include "typedefs.h"
 #include "common.h"
 #include "PositionInfo.h"
@@ -8,9 +10,21 @@
 #include "MarketDepth.h"
 #include "OrderBook.h"
 #include "AlgoPlacer.h"
+#include "QuoteFeed.h"
+#include "QueuePositionModel.h"
+#include "LatencyModel.h"
 
 constexpr int64_t SIMACCT_DEFAUL_CAPITAL = 5'000'000;
 
+/*
+* 撮合状态按 SymbolId 分片, 每片一个 strand: 行情, 下单, 撤单只进入所属分片
+*   持仓按 (acct,symbol) 归属分片, 分片内维护
+*   资金跨分片: 分片内累计可用资金变动, 每次分片任务结束时加锁批量并入 acctAssetInfos
+*   订阅表在 m_strand 上修改, 分片读取, 由 m_subMutex 保护
+* SIMLIVE 按 [ORDERBOOK]MatchShards 分片(0: CPU核数/2), 回测/SIMCUST 单分片且使用 m_strand, 保持与行情/算法同线程
+* 开启 [LATENCY] 时, 下单/撤单按仿真时间延迟到达: 进入分片的请求队列, 分片时钟(已处理行情的最新时间)越过到达时刻后才撮合,
+*   不使用定时器, 回放墙钟不受影响
+*/
 class OrderBookSim : public OrderBook {
 
 public:
@@ -48,67 +62,140 @@ public:
 
     bool cacelAlgoOrder(const OrderId_t& orderId) override;
 
-    size_t  getOrderSize() override { return localOrderId2Order.size(); };
+    size_t  getOrderSize() override { return m_orderCount.load(std::memory_order_relaxed); };
 
 private:
 
-    MarketDepth* getMarketDepth(const Symbol_t& symbol);
+    using OrderPtr = boost::intrusive_ptr<Order>;
+
+    using UnFinishedOrderMap = std::map<OrderId_t, std::pair<OrderPtr, QueueState>>;  // won't relocate
+
+    using MarketDepthStrandChannel = EventChannel<MarketDepthEvent, asio::io_context::strand>;
+
+    /* 延迟中的下单(order 非空)或撤单 */
+    struct PendingRequest {
+
+        QuoteTime_t     arrival{};
+
+        uint64_t        seq{ 0 };
+
+        OrderPtr        order{ nullptr };
+
+        OrderId_t       cancelOrderId{ 0 };
+
+        inline bool operator>(const PendingRequest& other) const {
+            return std::tie(arrival, seq) > std::tie(other.arrival, other.seq);
+        }
+    };
+
+    struct MatchShard {
+
+        MatchShard(size_t i, const asio::io_context::strand& s, uint64_t seed) :idx(i), strand(s), latency(seed) {}
+
+        size_t                                                          idx{ 0 };
+
+        asio::io_context::strand                                        strand;
+
+        SymbolVector<MarketDepthKeepAlivePtr>                           mds{};
+
+        SymbolVector<UnFinishedOrderMap>                                symbol2UnFinishedOrders{};
+
+        std::unordered_map<OrderId_t, std::pair<OrderPtr, UnFinishedOrderMap::iterator>> localOrderId2Order{};
+
+        std::map<SymbolKey_t, PositionInfo>                             positionInfos{};
+
+        std::map<AcctKey_t, double>                                     balanceDeltas{};    // 待并入 acctAssetInfos
+
+        std::shared_ptr<MarketDepthStrandChannel>                       mdChannel{ nullptr };   // 行情 -> strand
+
+        LatencyModel                                                    latency;
+
+        QuoteTime_t                                                     clock{ boost::posix_time::min_date_time };
+
+        QuoteTime_t                                                     lastArrival{ boost::posix_time::min_date_time };   // 同一分片按提交顺序到达
+
+        uint64_t                                                        pendingSeq{ 0 };
+
+        std::priority_queue<PendingRequest, std::vector<PendingRequest>, std::greater<>> pendings{};
+    };
+
+    std::vector<std::unique_ptr<MatchShard>>    m_shards{};
+
+    inline MatchShard& shardOf(SymbolId_t symbolId) {
+        return *m_shards[m_shards.size() == 1 ? 0 : symbolId % m_shards.size()];
+    }
+
+    MarketDepth* getMarketDepth(MatchShard& shard, SymbolId_t symbolId);
 
     std::map<PositionKey_t, std::map<Symbol_t, PositionInfo>> init_positions{};
 
-    std::map<SymbolKey_t, PositionInfo> positionInfos{};
+    std::mutex                          m_assetMutex;
 
     std::map<AcctKey_t, AssetInfo>      acctAssetInfos{};
 
-    UnorderMarketDepthPtrMap            m_mds{};
+    std::mutex                          m_orderIdMutex;
+
+    std::unordered_map<OrderId_t, uint32_t> m_orderId2Shard{};     // 撤单按 orderId 找分片
+
+    std::atomic<size_t>                 m_orderCount{ 0 };
 
     std::map<std::string, std::function<void(const Order*)>>              routerKey2OnOrderUpdate{};
 
+    std::shared_mutex                   m_subMutex;
+
     std::unordered_map<uint64_t, std::shared_ptr<SubscribeOrder_t>>       m_algoKey2OrderUpdateCallBack;
 
     std::unordered_map<OrderBookKey_t, std::shared_ptr<SubscribeOrder_t>, OrderBookKey_t::Hash> m_orderBookKey2OrderUpdateCallBack;
 
-    using OrderPtr = boost::intrusive_ptr<Order>;
+    std::shared_ptr<AlgoPlacer>  algoPlacerPtr;
+
+    std::shared_ptr<OrderBookSim> shared_from_this();
 
-    using UnFinishedOrderMap = std::map<OrderId_t, std::pair<OrderPtr, int32_t>>;  // won't relocate
+    void refreshAssetPosition(MatchShard& shard, const Order& order, const Order& preOrder);
 
-    std::unordered_map<Symbol_t, UnFinishedOrderMap>                   symbol2UnFinishedOrders{};
+    /* 分片内累计的资金变动并入 acctAssetInfos */
+    void reconcileAssets(MatchShard& shard);
 
-private:
-    std::unordered_map<OrderId_t, std::pair<OrderPtr, UnFinishedOrderMap::iterator>>       localOrderId2Order{};
+    void simOrderMatchFill(MatchShard& shard, const MarketDepth* const md);
 
-    std::shared_ptr<AlgoPlacer>  algoPlacerPtr;
+    void simOrderMatchFill(MatchShard& shard, UnFinishedOrderMap::iterator& it, const MarketDepth* const md);
 
-    std::shared_ptr<OrderBookSim> shared_from_this();
+    /* FillModel::QueuePosition 被动成交, 成交价为委托价 */
+    void _fillPassive(QueueState& state, Order& order, Trade& trade, const MarketDepth* const md);
 
-    void refreshAssetPosition(const Order& order, const Order& preOrder);
+    /* arrival: 延迟模型下委托到达交易所的时刻, 缺省为立即到达 */
+    bool _placeOrder(MatchShard& shard, const OrderPtr& order, bool isExist, const QuoteTime_t& arrival = boost::posix_time::min_date_time);
 
-    void simOrderMatchFill(const MarketDepth* const md);
+    /* 按延迟模型计算到达时刻后入分片请求队列 */
+    void _deferRequest(MatchShard& shard, const OrderPtr& order, const OrderId_t cancelOrderId);
 
-    void simOrderMatchFill(UnFinishedOrderMap::iterator& it, const MarketDepth* const md);
+    /* 行情推进分片时钟, 之后处理已到达的请求 */
+    void _advanceClock(MatchShard& shard, const MarketDepth* const md);
 
-    bool _placeOrder(const OrderPtr& order);
+    /* 停止前处理在途请求: 撤单照常送达, 委托以拒单结束 */
+    void _flushPendings(MatchShard& shard);
 
-    bool _cancelOrderWithOrderId(const OrderId_t& orderId);
+    bool _cancelOrderWithOrderId(MatchShard& shard, const OrderId_t& orderId);
 
-    void _onOrderUpdate(Order* order, const Order* preOrder);
+    void _onOrderUpdate(MatchShard& shard, Order* order, const Order* preOrder);
 
     void _onOrderUpdate(Order* order);
 
     void _onTrade(Trade* trade);
 
+    void _notifySubscriber(const std::shared_ptr<SubscribeOrder_t>& subcribeInfo, Order* order, Trade* trade);
+
+    std::shared_ptr<SubscribeOrder_t> _findSubscriber(const uint64_t algoOrderId);
+
+    std::shared_ptr<SubscribeOrder_t> _findSubscriber(const OrderBookKey_t& orderBookKey);
+
     SubscribeOrderKey_t _subscribe(std::shared_ptr<SubscribeOrder_t> subPtr);
 
     void     _unSubscribe(const SubscribeOrderKey_t& subcribeKey);
 
-    void     _onMarketDepth(MarketDepth* md);
-
-    //std::shared_mutex m_mutex;
+    void     _onMarketDepth(MatchShard& shard, MarketDepth* md);
 };
 
 using OrderBookSimCust = OrderBookSim;
 
 using OrderBookLive    = OrderBookSim;    // adator to broker
-
-
-
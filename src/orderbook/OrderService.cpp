@@ -184,7 +184,7 @@ bool OrderService::cancelOrderByOrderId(const OrderBookKey_t& orderBookKey, cons
 
 void OrderService::onOrderUpdate(const Order* order) {
 
-	auto msgPtr = std::make_shared<AlgoMsg::MsgOrderInfo>();
+	auto msgPtr = MessagePool::getInstance().create<AlgoMsg::MsgOrderInfo>();
 
 	msgPtr->set_order_id(order->orderId);
 	msgPtr->set_acct(order->acct);
@@ -222,7 +222,7 @@ void OrderService::onOrderUpdate(const Order* order) {
 
 void OrderService::onTrade(const Trade* trade) {
 
-	auto msgPtr = std::make_shared<AlgoMsg::MsgTradeInfo>();
+	auto msgPtr = MessagePool::getInstance().create<AlgoMsg::MsgTradeInfo>();
 
 	msgPtr->set_trade_id(trade->tradeId);
 	msgPtr->set_order_id(trade->orderId);
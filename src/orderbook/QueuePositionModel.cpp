@@ -0,0 +1,126 @@
+#include "QueuePositionModel.h"
+#include "StockDataTypes.h"
+
+void QueuePositionModel::onPlaced(QueueState& state, const Order& order, const MarketDepth* md, const SecurityStaticInfo* ssinfo) {
+
+    state = QueueState{};
+    state.ssinfo = ssinfo;
+
+    if (md == nullptr or order.orderPrice <= 0) {
+        return;
+    }
+
+    state.quoteNs = md->quoteNs;
+
+    const bool  isBuy  = agcommon::isBuy(order.tradeSide);
+    const auto  price  = md->toTicks(order.orderPrice);
+    const auto& ticks  = isBuy ? md->bidTicks : md->askTicks;
+    const auto& vols   = isBuy ? md->bidVols  : md->askVols;
+
+    if (auto level = MarketDepth::findLevel(ticks, price); level >= 0) {
+        state.queueVol = vols[level];
+        state.levelVol = vols[level];
+        return;
+    }
+
+    const bool insideSpread = isBuy
+        ? price > md->bidTicks[0]
+        : (price < md->askTicks[0] or md->askTicks[0] == 0);
+
+    if (insideSpread) {
+        state.queueVol = 0;
+        state.levelVol = 0;
+    }
+}
+
+std::pair<int, double> QueuePositionModel::matchAggressive(const MarketDepth* md, agcommon::QuoteSide qs, PriceTicks_t price, int qty) {
+
+    const auto& prices = qs == agcommon::QuoteSide::Ask ? md->askPrices : md->bidPrices;
+    const auto& ticks  = qs == agcommon::QuoteSide::Ask ? md->askTicks  : md->bidTicks;
+    const auto& vols   = qs == agcommon::QuoteSide::Ask ? md->askVols   : md->bidVols;
+
+    int     filledQty    = 0;
+    double  filledAmount = 0;
+
+    for (size_t i = 0; i < MarketDepth::Levels and filledQty < qty; ++i) {
+
+        const auto p = prices[i];
+        const auto t = ticks[i];
+
+        bool withinPrice = qs == agcommon::QuoteSide::Ask ? (t > 0 and t <= price) : (t >= price and price > 0);
+        if (not withinPrice) {
+            break;
+        }
+        auto take     = std::min(vols[i], qty - filledQty);
+        filledQty    += take;
+        filledAmount += p * take;
+    }
+    return std::make_pair(filledQty, filledAmount);
+}
+
+int QueuePositionModel::matchPassive(QueueState& state, const Order& order, const MarketDepth* md) {
+
+    const int    remaining = order.orderQty - order.filledQty;
+    const auto   price     = md->toTicks(order.orderPrice);
+
+    if (remaining <= 0 or price <= 0 or md->quoteNs <= state.quoteNs) {
+        return 0;
+    }
+
+    state.quoteNs = md->quoteNs;
+
+    const bool  isBuy  = agcommon::isBuy(order.tradeSide);
+    const auto& ticks  = isBuy ? md->bidTicks : md->askTicks;
+    const auto& vols   = isBuy ? md->bidVols  : md->askVols;
+
+    const auto level    = MarketDepth::findLevel(ticks, price);
+    const bool hasTrade = md->deltaVolume > 0 and md->lastTicks > 0;
+    const bool atLevel  = hasTrade and md->lastTicks == price;
+    const bool through  = hasTrade and (isBuy ? md->lastTicks < price : md->lastTicks > price);
+
+    const bool insideSpread = isBuy
+        ? price > md->bidTicks[0]
+        : (price < md->askTicks[0] or md->askTicks[0] == 0);
+
+    int levelVol = 0;
+    if (level >= 0) {
+        levelVol = vols[level];
+    }
+    else if (not insideSpread and not through) {
+        return 0;       // 价位退到可见档位之外, 排队状态保持
+    }
+
+    if (state.queueVol < 0) {
+        state.queueVol = levelVol;
+        state.levelVol = levelVol;
+    }
+
+    /* 快照成交量含其他价位: 本价位成交只能来自前方挂单减少或本单 */
+    int traded = 0;
+    if (through) {
+        traded = md->deltaVolume;
+    }
+    else if (atLevel) {
+        traded = std::min(md->deltaVolume, std::max(state.levelVol - levelVol, 0) + remaining);
+    }
+
+    /* 挂单减少中扣除成交后为撤单, 按前方占比计入 */
+    int ahead = state.queueVol;
+    if (state.levelVol > 0 and not through) {
+        auto cancels = std::max(state.levelVol - levelVol - traded, 0);
+        ahead -= static_cast<int>(static_cast<int64_t>(cancels) * ahead / state.levelVol);
+    }
+
+    int fillQty = std::min(std::max(traded - ahead, 0), remaining);
+    if (fillQty < remaining and state.ssinfo) {
+        fillQty = state.ssinfo->floor2FitLotSize(fillQty);
+    }
+
+    state.queueVol = through ? 0 : std::max(ahead - traded, 0);
+    if (level >= 0) {
+        state.queueVol = std::min(state.queueVol, levelVol);
+    }
+    state.levelVol = levelVol;
+
+    return fillQty;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "typedefs.h"
+#include "common.h"
+#include "Order.h"
+#include "MarketDepth.h"
+
+class SecurityStaticInfo;
+
+/* 未成交订单的排队状态 */
+struct QueueState {
+
+    int32_t     queueVol{ -1 };     // 前方排队量; -1: 未知(价位不在可见档位)
+
+    int32_t     levelVol{ -1 };     // 上一笔行情中本价位的挂单量
+
+    QuoteNs_t   quoteNs{ agcommon::qtime::MinNs };     // 已计入的最新行情, 下单当笔不再计入成交
+
+    const SecurityStaticInfo*   ssinfo{ nullptr };      // 部分成交按本证券最小交易单位取整
+};
+
+/*
+* 队列位置模型, 每笔行情 O(档位数):
+*   下单时排在本价位可见挂单量之后, 价位在买卖价差之内时前方为 0
+*   到达时无本标的新行情(md 为空)时排队未知, 以之后第一笔快照的本价位挂单量为前方排队
+*   之后每笔快照: 最新价等于本价位时, 成交量先消耗前方排队, 超出部分成交本单
+*               快照成交量含其他价位, 本价位成交量以 本价位可见挂单减少量 + 本单剩余量 为上限
+*               最新价穿过本价位时, 本价位视为被吃穿
+*               本价位挂单减少中不属于成交的部分视为撤单, 按前方排队占比扣减
+*   主动单按可见档位全量成交
+*/
+class QueuePositionModel {
+
+public:
+
+    static void onPlaced(QueueState& state, const Order& order, const MarketDepth* md, const SecurityStaticInfo* ssinfo);
+
+    /* 返回 {成交量, 成交金额} */
+    static std::pair<int, double> matchAggressive(const MarketDepth* md, agcommon::QuoteSide qs, PriceTicks_t price, int qty);
+
+    /* 返回本单被动成交量, 成交价为委托价 */
+    static int matchPassive(QueueState& state, const Order& order, const MarketDepth* md);
+};
@@ -1,132 +1,139 @@
 #include "LimitedQueue.h"
 
+LimitedQueue::LimitedQueue(const std::size_t shotTickSize, const std::size_t referTickSize)
+    : shotWindowSize(shotTickSize)
+    , referWindowSize(referTickSize)
+    , _shotQueue(shotTickSize)
+    , _referQueue(referTickSize)
+    , _minSeqs(shotTickSize) {
+}
+
 void LimitedQueue::release() {
 
-    while (not _shotQueue.empty()) {
-        _shotQueue.pop_front();
-    }
-    while (not _referQueue.empty()) {
-        _referQueue.pop_front();
-    }
+    _shotQueue.clear();
+    _referQueue.clear();
+    _minSeqs.clear();
 
-    lowPriceMd = nullptr;
+    lowPrice.reset();
 
-    highPriceMd = nullptr;
+    highPrice.reset();
 }
 
 void LimitedQueue::append(MarketDepth* newItem) {
 
-    auto item = MarketDepthKeepAlivePtr(newItem);
-    shotPeriodFlow += item->flow;
-    _shotQueue.push_back(item);
+    const WindowTick item{ newItem->price, newItem->getMidPrice(), newItem->amount, static_cast<int64_t>(newItem->volume), newItem->flow, newItem->quoteNs };
+
+    shotPeriodFlow += item.flow;
 
-    if (_shotQueue.size() > shotWindowSize) {
+    if (_shotQueue.full()) {
 
-        auto drop = _shotQueue.front();
+        const auto dropSeq = _shotSeq - _shotQueue.size();
+        const auto drop    = _shotQueue.front();
         _shotQueue.pop_front();
 
-        shotPeriodAmount = item->amount - drop->amount;
-        shotPeriodVol = item->volume - drop->volume;
-        shotPeriodAvgPrice = shotPeriodVol > 0 ? shotPeriodAmount / shotPeriodVol : item->price;
-        shotPeriodFlow -= drop->flow;
-        shotPeriodInterval = agcommon::AshareMarketTime::getMarketDuration(drop->quoteTime, item->quoteTime);
+        if (_minSeqs.front() == dropSeq) {
+            _minSeqs.pop_front();
+        }
+
+        shotPeriodAmount = item.amount - drop.amount;
+        shotPeriodVol = item.volume - drop.volume;
+        shotPeriodAvgPrice = shotPeriodVol > 0 ? shotPeriodAmount / shotPeriodVol : item.price;
+        shotPeriodFlow -= drop.flow;
+        shotPeriodInterval = agcommon::AshareMarketTime::getMarketDuration(drop.quoteNs, item.quoteNs);
 
-        referPeriodFlow += item->flow;
+        referPeriodFlow += item.flow;
 
         if (referWindowSize > 0) {
-            _referQueue.push_back(drop);
 
-            if (referWindowSize > 0 and _referQueue.size() > referWindowSize) {
-                auto drop = _referQueue.front();
+            if (_referQueue.full()) {
+                const auto referDrop = _referQueue.front();
                 _referQueue.pop_front();
 
-                referPeriodAmount = item->amount - drop->amount;
-                referPeriodVol = item->volume - drop->volume;
-                referPeriodAvgPrice = referPeriodVol > 0 ? referPeriodAmount / referPeriodVol : item->price;
-                referPeriodFlow -= drop->flow;
+                referPeriodAmount = item.amount - referDrop.amount;
+                referPeriodVol = item.volume - referDrop.volume;
+                referPeriodAvgPrice = referPeriodVol > 0 ? referPeriodAmount / referPeriodVol : item.price;
+                referPeriodFlow -= referDrop.flow;
 
-                referPeriodInterval = agcommon::AshareMarketTime::getMarketDuration(drop->quoteTime, item->quoteTime);
+                referPeriodInterval = agcommon::AshareMarketTime::getMarketDuration(referDrop.quoteNs, item.quoteNs);
             }
+            _referQueue.push_back(drop);
         }
     }
 
+    _shotQueue.push_back(item);
+    const auto seq = _shotSeq++;
+
+    while (not _minSeqs.empty() and _tickOf(_minSeqs.back()).price >= item.price) {
+        _minSeqs.pop_back();
+    }
+    _minSeqs.push_back(seq);
 }
 
 const double LimitedQueue::getShotChageRate() const {
-    if (_shotQueue.size() < shotWindowSize) {
+    if (_shotQueue.empty() or _shotQueue.size() < shotWindowSize) {
         return 0;
     }
-    double midPrice = _shotQueue.front()->getMidPrice();
-    auto& md = _shotQueue.back();
-    double shotChange = midPrice > 0 ? (md->price - midPrice) / midPrice * 100 : 0;
+    double midPrice = _shotQueue.front().midPrice;
+    double shotChange = midPrice > 0 ? (_shotQueue.back().price - midPrice) / midPrice * 100 : 0;
     return shotChange;
 }
 
-void LimitedQueue::resetLow(const MarketDepthKeepAlivePtr& newMd) {
-    assert(lowPriceMd == nullptr);
-    if (_shotQueue.size() > 0) {
-        int lowIndex = 0;
-        lowPriceMd = _shotQueue[lowIndex];
-        for (auto i = 1; i < _shotQueue.size(); i++) {
-            if (lowPriceMd->price < _shotQueue[i]->price) {
-                lowPriceMd = _shotQueue[i];
-            }
-        }
+void LimitedQueue::_resetLow(const PricePoint& newPoint) {
+    if (not _shotQueue.empty()) {
+        const auto& low = windowLow();
+        lowPrice = PricePoint{ low.price, low.quoteNs };
     }
     else {
-        lowPriceMd = newMd;
+        lowPrice = newPoint;
     }
 }
 
 bool LimitedQueue::triggerShotMinMax(MarketDepth* _newMd, double rangeRatePercent/* = 2.0*/, double durationConfig /*= 300*/) {
 
-    auto newMd = MarketDepthKeepAlivePtr(_newMd);
-    if (lowPriceMd == nullptr) {
-        resetLow(newMd);
+    const PricePoint newPoint{ _newMd->price, _newMd->quoteNs };
+
+    if (not lowPrice) {
+        _resetLow(newPoint);
     }
     else {
-        if (_shotQueue.size() > 0 and _shotQueue[0]->quoteTime > lowPriceMd->quoteTime and highPriceMd == nullptr) {
-            lowPriceMd = nullptr;
-            resetLow(newMd);
+        if (not _shotQueue.empty() and _shotQueue.front().quoteNs > lowPrice->quoteNs and not highPrice) {
+            _resetLow(newPoint);
         }
-        if (newMd->price <= lowPriceMd->price and newMd->quoteTime > lowPriceMd->quoteTime) {
-            lowPriceMd = newMd;
-            if (highPriceMd) {
-                highPriceMd = nullptr; // 新低时 更新最高价
-            }
+        if (newPoint.price <= lowPrice->price and newPoint.quoteNs > lowPrice->quoteNs) {
+            lowPrice = newPoint;
+            highPrice.reset();  // 新低时 更新最高价
         }
     }
-    double rangeRate = lowPriceMd->price > 0 ? (newMd->price - lowPriceMd->price) / lowPriceMd->price * 100 : 0;
-    //SPDLOG_INFO("{},{:.3f},{},low:{:.3f},{}", newMd->symbol, rangeRate, agcommon::getDateTimeStr(newMd->quoteTime), lowPriceMd->price, agcommon::getDateTimeStr(lowPriceMd->quoteTime));
+    double rangeRate = lowPrice->price > 0 ? (newPoint.price - lowPrice->price) / lowPrice->price * 100 : 0;
 
-    if (rangeRate > rangeRatePercent and highPriceMd == nullptr) {
+    if (rangeRate > rangeRatePercent and not highPrice) {
 
-        highPriceMd = newMd;
+        highPrice = newPoint;
     }
 
     bool isTrig = false;
 
-    if (highPriceMd and newMd->price > highPriceMd->price and newMd->quoteTime > lowPriceMd->quoteTime) {
+    if (highPrice and newPoint.price > highPrice->price and newPoint.quoteNs > lowPrice->quoteNs) {
 
-        auto duration = agcommon::AshareMarketTime::getMarketDuration(highPriceMd->quoteTime, newMd->quoteTime);
+        auto duration = agcommon::AshareMarketTime::getMarketDuration(highPrice->quoteNs, newPoint.quoteNs);
 
-        SPDLOG_DEBUG("trigger signal:{},{:.3f},{},low:{:.3f},{},high:{:.3f},{},duration {:.3f}", newMd->symbol, rangeRate, agcommon::getDateTimeStr(newMd->quoteTime)
-            , lowPriceMd->price, agcommon::getDateTimeStr(lowPriceMd->quoteTime)
-            , highPriceMd->price, agcommon::getDateTimeStr(highPriceMd->quoteTime), duration);
+        SPDLOG_DEBUG("trigger signal:{},{:.3f},{},low:{:.3f},{},high:{:.3f},{},duration {:.3f}", _newMd->symbol, rangeRate, agcommon::getDateTimeStr(agcommon::qtime::toPtime(newPoint.quoteNs))
+            , lowPrice->price, agcommon::getDateTimeStr(agcommon::qtime::toPtime(lowPrice->quoteNs))
+            , highPrice->price, agcommon::getDateTimeStr(agcommon::qtime::toPtime(highPrice->quoteNs)), duration);
 
         if (duration > durationConfig) {
 
-            SPDLOG_INFO("trigger signal:{},{:.3f},{},low:{:.3f},{},high:{:.3f},{},duration {:.3f}", newMd->symbol, rangeRate, agcommon::getDateTimeStr(newMd->quoteTime)
-                , lowPriceMd->price, agcommon::getDateTimeStr(lowPriceMd->quoteTime)
-                , highPriceMd->price, agcommon::getDateTimeStr(highPriceMd->quoteTime), duration);
+            SPDLOG_INFO("trigger signal:{},{:.3f},{},low:{:.3f},{},high:{:.3f},{},duration {:.3f}", _newMd->symbol, rangeRate, agcommon::getDateTimeStr(agcommon::qtime::toPtime(newPoint.quoteNs))
+                , lowPrice->price, agcommon::getDateTimeStr(agcommon::qtime::toPtime(lowPrice->quoteNs))
+                , highPrice->price, agcommon::getDateTimeStr(agcommon::qtime::toPtime(highPrice->quoteNs)), duration);
 
             isTrig = true;
             /* restart watching */
-            lowPriceMd = nullptr;
-            highPriceMd = nullptr;
+            lowPrice.reset();
+            highPrice.reset();
         }
         else {
-            highPriceMd = newMd;
+            highPrice = newPoint;
         }
     }
 
@@ -1,22 +1,79 @@
 #pragma once
 
-#include <deque>
+#include <vector>
+#include <optional>
 #include "MarketDepth.h"
 
-class LimitedQueue {
+/* 窗口内只保留计算所需的标量, 不持有 MarketDepth */
+struct WindowTick {
+
+    double      price{ 0 };
+
+    double      midPrice{ 0 };
+
+    double      amount{ 0 };        // 累计
+
+    int64_t     volume{ 0 };        // 累计
+
+    double      flow{ 0 };
+
+    QuoteNs_t   quoteNs{ 0 };
+};
+
+/* 定长环形缓冲, 容量构造时确定, 之后不再分配 */
+template <typename T>
+class RingBuffer {
 
 public:
 
-    LimitedQueue(const std::size_t shotTickSize, const std::size_t referTickSize) :
-        shotWindowSize(shotTickSize), referWindowSize(referTickSize) {}
+    explicit RingBuffer(std::size_t capacity) : m_items(std::max<std::size_t>(capacity, 1)) {}
 
-    LimitedQueue() = delete;
+    inline std::size_t size()     const { return m_size; }
+    inline std::size_t capacity() const { return m_items.size(); }
+    inline bool        empty()    const { return m_size == 0; }
+    inline bool        full()     const { return m_size == m_items.size(); }
 
-    ~LimitedQueue() {
+    inline const T& operator[](std::size_t i) const { return m_items[(m_head + i) % m_items.size()]; }
+    inline const T& front() const { return m_items[m_head]; }
+    inline const T& back()  const { return (*this)[m_size - 1]; }
 
-        release();
+    /* 满时调用方先 pop_front */
+    inline void push_back(const T& item) {
+        assert(not full());
+        m_items[(m_head + m_size) % m_items.size()] = item;
+        ++m_size;
     }
 
+    inline void pop_front() {
+        m_head = (m_head + 1) % m_items.size();
+        --m_size;
+    }
+
+    inline void pop_back() { --m_size; }
+
+    inline void clear() { m_head = 0; m_size = 0; }
+
+private:
+
+    std::vector<T>  m_items;
+
+    std::size_t     m_head{ 0 };
+
+    std::size_t     m_size{ 0 };
+};
+
+/*
+* shot 窗口 + refer 窗口(接收 shot 窗口移出的 tick), 每个 tick O(1):
+*   区间量/额由首尾累计值相减, flow 维护滚动和, 窗口最低价由单调队列维护(只有 lowPrice 需要回溯窗口)
+*/
+class LimitedQueue {
+
+public:
+
+    LimitedQueue(const std::size_t shotTickSize, const std::size_t referTickSize);
+
+    LimitedQueue() = delete;
+
     void release();
 
     void append(MarketDepth* newItem);
@@ -25,8 +82,6 @@ public:
 
     const double getShotChageRate() const;
 
-    void resetLow(const MarketDepthKeepAlivePtr& newMd);
-
     bool triggerShotMinMax(MarketDepth* _newMd, double rangeRatePercent = 2.0, double durationConfig = 300);
 
     inline std::pair<double, double> getShotAmount() const {
@@ -48,30 +103,41 @@ public:
         return _shotQueue.size() >= shotWindowSize;
     }
 
-    inline std::vector<MarketDepthKeepAlivePtr> get_items() const {
+    /* shot 窗口最早的 tick, 窗口非空时调用 */
+    inline const WindowTick& front() const { return _shotQueue.front(); }
 
-        return std::vector<MarketDepthKeepAlivePtr>(_shotQueue.begin(), _shotQueue.end());
-    }
-    const MarketDepthKeepAlivePtr get_item(std::size_t index) const {
-        if (index >= _shotQueue.size()) {
-            throw std::out_of_range("Index out of range");
-        }
-        return _shotQueue[index];
-    }
+    /* shot 窗口最低价 tick, 同价取最新 */
+    inline const WindowTick& windowLow()  const { return _tickOf(_minSeqs.front()); }
 
 private:
 
     std::size_t shotWindowSize = 15;
     std::size_t referWindowSize = 0;
 
-    std::deque<MarketDepthKeepAlivePtr> _shotQueue;
+    RingBuffer<WindowTick> _shotQueue;
+
+    RingBuffer<WindowTick> _referQueue;
+
+    uint64_t               _shotSeq{ 0 };       // 已进入 shot 窗口的 tick 数, 窗口首个序号 = _shotSeq - size()
+
+    RingBuffer<uint64_t>   _minSeqs;            // 价格递增的单调队列
+
+    inline const WindowTick& _tickOf(uint64_t seq) const { return _shotQueue[seq - (_shotSeq - _shotQueue.size())]; }
+
+    /* 触发状态, 只记价格和时间 */
+    struct PricePoint {
+
+        double      price{ 0 };
 
-    std::deque<MarketDepthKeepAlivePtr> _referQueue;
+        QuoteNs_t   quoteNs{ 0 };
+    };
 
-    MarketDepthKeepAlivePtr lowPriceMd = nullptr;
+    std::optional<PricePoint> lowPrice{};
 
-    MarketDepthKeepAlivePtr highPriceMd = nullptr;
+    std::optional<PricePoint> highPrice{};
 
+    /* 最低点重置为窗口最低价 */
+    void _resetLow(const PricePoint& newPoint);
 
 public:
 
@@ -1,19 +1,32 @@
 #include "MarketDepth.h"
 #include "H5DataTypes.h"
+#include "MessagePool.h"
 
 
 MarketDepth::MarketDepth(const Symbol_t& _symbol, const OrderTime_t& quoteTime ) 
     :symbol{ _symbol }
-    , quoteTime(quoteTime) {
+    , symbolId{ _symbol.empty() ? InvalidSymbolId : SymbolTable::getInstance().intern(_symbol) }
+    , priceTick(agcommon::PriceTick::ofSymbol(_symbol))
+    , quoteTime(quoteTime)
+    , quoteNs(agcommon::qtime::fromPtime(quoteTime)) {
 };
 
-MarketDepth::MarketDepth(const h5data::Tick* tick, float _preClose, int64_t _share_circ) {
-
-    auto exchange = (agcommon::MarketExchange)tick->exchange;
+MarketDepth::MarketDepth(const h5data::Tick* tick, float _preClose, int64_t _share_circ)
+    :MarketDepth(fmt::format("{:06}.{}", tick->symbol, agcommon::getMarketExchangeStrCode((agcommon::MarketExchange)tick->exchange))
+        , InvalidSymbolId, agcommon::PriceTick{}, tick, _preClose, _share_circ) {
+    symbolId  = SymbolTable::getInstance().intern(symbol);
+    priceTick = agcommon::PriceTick::ofSymbol(symbol);
+    syncTicks();
+}
 
-    symbol = fmt::format("{:06}.{}", tick->symbol, agcommon::getMarketExchangeStrCode(exchange));
+/* symbol/symbolId/priceTick 由调用方提供, 回放时避免每个 tick 格式化字符串及查表 */
+MarketDepth::MarketDepth(const Symbol_t& _symbol, SymbolId_t _symbolId, const agcommon::PriceTick& _priceTick, const h5data::Tick* tick, float _preClose, int64_t _share_circ)
+    :symbol{ _symbol }
+    , symbolId{ _symbolId }
+    , priceTick{ _priceTick } {
 
-    quoteTime = agcommon::AshareMarketTime::convert2ShanghaiTZ(tick->created_at);
+    quoteNs   = agcommon::qtime::fromUtcSeconds(tick->created_at);
+    quoteTime = agcommon::qtime::toPtime(quoteNs);
 
     preClose = _preClose;
 
@@ -27,29 +40,11 @@ MarketDepth::MarketDepth(const h5data::Tick* tick, float _preClose, int64_t _sha
     change  = price - preClose;
     changeP = preClose > 0 ? change / preClose : 0;
 
-    askPrice1 = tick->ask_price1;
-    askPrice2 = tick->ask_price2;
-    askPrice3 = tick->ask_price3;
-    askPrice4 = tick->ask_price4;
-    askPrice5 = tick->ask_price5;
-
-    askVol1 = tick->ask_volume1;
-    askVol2 = tick->ask_volume2;
-    askVol3 = tick->ask_volume3;
-    askVol4 = tick->ask_volume4;
-    askVol5 = tick->ask_volume5;
-
-    bidPrice1 = tick->bid_price1;
-    bidPrice2 = tick->bid_price2;
-    bidPrice3 = tick->bid_price3;
-    bidPrice4 = tick->bid_price4;
-    bidPrice5 = tick->bid_price5;
-
-    bidVol1 = tick->bid_volume1;
-    bidVol2 = tick->bid_volume2;
-    bidVol3 = tick->bid_volume3;
-    bidVol4 = tick->bid_volume4;
-    bidVol5 = tick->bid_volume5;
+    askPrices = { tick->ask_price1, tick->ask_price2, tick->ask_price3, tick->ask_price4, tick->ask_price5 };
+    askVols   = { tick->ask_volume1, tick->ask_volume2, tick->ask_volume3, tick->ask_volume4, tick->ask_volume5 };
+
+    bidPrices = { tick->bid_price1, tick->bid_price2, tick->bid_price3, tick->bid_price4, tick->bid_price5 };
+    bidVols   = { tick->bid_volume1, tick->bid_volume2, tick->bid_volume3, tick->bid_volume4, tick->bid_volume5 };
 
     deltaAmount = tick->last_amount;
 
@@ -57,125 +52,86 @@ MarketDepth::MarketDepth(const h5data::Tick* tick, float _preClose, int64_t _sha
 
     turnRate = _share_circ > 0 ? tick->cum_volume * 100.0 / _share_circ : 0;
 
+    syncTicks();
 }
 
-std::vector<std::pair<double,int>> MarketDepth::getAskQuotes() const {
-    std::vector<std::pair<double,int>> quotes{
-        {askPrice1,askVol1},
-        {askPrice2,askVol2},
-        {askPrice3,askVol3},
-        {askPrice4,askVol4},
-        {askPrice5,askVol5}
-    };
-    return quotes;
+void MarketDepth::syncTicks() {
+
+    lastTicks = priceTick.toTicks(price);
+    for (size_t i = 0; i < Levels; ++i) {
+        bidTicks[i] = priceTick.toTicks(bidPrices[i]);
+        askTicks[i] = priceTick.toTicks(askPrices[i]);
+    }
 }
 
-std::vector<std::pair<double,int>> MarketDepth::getBidQuotes() const {
+MarketDepth::Quotes_t MarketDepth::getAskQuotes() const {
 
-    std::vector<std::pair<double,int>> quotes{
-        {bidPrice1,bidVol1},
-        {bidPrice2,bidVol2},
-        {bidPrice3,bidVol3},
-        {bidPrice4,bidVol4},
-        {bidPrice5,bidVol5}
-    };
+    Quotes_t quotes{};
+    for (size_t i = 0; i < Levels; ++i) {
+        quotes[i] = { askPrices[i], askVols[i] };
+    }
     return quotes;
 }
 
-std::unordered_map<double,int> MarketDepth::getPrice2VolMap(const agcommon::QuoteSide qs) const {
-    if (qs == agcommon::QuoteSide::Ask) {
-        std::unordered_map<double, int> price2vol{
-			{askPrice1,askVol1},
-			{askPrice2,askVol2},
-			{askPrice3,askVol3},
-			{askPrice4,askVol4},
-			{askPrice5,askVol5}
-		};
-		return price2vol;
-    }
-    if (qs == agcommon::QuoteSide::Bid) {
-        std::unordered_map<double, int> price2vol{
-            {bidPrice1,bidVol1},
-            {bidPrice2,bidVol2},
-            {bidPrice3,bidVol3},
-            {bidPrice4,bidVol4},
-            {bidPrice5,bidVol5}
-        };
-        return price2vol;
-    }
+MarketDepth::Quotes_t MarketDepth::getBidQuotes() const {
 
-    std::unordered_map<double,int> price2vol{
-        {bidPrice1,bidVol1},
-        {bidPrice2,bidVol2},
-        {bidPrice3,bidVol3},
-        {bidPrice4,bidVol4},
-        {bidPrice5,bidVol5},
-        {askPrice1,askVol1},
-        {askPrice2,askVol2},
-        {askPrice3,askVol3},
-        {askPrice4,askVol4},
-        {askPrice5,askVol5}
-    };
-    return price2vol;
+    Quotes_t quotes{};
+    for (size_t i = 0; i < Levels; ++i) {
+        quotes[i] = { bidPrices[i], bidVols[i] };
+    }
+    return quotes;
 }
 
-int MarketDepth::getPricezVol(const double price) const {
+/* 同价时买盘优先, 与原先 {bid1..5, ask1..5} 构造的 price2vol map 取值一致 */
+int MarketDepth::getPricezVol(const PriceTicks_t price) const {
 
-    auto price2vol = getPrice2VolMap(agcommon::QuoteSide::Both);
-    if (price2vol.find(price) != price2vol.end()) {
-		return price2vol[price];
-	}
+    if (auto level = findLevel(bidTicks, price); level >= 0) {
+        return bidVols[level];
+    }
+    if (auto level = findLevel(askTicks, price); level >= 0) {
+        return askVols[level];
+    }
     return 0;
 }
-std::pair<int,double> MarketDepth::tryMathWithinPrice(agcommon::QuoteSide qs, double price,int qty) const {
+
+std::pair<int,double> MarketDepth::tryMathWithinPrice(agcommon::QuoteSide qs, PriceTicks_t price,int qty) const {
     const double tryMatchPercent = 0.2;
     int     mathQty = 0;
     double  filledAmount = 0;
     int     filledQty = 0;
-    if (qs == agcommon::QuoteSide::Ask) {
-        auto priceVol = getAskQuotes();
-        for (const auto& [p, vol] : priceVol) {
-            if (p>0 and p <= price) {
-                mathQty      += int(vol * tryMatchPercent);
-                filledQty    += mathQty;
-                filledAmount += p * mathQty;
-                if (filledQty >= qty) {
-                    filledAmount = filledAmount - p * (filledQty - qty);
-                    return std::make_pair(qty, filledAmount);
-                }
-            }
-            else {
-                break;
-            }
-        }
-        return std::make_pair(filledQty, filledAmount);
+
+    if (qs != agcommon::QuoteSide::Ask and qs != agcommon::QuoteSide::Bid) {
+        return std::make_pair(0, 0);
     }
-    else if (qs == agcommon::QuoteSide::Bid) {
-        auto priceVol = getBidQuotes();
-        for (const auto& [p, vol] : priceVol) {
-            if (p >= price and price>0) {
-                mathQty      += int(vol * tryMatchPercent);
-                filledQty    += mathQty;
-                filledAmount += p * mathQty;
-                if (filledQty >= qty) {
-                    filledAmount = filledAmount - p * (filledQty - qty);
-                    return std::make_pair(qty, filledAmount);
-                }
-            }
-            else {
-                break;
-            }
+
+    const auto& prices = qs == agcommon::QuoteSide::Ask ? askPrices : bidPrices;
+    const auto& ticks  = qs == agcommon::QuoteSide::Ask ? askTicks  : bidTicks;
+    const auto& vols   = qs == agcommon::QuoteSide::Ask ? askVols   : bidVols;
+
+    for (size_t i = 0; i < Levels; ++i) {
+        const auto p = prices[i];
+        const auto t = ticks[i];
+
+        bool withinPrice = qs == agcommon::QuoteSide::Ask ? (t > 0 and t <= price) : (t >= price and price > 0);
+        if (not withinPrice) {
+            break;
+        }
+        mathQty      += int(vols[i] * tryMatchPercent);
+        filledQty    += mathQty;
+        filledAmount += p * mathQty;
+        if (filledQty >= qty) {
+            filledAmount = filledAmount - p * (filledQty - qty);
+            return std::make_pair(qty, filledAmount);
         }
-        return std::make_pair(filledQty, filledAmount);
     }
-    return std::make_pair(0, 0);
+    return std::make_pair(filledQty, filledAmount);
 }
 
-std::map<double, int> MarketDepth::calDelta(const MarketDepth* lastMd) {
+const MarketDepth::DeltaDepth& MarketDepth::calDelta(const MarketDepth* lastMd) {
 
-    std::map<double, int> deltaDepth;
+    deltaDepth.clear();
 
-    if (quoteTime > lastMd->quoteTime ) {  
+    if (quoteNs > lastMd->quoteNs ) {  
         if (deltaVolume == 0) {
             deltaVolume = volume - lastMd->volume;
         }
@@ -183,25 +139,23 @@ std::map<double, int> MarketDepth::calDelta(const MarketDepth* lastMd) {
             deltaAmount = amount - lastMd->amount;
         }
 
-        for (auto& [p, v] : getAskQuotes()) { 
-            auto p2vs = lastMd->getPrice2VolMap(agcommon::QuoteSide::Ask);
-            if (p2vs.find(p) != p2vs.end()) {
-                deltaDepth[p] = v - p2vs[p];
+        for (size_t i = 0; i < Levels; ++i) {
+            if (auto level = findLevel(lastMd->askTicks, askTicks[i]); level >= 0) {
+                deltaDepth.set(askTicks[i], askVols[i] - lastMd->askVols[level]);
             }
         }
-        for (auto& [p, v] : getBidQuotes()) { 
-            auto p2vs = lastMd->getPrice2VolMap(agcommon::QuoteSide::Bid);
-            if (p2vs.find(p) != p2vs.end()) {
-                deltaDepth[p] = v - p2vs[p];
+        for (size_t i = 0; i < Levels; ++i) {
+            if (auto level = findLevel(lastMd->bidTicks, bidTicks[i]); level >= 0) {
+                deltaDepth.set(bidTicks[i], bidVols[i] - lastMd->bidVols[level]);
             }
         }
         bsType = 0;
         if (deltaVolume > 0 && deltaAmount > 0) {
 
-            if (deltaAmount/deltaVolume > 0.5 * (lastMd->askPrice1 + lastMd->bidPrice1)) {
+            if (deltaAmount/deltaVolume > 0.5 * (lastMd->askPrices[0] + lastMd->bidPrices[0])) {
                 bsType = 1;
             }
-            else if (deltaAmount / deltaVolume < 0.5 * (lastMd->askPrice1 + lastMd->bidPrice1)) {
+            else if (deltaAmount / deltaVolume < 0.5 * (lastMd->askPrices[0] + lastMd->bidPrices[0])) {
                 bsType = -1;
             }
             flow = bsType * deltaAmount;
@@ -230,33 +184,21 @@ void MarketDepth::parseMapString(std::map<std::string, std::string>& row) {
     change = price - preClose;
     changeP = preClose > 0 ? change / preClose : 0;
 
-    askPrice1 = agcommon::get_float(row["a1_p"]);
-    askPrice2 = agcommon::get_float(row["a2_p"]);
-    askPrice3 = agcommon::get_float(row["a3_p"]);
-    askPrice4 = agcommon::get_float(row["a4_p"]);
-    askPrice5 = agcommon::get_float(row["a5_p"]);
-    askVol1 = agcommon::get_int(row["a1_v"]);
-    askVol2 = agcommon::get_int(row["a2_v"]);
-    askVol3 = agcommon::get_int(row["a3_v"]);
-    askVol4 = agcommon::get_int(row["a4_v"]);
-    askVol5 = agcommon::get_int(row["a5_v"]);
-
-    bidPrice1 = agcommon::get_float(row["b1_p"]);
-    bidPrice2 = agcommon::get_float(row["b2_p"]);
-    bidPrice3 = agcommon::get_float(row["b3_p"]);
-    bidPrice4 = agcommon::get_float(row["b4_p"]);
-    bidPrice5 = agcommon::get_float(row["b5_p"]);
-    bidVol1 = agcommon::get_int(row["b1_v"]);
-    bidVol2 = agcommon::get_int(row["b2_v"]);
-    bidVol3 = agcommon::get_int(row["b3_v"]);
-    bidVol4 = agcommon::get_int(row["b4_v"]);
-    bidVol5 = agcommon::get_int(row["b5_v"]);
+    for (size_t i = 0; i < Levels; ++i) {
+        askPrices[i] = agcommon::get_float(row[fmt::format("a{}_p", i + 1)]);
+        askVols[i]   = agcommon::get_int(row[fmt::format("a{}_v", i + 1)]);
+        bidPrices[i] = agcommon::get_float(row[fmt::format("b{}_p", i + 1)]);
+        bidVols[i]   = agcommon::get_int(row[fmt::format("b{}_v", i + 1)]);
+    }
 
     auto tmp = agcommon::parseDateTimeStr(row["quoteTime"]);
     if (tmp)
         quoteTime = *tmp;
     else
         quoteTime = agcommon::now();
+    quoteNs = agcommon::qtime::fromPtime(quoteTime);
+
+    syncTicks();
 }
 
 std::string MarketDepth::to_string() const {
@@ -272,10 +214,10 @@ std::string MarketDepth::to_string() const {
         symbol,
         formatPrice(price), 
         deltaVolume,
-        formatPrice(bidPrice1),
-        bidVol1,
-        formatPrice(askPrice1),
-        askVol1,
+        formatPrice(bidPrices[0]),
+        bidVols[0],
+        formatPrice(askPrices[0]),
+        askVols[0],
         formatAmount(amount),
         volume                   
     );
@@ -283,7 +225,7 @@ std::string MarketDepth::to_string() const {
 
 std::shared_ptr<AlgoMsg::MsgMarketDepth> MarketDepth::encode2AlgoMessage(uint64_t subscribeKey) const{
     
-    std::shared_ptr<AlgoMsg::MsgMarketDepth> msg = std::make_shared<AlgoMsg::MsgMarketDepth>();
+    std::shared_ptr<AlgoMsg::MsgMarketDepth> msg = MessagePool::getInstance().create<AlgoMsg::MsgMarketDepth>();
     msg->set_symbol(symbol);
     msg->set_quote_time(agcommon::getDateTimeInt(quoteTime));
     msg->set_price(price);
@@ -296,26 +238,26 @@ std::shared_ptr<AlgoMsg::MsgMarketDepth> MarketDepth::encode2AlgoMessage(uint64_
     msg->set_open(open);
     msg->set_low(low);
     msg->set_high(high);
-    msg->set_bid_price1(bidPrice1);
-    msg->set_bid_vol1(bidVol1);
-    msg->set_ask_price1(askPrice1);
-    msg->set_ask_vol1(askVol1);
-    msg->set_bid_price2(bidPrice2);
-    msg->set_bid_vol2(bidVol2);
-    msg->set_ask_price2(askPrice2);
-    msg->set_ask_vol2(askVol2);
-    msg->set_bid_price3(bidPrice3);
-    msg->set_bid_vol3(bidVol3);
-    msg->set_ask_price3(askPrice3);
-    msg->set_ask_vol3(askVol3);
-    msg->set_bid_price4(bidPrice4);
-    msg->set_bid_vol4(bidVol4);
-    msg->set_ask_price4(askPrice4);
-    msg->set_ask_vol4(askVol4);
-    msg->set_bid_price5(bidPrice5);
-    msg->set_bid_vol5(bidVol5);
-    msg->set_ask_price5(askPrice5);
-    msg->set_ask_vol5(askVol5);
+    msg->set_bid_price1(bidPrices[0]);
+    msg->set_bid_vol1(bidVols[0]);
+    msg->set_ask_price1(askPrices[0]);
+    msg->set_ask_vol1(askVols[0]);
+    msg->set_bid_price2(bidPrices[1]);
+    msg->set_bid_vol2(bidVols[1]);
+    msg->set_ask_price2(askPrices[1]);
+    msg->set_ask_vol2(askVols[1]);
+    msg->set_bid_price3(bidPrices[2]);
+    msg->set_bid_vol3(bidVols[2]);
+    msg->set_ask_price3(askPrices[2]);
+    msg->set_ask_vol3(askVols[2]);
+    msg->set_bid_price4(bidPrices[3]);
+    msg->set_bid_vol4(bidVols[3]);
+    msg->set_ask_price4(askPrices[3]);
+    msg->set_ask_vol4(askVols[3]);
+    msg->set_bid_price5(bidPrices[4]);
+    msg->set_bid_vol5(bidVols[4]);
+    msg->set_ask_price5(askPrices[4]);
+    msg->set_ask_vol5(askVols[4]);
     msg->set_turn_rate(turnRate);
     msg->set_subscribe_key(subscribeKey);
 
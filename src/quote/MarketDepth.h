@@ -1,9 +1,13 @@
 #pragma once
 
 #include <map>
+#include <array>
+#include <bit>
 #include "typedefs.h"
 #include "common.h"
 #include "KeepAlive.h"
+#include "SymbolTable.h"
+#include "PriceTick.h"
 #include <boost/unordered_map.hpp>
 #include "H5DataTypes.h"
 
@@ -26,6 +30,8 @@ class MarketDepth: public KeepAlivePool<MarketDepth> {
 public:
     Symbol_t symbol                 {};
 
+    SymbolId_t symbolId             { InvalidSymbolId };
+
     double price    {0};
     double preClose {0};
     double open     {0};
@@ -39,32 +45,79 @@ public:
     double  amount     {0};
     double   avgPrice   {0};
 
-    double   bidPrice1    {0};
-    int     bidVol1      {0};
-
-    double   bidPrice2    {0};
-    int     bidVol2      {0};
-    double   bidPrice3    {0};
-    int     bidVol3      {0};
-    double   bidPrice4    {0};
-    int     bidVol4      {0};
-    double   bidPrice5    {0};
-    int     bidVol5      {0};
-
-    double   askPrice1    {0};
-    int     askVol1      {0};
-    double   askPrice2    {0};
-    int     askVol2      {0};
-    double   askPrice3    {0};
-    int     askVol3      {0};
-    double   askPrice4    {0};
-    int     askVol4      {0};
-    double   askPrice5    {0};
-    int     askVol5      {0};
+    /* 五档盘口, 下标 0 为一档; 按价格/数量分列存放, 档位计算在定长数组上完成, 不分配内存 */
+    static constexpr size_t Levels = 5;
+
+    std::array<double, Levels>  bidPrices   {};
+    std::array<int, Levels>     bidVols     {};
+
+    std::array<double, Levels>  askPrices   {};
+    std::array<int, Levels>     askVols     {};
+
+    /* 定点价格, 由 syncTicks 按 priceTick 从 price/bidPrices/askPrices 换算; 档位比较/撮合使用 */
+    agcommon::PriceTick         priceTick   {};
+
+    PriceTicks_t                lastTicks   { 0 };
+
+    std::array<PriceTicks_t, Levels> bidTicks {};
+    std::array<PriceTicks_t, Levels> askTicks {};
+
+    /* calDelta 结果: 与上一笔行情同价档位的挂单量变化, 按价格升序, 定长内联存储 */
+    struct DeltaDepth {
+
+        static constexpr size_t Capacity = 2 * Levels;
+
+        std::array<PriceTicks_t, Capacity> ticks {};
+        std::array<int, Capacity>       vols    {};
+        uint32_t                        count   { 0 };
+
+        inline size_t size()  const { return count; }
+        inline bool   empty() const { return count == 0; }
+        inline void   clear() { count = 0; }
+
+        inline std::pair<PriceTicks_t, int> operator[](size_t i) const { return { ticks[i], vols[i] }; }
+
+        /* 同价覆盖, 否则按价格有序插入 */
+        inline void set(const PriceTicks_t price, const int vol) {
+            size_t i = 0;
+            while (i < count and ticks[i] < price) {
+                ++i;
+            }
+            if (i < count and ticks[i] == price) {
+                vols[i] = vol;
+                return;
+            }
+            if (count == Capacity) {
+                return;
+            }
+            for (size_t j = count; j > i; --j) {
+                ticks[j] = ticks[j - 1];
+                vols[j]  = vols[j - 1];
+            }
+            ticks[i] = price;
+            vols[i]  = vol;
+            ++count;
+        }
+
+        /* 不存在返回 0 */
+        inline int get(const PriceTicks_t price) const {
+            for (size_t i = 0; i < count; ++i) {
+                if (ticks[i] == price) {
+                    return vols[i];
+                }
+            }
+            return 0;
+        }
+    };
+
+    DeltaDepth  deltaDepth  {};
+
     double   turnRate     { 0.0 };
 
     OrderTime_t quoteTime   { boost::posix_time::min_date_time};
 
+    QuoteNs_t   quoteNs     { agcommon::qtime::MinNs };     // 与 quoteTime 同一时刻, 时段判断/时长计算用
+
     int     bsType          {0};
 
     int     deltaVolume     {0};
@@ -91,20 +144,36 @@ public:
 
     MarketDepth(const h5data::Tick* tick, float _preClose, int64_t _share_circ = 0);
 
-    std::vector<std::pair<double,int>> getAskQuotes() const;
+    MarketDepth(const Symbol_t& _symbol, SymbolId_t _symbolId, const agcommon::PriceTick& _priceTick, const h5data::Tick* tick, float _preClose, int64_t _share_circ = 0);
+
+    /* 修改 price/bidPrices/askPrices 后调用 */
+    void syncTicks();
 
-    std::vector<std::pair<double,int>> getBidQuotes() const;
+    using Quotes_t = std::array<std::pair<double, int>, Levels>;
 
-    std::unordered_map<double,int> getPrice2VolMap(const agcommon::QuoteSide qs) const;
+    Quotes_t getAskQuotes() const;
 
-    std::pair<int, double> tryMathWithinPrice(agcommon::QuoteSide qs, double price, int qty) const;
+    Quotes_t getBidQuotes() const;
 
-    int getPricezVol(const double price) const;
+    std::pair<int, double> tryMathWithinPrice(agcommon::QuoteSide qs, PriceTicks_t price, int qty) const;
+
+    int getPricezVol(const PriceTicks_t price) const;
+
+    inline PriceTicks_t toTicks(double price) const { return priceTick.toTicks(price); }
+
+    /* 价格所在档位下标, 不存在返回 -1; 同价多档时取第一档 */
+    static inline int findLevel(const std::array<PriceTicks_t, Levels>& ticks, const PriceTicks_t price) {
+        unsigned mask = 0;
+        for (size_t i = 0; i < Levels; ++i) {
+            mask |= static_cast<unsigned>(ticks[i] == price) << i;     // 整数无分支比较, 编译器可向量化
+        }
+        return mask ? std::countr_zero(mask) : -1;
+    }
 
     inline double getMidPrice() const {
-        if (askPrice1 > 0 and bidPrice1 > 0)
-            return (askPrice1 + bidPrice1) / 2;
-        return std::max(askPrice1, bidPrice1);
+        if (askPrices[0] > 0 and bidPrices[0] > 0)
+            return (askPrices[0] + bidPrices[0]) / 2;
+        return std::max(askPrices[0], bidPrices[0]);
     }
 
     inline agcommon::MarketExchange getMarketExchange() const { 
@@ -115,7 +184,8 @@ public:
         return agcommon::MarketExchange::unDefined;
     }
 
-    std::map<double, int> calDelta(const MarketDepth* lastMd);
+    /* 计算 deltaVolume/deltaAmount/bsType/flow 及 deltaDepth, 不分配内存 */
+    const DeltaDepth& calDelta(const MarketDepth* lastMd);
 
     void parseMapString(std::map<std::string, std::string>& row);
 
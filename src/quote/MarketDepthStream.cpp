@@ -0,0 +1,182 @@
+#include "MarketDepthStream.h"
+
+std::string MarketDepthStream::Stat::to_string() const {
+
+    return fmt::format("pending:{},highWater:{},pushed:{},popped:{},dropped:{},producerWaits:{},maxLag:{:.1f}us"
+        , pending, highWater, pushed, popped, dropped, producerWaits, maxLagNs / 1000.0);
+}
+
+MarketDepthStream::Batch MarketDepthStream::acquire() {
+
+    std::scoped_lock lock(m_mutex);
+
+    if (m_pool.empty()) {
+        return Batch{};
+    }
+    auto batch = std::move(m_pool.back());
+    m_pool.pop_back();
+    return batch;
+}
+
+void MarketDepthStream::_recycle(Batch&& batch) {
+
+    /* 保留批内对象, 生产者下次 acquire 时原地覆盖复用; 池中批数不超过在途上限, 内存不超过积压峰值 */
+    if (batch.capacity() > 0 and m_pool.size() < m_capacity + 2) {
+        m_pool.push_back(std::move(batch));
+    }
+}
+
+bool MarketDepthStream::push(Batch&& batch) {
+
+    Resume_t wakeConsumer{ nullptr };
+    uint64_t dropped = 0;
+    {
+        std::scoped_lock lock(m_mutex);
+
+        if (m_closed) {
+            return false;
+        }
+
+        while (m_queue.size() >= m_capacity) {
+            _recycle(std::move(m_queue.front().batch));
+            m_queue.pop_front();
+            dropped = ++m_stat.dropped;
+        }
+
+        m_queue.push_back(Entry{ std::move(batch), steadyNowNs() });
+        m_stat.pushed++;
+        m_stat.highWater = std::max(m_stat.highWater, m_queue.size());
+
+        std::swap(wakeConsumer, m_consumerWaiter);
+    }
+
+    if (dropped > 0 and (dropped == 1 or dropped % 1024 == 0)) {
+        SPDLOG_WARN("[aId:{}]MarketDepthStream slow consumer, dropped:{},capacity:{}", m_subscribeKey, dropped, m_capacity);
+    }
+
+    if (wakeConsumer) {
+        wakeConsumer();
+    }
+    return true;
+}
+
+asio::awaitable<bool> MarketDepthStream::co_push(Batch&& batch) {
+
+    if (m_overflow == Overflow::DropOldest) {
+        co_return push(std::move(batch));
+    }
+
+    bool waited = false;
+    while (true) {
+        {
+            std::scoped_lock lock(m_mutex);
+            if (m_closed) {
+                co_return false;
+            }
+            if (m_queue.size() < m_capacity) {
+                break;
+            }
+            if (not waited) {
+                m_stat.producerWaits++;
+                waited = true;
+            }
+        }
+        co_await _park(&MarketDepthStream::m_producerWaiter, [this]() { return m_closed or m_queue.size() < m_capacity; });
+    }
+
+    co_return push(std::move(batch));
+}
+
+bool MarketDepthStream::_tryNext(Batch& batch, Resume_t& wakeProducer) {
+
+    std::scoped_lock lock(m_mutex);
+
+    if (m_queue.empty()) {
+        return false;
+    }
+
+    auto& entry = m_queue.front();
+
+    _recycle(std::move(batch));
+    batch = std::move(entry.batch);
+
+    m_stat.popped++;
+    m_stat.maxLagNs = std::max(m_stat.maxLagNs, steadyNowNs() - entry.enqueueNs);
+
+    m_queue.pop_front();
+
+    std::swap(wakeProducer, m_producerWaiter);
+    return true;
+}
+
+bool MarketDepthStream::tryNext(Batch& batch) {
+
+    Resume_t wakeProducer{ nullptr };
+
+    auto got = _tryNext(batch, wakeProducer);
+
+    if (wakeProducer) {
+        wakeProducer();
+    }
+    return got;
+}
+
+asio::awaitable<bool> MarketDepthStream::next(Batch& batch) {
+
+    while (true) {
+
+        if (tryNext(batch)) {
+            co_return true;
+        }
+
+        if (isClosed()) {
+            std::scoped_lock lock(m_mutex);
+            _recycle(std::move(batch));
+            co_return false;
+        }
+
+        co_await _park(&MarketDepthStream::m_consumerWaiter, [this]() { return m_closed or not m_queue.empty(); });
+    }
+}
+
+void MarketDepthStream::close() {
+
+    Resume_t wakeConsumer{ nullptr }, wakeProducer{ nullptr };
+    {
+        std::scoped_lock lock(m_mutex);
+
+        if (m_closed) {
+            return;
+        }
+        m_closed = true;
+
+        std::swap(wakeConsumer, m_consumerWaiter);
+        std::swap(wakeProducer, m_producerWaiter);
+    }
+
+    SPDLOG_INFO("[aId:{}]MarketDepthStream close,{}", m_subscribeKey, stat().to_string());
+
+    if (wakeConsumer) {
+        wakeConsumer();
+    }
+    if (wakeProducer) {
+        wakeProducer();
+    }
+}
+
+bool MarketDepthStream::isClosed() {
+    std::scoped_lock lock(m_mutex);
+    return m_closed;
+}
+
+size_t MarketDepthStream::pending() {
+    std::scoped_lock lock(m_mutex);
+    return m_queue.size();
+}
+
+MarketDepthStream::Stat MarketDepthStream::stat() {
+    std::scoped_lock lock(m_mutex);
+    auto stat    = m_stat;
+    stat.pending = m_queue.size();
+    return stat;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <deque>
+#include "typedefs.h"
+#include "MarketDepth.h"
+#include "EventBus.h"
+
+/*
+* 拉取式行情订阅: 行情侧按批 push, 订阅者按自身节奏 co_await next(batch)
+*   - 单生产者单消费者; 批内持有 MarketDepth 引用, 回放 arena 对象已拷出
+*   - 批缓冲复用: next 把调用方上一批的存储归还池, 生产者 acquire 从池取; 批内对象保留, 无他人引用时原地覆盖(keepAliveInto)
+*   - 有界 capacity 批: DropOldest 丢最旧批并计数, 不阻塞行情线程(实盘);
+*     Wait 挂起生产者协程直到消费者取走, 不丢数据(回放)
+*   - pending/高水位/丢弃数/积压时长可查, 慢消费者可见
+*/
+class MarketDepthStream : public std::enable_shared_from_this<MarketDepthStream> {
+
+public:
+
+    using Batch = std::vector<MarketDepthKeepAlivePtr>;
+
+    enum class Overflow : uint8_t {
+        DropOldest = 0,
+        Wait       = 1,
+    };
+
+    struct Stat {
+
+        size_t      pending{ 0 };
+
+        size_t      highWater{ 0 };
+
+        uint64_t    pushed{ 0 };
+
+        uint64_t    popped{ 0 };
+
+        uint64_t    dropped{ 0 };
+
+        uint64_t    producerWaits{ 0 };
+
+        int64_t     maxLagNs{ 0 };      // 入队到取走
+
+        std::string to_string() const;
+    };
+
+    static std::shared_ptr<MarketDepthStream> create(uint64_t subscribeKey, size_t capacity, Overflow overflow) {
+        return std::make_shared<MarketDepthStream>(subscribeKey, capacity, overflow);
+    }
+
+    MarketDepthStream(uint64_t subscribeKey, size_t capacity, Overflow overflow)
+        : m_subscribeKey(subscribeKey)
+        , m_capacity(std::max<size_t>(capacity, 1))
+        , m_overflow(overflow) {
+    }
+
+    MarketDepthStream(const MarketDepthStream&) = delete;
+    MarketDepthStream& operator=(const MarketDepthStream&) = delete;
+
+    /* 生产者: 取复用批, 可能含上次的对象, 按需 clear 或 keepAliveInto 覆盖 */
+    Batch acquire();
+
+    /* 生产者: 入队, 满时按 DropOldest 处理; 返回 false 表示已关闭 */
+    bool push(Batch&& batch);
+
+    /* 生产者: 入队, 满时挂起到消费者取走(Wait) */
+    asio::awaitable<bool> co_push(Batch&& batch);
+
+    /* 消费者: 取下一批, batch 原存储归还池; 无数据时挂起, 关闭且取空后返回 false */
+    asio::awaitable<bool> next(Batch& batch);
+
+    /* 不挂起取批 */
+    bool tryNext(Batch& batch);
+
+    /* 唤醒两端, 已入队的批仍可取完 */
+    void close();
+
+    bool isClosed();
+
+    size_t pending();
+
+    Stat stat();
+
+    inline Overflow overflow() const { return m_overflow; }
+
+private:
+
+    struct Entry {
+
+        Batch       batch{};
+
+        int64_t     enqueueNs{ 0 };
+    };
+
+    using Resume_t = std::function<void()>;
+
+    /* 挂起到 resume 被调用; 登记时条件已满足则投递恢复 */
+    template <typename Ready>
+    auto _park(Resume_t MarketDepthStream::* slot, Ready ready) {
+
+        return asio::async_initiate<decltype(asio::use_awaitable), void()>(
+            [this, slot, ready](auto handler) {
+                auto handlerPtr = std::make_shared<decltype(handler)>(std::move(handler));
+                Resume_t resume = [handlerPtr]() { asio::dispatch(std::move(*handlerPtr)); };
+                {
+                    std::scoped_lock lock(m_mutex);
+                    if (not ready()) {
+                        this->*slot = std::move(resume);
+                        return;
+                    }
+                }
+                /* 不在发起栈内恢复 */
+                auto ex = asio::get_associated_executor(*handlerPtr);
+                asio::post(ex, std::move(resume));
+            }, asio::use_awaitable);
+    }
+
+    void _recycle(Batch&& batch);
+
+    bool _tryNext(Batch& batch, Resume_t& wakeProducer);
+
+    uint64_t                m_subscribeKey{ 0 };
+
+    size_t                  m_capacity{ 1 };
+
+    Overflow                m_overflow{ Overflow::DropOldest };
+
+    std::mutex              m_mutex;
+
+    std::deque<Entry>       m_queue{};
+
+    std::vector<Batch>      m_pool{};
+
+    bool                    m_closed{ false };
+
+    Resume_t                m_consumerWaiter{ nullptr };
+
+    Resume_t                m_producerWaiter{ nullptr };
+
+    Stat                    m_stat{};
+};
@@ -1,4 +1,5 @@
 #include "QuoteFeed.h"
+#include "Configs.h"
 
 // OrderBook susbribe QuoteFeed
 void QuoteFeed::regesterOrderBookCallback(const OrderBookKey_t& orderBookKey
@@ -43,3 +44,16 @@ void QuoteFeed::regesterOnQuoteFeedFinish(const std::function<void()>& f,const A
 
 
 
+
+std::shared_ptr<MarketDepthStream> QuoteFeed::subscribeStream(std::shared_ptr<SubMarketDepth_t> subPtr) {
+
+    auto capacity = agcommon::Configs::getConfigs().getConfigOrDefault("DATACONFIG", "StreamCapacity", 256);
+
+    subPtr->stream = MarketDepthStream::create(subPtr->subscribeKey, static_cast<size_t>(std::max(1, capacity)), streamOverflow());
+
+    if (subscribe(subPtr) != subPtr->subscribeKey) {
+        subPtr->stream->close();
+        subPtr->stream = nullptr;
+    }
+    return subPtr->stream;
+}
@@ -2,7 +2,11 @@
 
 #include "common.h"
 #include "MarketDepth.h"
+#include "EventBus.h"
+#include "VirtualClock.h"
+#include "MarketDepthStream.h"
 #include <set>
+#include <span>
 
 using AsioContextPtr = std::shared_ptr<asio::io_context>;
 
@@ -10,10 +14,24 @@ using OnMarketDepthCallback =  std::function<void(MarketDepth*)>;
 
 using co_OnMarketDepthCallback = std::function<asio::awaitable<int>(MarketDepth*)> ;
 
+/* 批量模式: 同一时间戳(回放)或同一批(实盘)的 MarketDepth 一次回调 */
+using OnMarketDepthsCallback = std::function<void(std::span<MarketDepth* const>)>;
+
+using co_OnMarketDepthsCallback = std::function<asio::awaitable<int>(std::span<MarketDepth* const>)>;
+
 using OnDelayTestCallback =  std::function<void(agcommon::TimeCost& delay)>;
 
 using SubscribeKey_t = AlgoOrderId_t;
 
+struct MarketDepthEvent {
+
+    MarketDepthKeepAlivePtr         md{ nullptr };
+
+    int64_t                         enqueueNs{ 0 };
+};
+
+using MarketDepthChannel = EventChannel<MarketDepthEvent, asio::io_context::executor_type>;
+
 struct SubMarketDepth_t {
 
     SubscribeKey_t                  subscribeKey;
@@ -32,6 +50,16 @@ struct SubMarketDepth_t {
 
     OnDelayTestCallback             onDelayTest{ nullptr };
 
+    OnMarketDepthsCallback          onMarketDepths{ nullptr };
+
+    co_OnMarketDepthsCallback       co_onMarketDepths{ nullptr };
+
+    std::shared_ptr<MarketDepthStream>  stream{ nullptr };          // 拉取式订阅, 由 QuoteFeed::subscribeStream 创建
+
+    inline bool isBatched() const { return onMarketDepths or co_onMarketDepths or stream; }
+
+    std::shared_ptr<MarketDepthChannel> mdChannel{ nullptr };       // 跨线程投递时由 QuoteFeed 创建
+
 };
 
 struct QuoteFeedRequest {
@@ -67,6 +95,9 @@ public:
 
     virtual void unSubscribe(const uint64_t subcribeKey) = 0;
 
+    /* 拉取式订阅: subPtr 不需设置回调, 订阅者在返回的 stream 上 co_await next(batch); 失败返回 nullptr */
+    std::shared_ptr<MarketDepthStream> subscribeStream(std::shared_ptr<SubMarketDepth_t> subPtr);
+
     virtual void regesterOrderBookCallback(const OrderBookKey_t& orderRouterKey
         , const OnMarketDepthCallback& onMarketDepth 
         , const OnDelayTestCallback& onDelay = nullptr) ;
@@ -79,6 +110,12 @@ public:
 
     virtual QuoteTime_t getCurrentQuoteTime() { return agcommon::now(); };
 
+    /* 回放仿真时钟, 实时行情为空 */
+    virtual VirtualClock* virtualClock() { return nullptr; };
+
+    /* 拉取式订阅满时的处理, 回放不丢数据 */
+    virtual MarketDepthStream::Overflow streamOverflow() { return MarketDepthStream::Overflow::DropOldest; };
+
     virtual double getVWAP(const Symbol_t& symobl
         , const QuoteTime_t& begTime
         , const QuoteTime_t& endTime) { 
@@ -113,8 +150,7 @@ public:
 
     std::unordered_map<uint64_t,std::shared_ptr<SubMarketDepth_t>>        m_subscribeKey2SymbolCallBack;
 
-    std::unordered_map<Symbol_t
-        , std::unordered_map<uint64_t,std::shared_ptr<SubMarketDepth_t>>> m_symbol2SubscribeCallBack;
+    SymbolVector<std::unordered_map<uint64_t,std::shared_ptr<SubMarketDepth_t>>> m_symbol2SubscribeCallBack;     // SymbolId 下标
 
     std::unordered_map<OrderBookKey_t
         , std::pair<OnMarketDepthCallback, OnDelayTestCallback>
@@ -30,6 +30,12 @@ void QuoteFeedInternet::stop() {
                 asio::dispatch(*contextPtr,onRepalyFinished);
         }
 
+        for (auto& [subKey, subPtr] : self->m_subscribeKey2SymbolCallBack) {
+            if (subPtr->stream) {
+                subPtr->stream->close();
+            }
+        }
+
         self->m_orderBookKey2CallBack.clear();
         self->m_symbol2SubscribeCallBack.clear();
 
@@ -55,6 +61,35 @@ SubscribeKey_t QuoteFeedInternet::subscribe(std::shared_ptr<SubMarketDepth_t> su
 
     auto self = shared_from_this();
 
+    /* 行情线程 -> 订阅者 context, 批量投递 */
+    subPtr->mdChannel = MarketDepthChannel::create("quote->trader", subPtr->dispatchContextPtr->get_executor()
+        , [weakSub = std::weak_ptr<SubMarketDepth_t>(subPtr)](MarketDepthEvent* events, size_t count) {
+            auto sub = weakSub.lock();
+            if (not sub) {
+                return;
+            }
+            if (sub->stream) {
+                auto batch = sub->stream->acquire();
+                batch.clear();      // 实盘对象非 arena 分配, 直接转移引用
+                for (size_t i = 0; i < count; ++i) {
+                    batch.push_back(std::move(events[i].md));
+                }
+                sub->stream->push(std::move(batch));
+            }
+            else if (sub->onMarketDepths) {
+                std::array<MarketDepth*, MarketDepthChannel::BatchSize> mds{};
+                for (size_t i = 0; i < count; ++i) {
+                    mds[i] = events[i].md.get();
+                }
+                sub->onMarketDepths(std::span<MarketDepth* const>(mds.data(), count));
+            }
+            else if (sub->onMarketDepth) {
+                for (size_t i = 0; i < count; ++i) {
+                    sub->onMarketDepth(events[i].md.get());
+                }
+            }
+        });
+
     auto task = [self, subPtr]() {
         auto [it, isinserted] = self->m_subscribeKey2SymbolCallBack.insert({ subPtr->subscribeKey,subPtr });
         if (isinserted) {
@@ -62,7 +97,7 @@ SubscribeKey_t QuoteFeedInternet::subscribe(std::shared_ptr<SubMarketDepth_t> su
                 auto& count = self->m_symbolSubCounts[symbol];
                 count++;
                 SPDLOG_INFO("[aId:{}]subscribe {},counts:{}", subPtr->subscribeKey, symbol, count);
-                self->m_symbol2SubscribeCallBack[symbol].insert({ subPtr->subscribeKey,subPtr });
+                self->m_symbol2SubscribeCallBack[SymbolTable::getInstance().intern(symbol)].insert({ subPtr->subscribeKey,subPtr });
             }
         }
         };
@@ -87,10 +122,13 @@ void QuoteFeedInternet::unSubscribe(const uint64_t subcribeKey) {
                         self->m_symbolSubCounts.erase(symbol);
                     }
                 }
-                if (auto sym_it = self->m_symbol2SubscribeCallBack.find(symbol); sym_it != self->m_symbol2SubscribeCallBack.end()) {
-                    sym_it->second.erase(subcribeKey);
+                if (auto subs = self->m_symbol2SubscribeCallBack.find(SymbolTable::getInstance().find(symbol))) {
+                    subs->erase(subcribeKey);
                 }
             }
+            if (subPtr->stream) {
+                subPtr->stream->close();
+            }
             self->m_subscribeKey2SymbolCallBack.erase(subPtrIt);
         }
         };
@@ -263,7 +301,7 @@ void QuoteFeedInternet::onMarketDepth(std::shared_ptr<std::vector<MarketDepth*>>
 
         newMdCount++;
 
-        if (auto subCallBackMap_it = m_symbol2SubscribeCallBack.find(md->symbol); subCallBackMap_it != m_symbol2SubscribeCallBack.end()) {
+        if (auto subs = m_symbol2SubscribeCallBack.find(md->symbolId); subs and not subs->empty()) {
 
             for (auto& [orderBookKey, onPair] : m_orderBookKey2CallBack) {
 
@@ -274,11 +312,10 @@ void QuoteFeedInternet::onMarketDepth(std::shared_ptr<std::vector<MarketDepth*>>
                 }
             }
 
-            for (auto& [subKey, subMarketDepth] : subCallBackMap_it->second) {
-                if (subMarketDepth->dispatchContextPtr) {
+            for (auto& [subKey, subMarketDepth] : *subs) {
+                if (subMarketDepth->mdChannel) {
                     acct_set.insert(subMarketDepth->acctKey);
-                    md->retainAlive();
-                    asio::post(*subMarketDepth->dispatchContextPtr, [subMarketDepth, md]() {subMarketDepth->onMarketDepth(md); md->release(); });
+                    subMarketDepth->mdChannel->publish({ MarketDepth::keepAlive(md) });
                 }
             }
         }
@@ -385,29 +422,31 @@ MarketDepth* QuoteFeedInternet::parseMarketDepth_tx(const std::string& text) {
 
     new_md->avgPrice    = agcommon::get_float(data[51]);
 
-    new_md->bidPrice1   = agcommon::get_float(data[9]);
-    new_md->askPrice1   = agcommon::get_double(data[19]);
-    new_md->bidVol1     = agcommon::get_int(data[10]) * 100;
-    new_md->askVol1     = agcommon::get_int(data[20]) * 100;
-
-    new_md->bidPrice2   = agcommon::get_float(data[11]);
-    new_md->bidVol2     = agcommon::get_int(data[12]) * 100;
-    new_md->bidPrice3   = agcommon::get_float(data[13]);
-    new_md->bidVol3     = agcommon::get_int(data[14]) * 100;
-    new_md->bidPrice4   = agcommon::get_float(data[15]);
-    new_md->bidVol4     = agcommon::get_int(data[16]) * 100;
-    new_md->bidPrice5   = agcommon::get_float(data[17]);
-    new_md->bidVol5     = agcommon::get_int(data[18]) * 100;
-
-    new_md->askPrice2   = agcommon::get_float(data[21]);
-    new_md->askVol2     = agcommon::get_int(data[22]) * 100;
-    new_md->askPrice3   = agcommon::get_float(data[23]);
-    new_md->askVol3     = agcommon::get_int(data[24]) * 100;
-    new_md->askPrice4   = agcommon::get_float(data[25]);
-    new_md->askVol4     = agcommon::get_int(data[26]) * 100;
-    new_md->askPrice5   = agcommon::get_float(data[27]);
-    new_md->askVol5     = agcommon::get_int(data[28]) * 100;
+    new_md->bidPrices[0]   = agcommon::get_float(data[9]);
+    new_md->askPrices[0]   = agcommon::get_double(data[19]);
+    new_md->bidVols[0]     = agcommon::get_int(data[10]) * 100;
+    new_md->askVols[0]     = agcommon::get_int(data[20]) * 100;
+
+    new_md->bidPrices[1]   = agcommon::get_float(data[11]);
+    new_md->bidVols[1]     = agcommon::get_int(data[12]) * 100;
+    new_md->bidPrices[2]   = agcommon::get_float(data[13]);
+    new_md->bidVols[2]     = agcommon::get_int(data[14]) * 100;
+    new_md->bidPrices[3]   = agcommon::get_float(data[15]);
+    new_md->bidVols[3]     = agcommon::get_int(data[16]) * 100;
+    new_md->bidPrices[4]   = agcommon::get_float(data[17]);
+    new_md->bidVols[4]     = agcommon::get_int(data[18]) * 100;
+
+    new_md->askPrices[1]   = agcommon::get_float(data[21]);
+    new_md->askVols[1]     = agcommon::get_int(data[22]) * 100;
+    new_md->askPrices[2]   = agcommon::get_float(data[23]);
+    new_md->askVols[2]     = agcommon::get_int(data[24]) * 100;
+    new_md->askPrices[3]   = agcommon::get_float(data[25]);
+    new_md->askVols[3]     = agcommon::get_int(data[26]) * 100;
+    new_md->askPrices[4]   = agcommon::get_float(data[27]);
+    new_md->askVols[4]     = agcommon::get_int(data[28]) * 100;
     new_md->turnRate    = agcommon::get_float(data[38]);
 
+    new_md->syncTicks();
+
     return new_md;
 }
@@ -1,14 +1,182 @@
 #include "QuoteFeedReplay.h"
 #include "TCPSession.h"
 #include "QuoteFeedService.h"
+#include "StockDataManager.h"
+#include "ContextService.h"
+#include "Configs.h"
 
 QuoteFeedReplay::QuoteFeedReplay(const QuoteFeedRequest& req) 
-    : m_request(req)
-    , QuoteFeed(req.dispatchContextPtr, req.startTime)
+    : QuoteFeed(req.dispatchContextPtr, req.startTime)
+    , m_request(req)
     , m_keepRuning(false) 
-    , currentQuoteTime(req.startTime){
+    , m_prefetchTimer(*req.dispatchContextPtr)
+    , currentQuoteTime(req.startTime) {
 };
 
+/* windowMode: 0 整个区间一个窗口; 1 按交易日; 2 按半日(以 12:00 切分) */
+std::vector<ReplayWindow> QuoteFeedReplay::planWindows(const QuoteTime_t& loadBeg, const QuoteTime_t& loadEnd, int windowMode) {
+
+    if (windowMode <= 0) {
+        return { ReplayWindow{ loadBeg, loadEnd } };
+    }
+
+    auto tradeDates = StockDataManager::getInstance().getTradeDateInts(
+        agcommon::get_int(agcommon::geISODateStr(loadBeg)), agcommon::get_int(agcommon::geISODateStr(loadEnd)));
+
+    std::vector<ReplayWindow> windows{};
+
+    for (auto day = loadBeg.date(); day <= loadEnd.date(); day += boost::gregorian::days(1)) {
+
+        auto dayBeg = QuoteTime_t(day);
+
+        /* 交易日历缺失时不过滤 */
+        if (not tradeDates.empty() and not tradeDates.contains(agcommon::get_int(agcommon::geISODateStr(dayBeg)))) {
+            continue;
+        }
+
+        std::vector<QuoteTime_t> cuts{ dayBeg };
+        if (windowMode == 2) {
+            cuts.push_back(dayBeg + boost::posix_time::hours(12));
+        }
+        cuts.push_back(dayBeg + boost::posix_time::hours(24));
+
+        for (size_t i = 0; i + 1 < cuts.size(); ++i) {
+            auto beg = std::max(loadBeg, cuts[i]);
+            auto end = std::min(loadEnd, cuts[i + 1]);
+            if (beg < end) {
+                windows.push_back(ReplayWindow{ beg, end });
+            }
+        }
+    }
+    return windows;
+}
+
+size_t QuoteFeedReplay::loadTicks() {
+
+    auto windowMode = agcommon::Configs::getConfigs().getConfigOrDefault("DATACONFIG", "ReplayStreamWindow", 0);
+
+    auto [loadBeg, loadEnd] = StockDataManager::getTickLoadRange(m_request.startTime, m_request.endTime);
+
+    m_symbols.assign(m_request.symbolSet.begin(), m_request.symbolSet.end());
+    std::sort(m_symbols.begin(), m_symbols.end());
+
+    m_windows   = planWindows(loadBeg, loadEnd, windowMode);
+    m_windowIdx = 0;
+
+    /* 首个窗口同步加载, 其余在回放时后台预取 */
+    size_t lines = 0;
+    while (m_tickStore.empty() and m_windowIdx < m_windows.size()) {
+        lines = _loadWindow(m_windows[m_windowIdx++], m_tickStore);
+    }
+
+    if (m_windows.size() > 1) {
+        SPDLOG_INFO("[aId:{}]stream replay,windowMode:{},windows:{},first window:{},lines:{}", m_request.algoOrderId
+            , windowMode, m_windows.size(), m_windowIdx, lines);
+    }
+    return lines;
+}
+
+size_t QuoteFeedReplay::_loadWindow(const ReplayWindow& window, ReplayTickStore& tickStore) {
+
+    for (const auto& symbol : m_symbols) {
+        tickStore.addSymbol(symbol);
+    }
+    return StockDataManager::getInstance().cacheFromH5TickWindow(m_request.symbolSet, window.loadBeg, window.loadEnd, tickStore);
+}
+
+/* run in m_strand, 时间戳之间调用, 此时 arena 中只有 m_lastMds 仍被引用 */
+void QuoteFeedReplay::_resetArena() {
+
+    auto newArena = std::make_unique<MonotonicArena>(m_arenaBudget / 4);
+
+    for (auto& md : m_lastMds) {
+        if (md) {
+            auto copy = MarketDepth::createIn(*newArena, *md);
+            md->release();
+            md = copy;
+        }
+    }
+
+    m_mdArena = std::move(newArena);
+    m_arenaResets++;
+}
+
+/* run in m_strand. 下一窗口在 TickPrefetch 线程加载, 完成后移交回 m_strand */
+void QuoteFeedReplay::_prefetchNextWindow() {
+
+    if (m_prefetching or m_windowIdx >= m_windows.size()) {
+        return;
+    }
+
+    m_prefetching   = true;
+    m_prefetchReady = false;
+
+    auto window = m_windows[m_windowIdx++];
+
+    auto prefetchContextPtr = ContextService::getInstance().createContext("TickPrefetch", 2);
+
+    asio::post(*prefetchContextPtr, [self = shared_from_this(), window]() {
+
+        if (not self->m_keepRuning) {
+            return;
+        }
+
+        auto storePtr = std::make_shared<ReplayTickStore>();
+        try {
+            self->_loadWindow(window, *storePtr);
+        }
+        catch (const std::exception& e) {
+            SPDLOG_ERROR("[aId:{}]prefetch {} failed:{}", self->m_request.algoOrderId, agcommon::getDateTimeStr(window.loadBeg), e.what());
+        }
+
+        asio::post(self->m_strand, [self, storePtr]() {
+            if (not self->m_keepRuning) {
+                return;     // 已停止, 加载结果随 storePtr 释放
+            }
+            self->m_nextTickStore = std::move(*storePtr);
+            self->m_prefetchReady = true;
+            self->m_prefetchTimer.cancel();
+            });
+        });
+}
+
+/* 等待预取完成并切换到下一窗口, 没有后续窗口返回 false */
+asio::awaitable<bool> QuoteFeedReplay::_co_switchToNextWindow() {
+
+    if (not m_prefetching) {
+        co_return false;
+    }
+
+    if (not m_prefetchReady) {
+
+        agcommon::TimeCost tc(fmt::format("[aId:{}]wait prefetch window {}/{}", m_request.algoOrderId, m_windowIdx, m_windows.size()));
+
+        while (not m_prefetchReady and m_keepRuning) {
+            m_prefetchTimer.expires_at(asio::steady_timer::time_point::max());
+            co_await m_prefetchTimer.async_wait(asio::as_tuple(asio::use_awaitable));
+        }
+    }
+
+    /* stop 取消等待后不再切换, 已加载的窗口丢弃 */
+    if (not m_prefetchReady or not m_keepRuning) {
+        co_return false;
+    }
+
+    m_prefetching   = false;
+    m_prefetchReady = false;
+
+    /* 保留上一窗口供 getVWAP 跨窗口查询, 更早的窗口随之释放 */
+    m_prevTickStore = std::move(m_tickStore);
+    m_tickStore     = std::move(m_nextTickStore);
+    m_nextTickStore = ReplayTickStore{};
+
+    if (m_lastMds.size() < m_tickStore.symbolSize()) {
+        m_lastMds.resize(m_tickStore.symbolSize(), nullptr);
+    }
+
+    co_return true;
+}
+
 
 void QuoteFeedReplay::stop() {
 
@@ -26,12 +194,19 @@ void QuoteFeedReplay::stop() {
             asio::dispatch(*contextPtr, onRepalyFinished);
         }
 
+        self->m_clock.close();
+
+        self->m_prefetchTimer.cancel();     // 唤醒等待预取的 co_run
+
+        for (auto& [subKey, subPtr] : self->m_subscribeKey2SymbolCallBack) {
+            if (subPtr->stream) {
+                subPtr->stream->close();
+            }
+        }
+
         self->m_orderBookKey2CallBack.clear();
         self->m_symbol2SubscribeCallBack.clear();
 
-        self->m_quoteTime2Symbol2md.clear();
-        std::map<QuoteTime_t, UnorderMarketDepthRawPtrMap> tmp;
-        tmp.swap(self->m_quoteTime2Symbol2md);
         self->onQuoteFeedFinisheds.clear();
         self->onQuoteFeedStarts.clear();
 
@@ -59,7 +234,11 @@ uint64_t QuoteFeedReplay::_subscribe(std::shared_ptr<SubMarketDepth_t> subPtr) {
     auto [it, isinserted] = m_subscribeKey2SymbolCallBack.insert({ subPtr->subscribeKey,subPtr });
     if (isinserted) {
         for (auto& symbol : subPtr->symbols) {
-            m_symbol2SubscribeCallBack[symbol].insert({ subPtr->subscribeKey,subPtr });
+            m_symbol2SubscribeCallBack[SymbolTable::getInstance().intern(symbol)].insert({ subPtr->subscribeKey,subPtr });
+        }
+        if (subPtr->isBatched()) {
+            m_subKey2BatchIdx[subPtr->subscribeKey] = m_batchSubs.size();
+            m_batchSubs.push_back(BatchSub_t{ subPtr });
         }
         SPDLOG_DEBUG("[aId:{}]subscribe symbol count:{}", subPtr->subscribeKey, subPtr->symbols.size());
         run();
@@ -81,12 +260,19 @@ void QuoteFeedReplay::_unSubscribe(const uint64_t subcribeKey) {
     if (auto subPtrIt = m_subscribeKey2SymbolCallBack.find(subcribeKey); subPtrIt != m_subscribeKey2SymbolCallBack.end()) {
         auto& subPtr = subPtrIt->second;
         for (auto& symbol : subPtr->symbols) {
-            if (auto sym_it = m_symbol2SubscribeCallBack.find(symbol); sym_it != m_symbol2SubscribeCallBack.end()) {
-                sym_it->second.erase(subcribeKey);
+            if (auto subs = m_symbol2SubscribeCallBack.find(SymbolTable::getInstance().find(symbol))) {
+                subs->erase(subcribeKey);
             }
         }
         m_subscribeKey2SymbolCallBack.erase(subcribeKey);
     };
+    if (auto it = m_subKey2BatchIdx.find(subcribeKey); it != m_subKey2BatchIdx.end()) {
+        if (auto& subPtr = m_batchSubs[it->second].subPtr; subPtr and subPtr->stream) {
+            subPtr->stream->close();
+        }
+        m_batchSubs[it->second].subPtr = nullptr;
+        m_subKey2BatchIdx.erase(it);
+    }
 }
 
 void QuoteFeedReplay::run() {
@@ -112,11 +298,13 @@ asio::awaitable<void> QuoteFeedReplay::co_run() {
         co_return;
 
     m_keepRuning = true;
-    int i = 0;
-    if (m_quoteTime2Symbol2md.size() > 0) {
-        SPDLOG_INFO("aid:{} Replay start,{},{}", m_request.algoOrderId
-            , agcommon::getDateTimeInt(m_quoteTime2Symbol2md.begin()->first)
-            , agcommon::getDateTimeInt(m_quoteTime2Symbol2md.rbegin()->first));
+
+    if (not m_tickStore.empty()) {
+        SPDLOG_INFO("aid:{} Replay start,{},{},ticks:{},windows:{}", m_request.algoOrderId
+            , agcommon::getDateTimeInt(m_tickStore.quoteTimeAt(0))
+            , agcommon::getDateTimeInt(m_tickStore.quoteTimeAt(m_tickStore.timeSize() - 1))
+            , m_tickStore.size()
+            , m_windows.size());
     }
     else
         SPDLOG_INFO("aid:{} Replay start with 0 data", m_request.algoOrderId);
@@ -127,28 +315,48 @@ asio::awaitable<void> QuoteFeedReplay::co_run() {
         }
     }
 
-    for (const auto& [qt, symbol2md] : m_quoteTime2Symbol2md) {
+    m_lastMds.assign(m_tickStore.symbolSize(), nullptr);
 
-        currentQuoteTime = qt;
+    m_arenaBudget = static_cast<size_t>(std::max(1, agcommon::Configs::getConfigs().getConfigOrDefault("DATACONFIG", "ReplayArenaMB", 64))) * 1024 * 1024;
+    m_mdArena     = std::make_unique<MonotonicArena>(m_arenaBudget / 4);
 
-        #if ENABLE_DELAY_STATS
-            agcommon::TimeCost delay(fmt::format("[DELAY][{}]size:{}",agcommon::getDateTimeStr(qt), symbol2md.size()),"",false);
-        #endif
+    do {
 
-        for (const auto& [symbol, md] : symbol2md) {
+        _prefetchNextWindow();
 
-            if (m_keepRuning) {
-                SPDLOG_DEBUG("MarketDepth:{}", md->to_string());
-                md->retainAlive();
-                if (m_symbol2md.find(md->symbol) == m_symbol2md.end()) {
-                    m_symbol2md[md->symbol] = md;
+        for (size_t t = 0; t < m_tickStore.timeSize() and m_keepRuning; ++t) {
+
+            if (m_mdArena->bytes() > m_arenaBudget) {
+                _resetArena();
+            }
+
+            /* 唤醒时刻早于本时间戳的协程, 先于本时间戳行情运行, 此时 currentQuoteTime 仍为上一时间戳 */
+            m_clock.advanceTo(m_tickStore.quoteNsAt(t));
+
+            currentQuoteTime = m_tickStore.quoteTimeAt(t);
+
+            const auto records = m_tickStore.ticksAt(t);
+
+            #if ENABLE_DELAY_STATS
+                agcommon::TimeCost delay(fmt::format("[DELAY][{}]size:{}",agcommon::getDateTimeStr(m_tickStore.quoteTimeAt(t)), records.size()),"",false);
+            #endif
+
+            for (const auto& record : records) {
+
+                if (not m_keepRuning) {
+                    break;
                 }
-                else {
-                    auto& lastMd = m_symbol2md[md->symbol];
+
+                auto md = m_tickStore.createMarketDepth(record, m_mdArena.get());   // refcount 1, 由 m_lastMds 持有
+
+                SPDLOG_DEBUG("MarketDepth:{}", md->to_string());
+
+                auto& lastMd = m_lastMds[record.symbolIdx];
+                if (lastMd) {
                     md->calDelta(lastMd);
                     lastMd->release();
-                    m_symbol2md[md->symbol] = md;
                 }
+                lastMd = md;
 
                 for (const auto& [orderBookKey, onPair] : m_orderBookKey2CallBack) {
                     auto& [onMarketDepth, onDelayTest] = onPair;
@@ -157,9 +365,11 @@ asio::awaitable<void> QuoteFeedReplay::co_run() {
                     }
                 }
 
-                if (const auto subCallBackMap_it = m_symbol2SubscribeCallBack.find(md->symbol); subCallBackMap_it != m_symbol2SubscribeCallBack.end()) {
+                if (const auto subs = m_symbol2SubscribeCallBack.find(md->symbolId)) {
+
+                    bool held = false;
 
-                    for (auto& [subKey, subMarketDepth] : subCallBackMap_it->second) {
+                    for (auto& [subKey, subMarketDepth] : *subs) {
                         SPDLOG_DEBUG("[{}]subMarketDepth:{}", subKey, md->to_string());
 
                         if (subMarketDepth->publish2Client) {
@@ -168,6 +378,16 @@ asio::awaitable<void> QuoteFeedReplay::co_run() {
 
                             TCPSessionManager::getInstance().sendNotify2C(subMarketDepth->acctKey, AlgoMsg::CMD_NOTIFY_MarketDepth, mdMessage,false);
                         }
+                        if (subMarketDepth->isBatched()) {
+                            /* 同一时间戳内同一 symbol 可能重复, 持有引用直到批量回调结束 */
+                            if (not held) {
+                                md->retainAlive();
+                                m_batchHeld.push_back(md);
+                                held = true;
+                            }
+                            m_batchSubs[m_subKey2BatchIdx[subKey]].mds.push_back(md);
+                            continue;
+                        }
                         if (subMarketDepth->onMarketDepth) {
 
                             subMarketDepth->onMarketDepth(md);
@@ -183,47 +403,128 @@ asio::awaitable<void> QuoteFeedReplay::co_run() {
                     }
                 }
             }
+
+            if (not m_batchHeld.empty()) {
+                co_await _co_dispatchBatches();
+            }
+    
+            #if ENABLE_DELAY_STATS
+                    testDelay<QuoteFeedReplay>(delay);
+            #endif // ENABLE_DELAY_TEST
+
+        }
+
+    } while (m_keepRuning and co_await _co_switchToNextWindow());
+
+    m_clock.close();
+
+    for (auto& md : m_lastMds) {
+        if (md) {
             md->release();
         }
-    
-        #if ENABLE_DELAY_STATS
-                testDelay<QuoteFeedReplay>(delay);
-        #endif // ENABLE_DELAY_TEST
+    }
+
+    m_lastMds.clear();
+
+    SPDLOG_INFO("aid:{} Replay arena resets:{},last arena objects:{},clock {}", m_request.algoOrderId, m_arenaResets, m_mdArena->count(), m_clock.to_string());
+
+    m_mdArena.reset();      // 整体释放
+
+    m_tickStore.release();     // 在 co_run 内释放, 避免 stop 时 co_await 中的遍历失效
+    m_prevTickStore.release();
+    m_nextTickStore.release();
+}
+
+/* 每个时间戳一次: 批量订阅者各自收到该时间戳的全部 MarketDepth */
+asio::awaitable<void> QuoteFeedReplay::_co_dispatchBatches() {
+
+    /* co_await 期间 m_strand 上可能有新订阅, m_batchSubs 按下标访问 */
+    for (size_t i = 0; i < m_batchSubs.size(); ++i) {
+
+        if (m_batchSubs[i].mds.empty()) {
+            continue;
+        }
+
+        auto subPtr = m_batchSubs[i].subPtr;
+        auto mds    = std::span<MarketDepth* const>(m_batchSubs[i].mds);
+
+        if (subPtr and subPtr->stream) {
+            /* 订阅者异步取用, 从 arena 拷出到复用批中已有的对象; 缓冲满时挂起回放直到取走 */
+            auto batch = subPtr->stream->acquire();
+            batch.resize(mds.size());
+            for (size_t j = 0; j < mds.size(); ++j) {
+                MarketDepth::keepAliveInto(batch[j], mds[j]);
+            }
+            co_await subPtr->stream->co_push(std::move(batch));
+        }
+        else if (subPtr) {
+            if (subPtr->onMarketDepths) {
+                subPtr->onMarketDepths(mds);
+            }
+            if (subPtr->co_onMarketDepths) {
+                co_await subPtr->co_onMarketDepths(mds);
+            }
+        }
 
+        m_batchSubs[i].mds.clear();
     }
 
-    for (const auto& [symbol, md] : m_symbol2md) {
+    for (auto md : m_batchHeld) {
         md->release();
     }
-
-    m_symbol2md.clear();
+    m_batchHeld.clear();
 }
 
 /*call getVWAP should in the same thread of QuoteFeedReplay's running m_strand */
 double QuoteFeedReplay::getVWAP(const Symbol_t& symbol, const QuoteTime_t& begTime, const QuoteTime_t& endTime) {
 
-    auto it_low = m_quoteTime2Symbol2md.lower_bound(begTime);
-    auto it_up  = m_quoteTime2Symbol2md.upper_bound(endTime);  
-
     double beg_amt = 0.0;
     uint64_t beg_vol = 0;
 
     double end_amt = 0.0;
     uint64_t end_vol = 0;
 
-    for (auto it = it_low; it != it_up; ++it) {
-        if (auto symbol_it = it->second.find(symbol); symbol_it != it->second.end()) {
-            beg_amt = symbol_it->second->amount;
-            beg_vol = symbol_it->second->volume;
-            break;
+    /* 流式回放时区间起点可能落在上一窗口 */
+    auto findTick = [&symbol, &begTime, &endTime](const ReplayTickStore& tickStore, bool forward) -> const h5data::Tick* {
+
+        auto symbolIdx = tickStore.findSymbol(symbol);
+        if (not symbolIdx or tickStore.empty()) {
+            return nullptr;
         }
-    }
-    for (auto it = it_up; it != it_low; --it) {
-        if (auto symbol_it = it->second.find(symbol); symbol_it != it->second.end()) {
-            end_amt = symbol_it->second->amount;
-            end_vol = symbol_it->second->volume;
-            break;
+
+        const auto records = tickStore.ticksBetween(tickStore.lowerBound(begTime), tickStore.upperBound(endTime));
+
+        if (forward) {
+            for (auto it = records.begin(); it != records.end(); ++it) {
+                if (it->symbolIdx == *symbolIdx) {
+                    return it->tick;
+                }
+            }
         }
+        else {
+            for (auto it = records.rbegin(); it != records.rend(); ++it) {
+                if (it->symbolIdx == *symbolIdx) {
+                    return it->tick;
+                }
+            }
+        }
+        return nullptr;
+    };
+
+    auto begTick = findTick(m_prevTickStore, true);
+    if (not begTick) {
+        begTick = findTick(m_tickStore, true);
+    }
+    auto endTick = findTick(m_tickStore, false);
+    if (not endTick) {
+        endTick = findTick(m_prevTickStore, false);
+    }
+
+    if (begTick and endTick) {
+        beg_amt = begTick->cum_amount;
+        beg_vol = begTick->cum_volume;
+        end_amt = endTick->cum_amount;
+        end_vol = endTick->cum_volume;
     }
 
     double vwap = 0.0;
@@ -236,4 +537,4 @@ double QuoteFeedReplay::getVWAP(const Symbol_t& symbol, const QuoteTime_t& begTi
     }
    
     return vwap;
-}
\ No newline at end of file
+}
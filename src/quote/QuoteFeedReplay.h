@@ -1,6 +1,17 @@
 #pragma once
 
 #include "QuoteFeed.h"
+#include "ReplayTickStore.h"
+
+/*
+* 回放窗口, 开区间 (loadBeg, loadEnd). 流式回放时按交易日或半日切分, 当前窗口回放期间后台预取下一窗口
+*/
+struct ReplayWindow {
+
+    QuoteTime_t     loadBeg{};
+
+    QuoteTime_t     loadEnd{};
+};
 
 /*
 * QuoteFeedReplay should dispatch with context run only in one thread, so it equal run with stand
@@ -14,6 +25,9 @@ public:
 
     void run() override;
 
+    /* 按 [DATACONFIG]ReplayStreamWindow 切分窗口并同步加载第一个非空窗口, 返回其 tick 数 */
+    size_t loadTicks();
+
     asio::awaitable<void> co_run();
 
     void stop() override;
@@ -30,11 +44,15 @@ public:
 
     QuoteTime_t getCurrentQuoteTime() override { return currentQuoteTime.load(); };
 
+    VirtualClock* virtualClock() override { return &m_clock; };
+
+    MarketDepthStream::Overflow streamOverflow() override { return MarketDepthStream::Overflow::Wait; };
+
     double getVWAP(const Symbol_t& symobl, const QuoteTime_t& begTime, const QuoteTime_t& endTime) override;
 
 public:
 
-    std::map<QuoteTime_t, UnorderMarketDepthRawPtrMap>           m_quoteTime2Symbol2md = {};
+    ReplayTickStore                            m_tickStore{};
 
 private:
 
@@ -42,7 +60,58 @@ private:
 
     std::atomic<bool>                          m_keepRuning{ false };
 
-    UnorderMarketDepthRawPtrMap                m_symbol2md;
+    std::vector<MarketDepth*>                  m_lastMds{};     // symbolIdx -> 最新 MarketDepth
+
+    /* 回放 MarketDepth 分配自 arena, 超过 m_arenaBudget 时把 m_lastMds 拷入新 arena 后整体释放旧 arena
+    *  回调之外需持有的对象由 MarketDepth::keepAlive 拷出 */
+    std::unique_ptr<MonotonicArena>            m_mdArena{ nullptr };
+
+    size_t                                     m_arenaBudget{ 0 };
+
+    size_t                                     m_arenaResets{ 0 };
+
+    void     _resetArena();
+
+    /* 流式回放 */
+    std::vector<Symbol_t>                      m_symbols{};     // 固定顺序预先加入各窗口, 各窗口 symbolIdx 一致
+
+    std::vector<ReplayWindow>                  m_windows{};
+
+    size_t                                     m_windowIdx{ 0 };        // 下一个待加载窗口
+
+    ReplayTickStore                            m_prevTickStore{};       // 上一窗口, getVWAP 跨窗口时使用
+
+    ReplayTickStore                            m_nextTickStore{};
+
+    bool                                       m_prefetching{ false };
+
+    bool                                       m_prefetchReady{ false };
+
+    asio::steady_timer                         m_prefetchTimer;
+
+    static std::vector<ReplayWindow> planWindows(const QuoteTime_t& loadBeg, const QuoteTime_t& loadEnd, int windowMode);
+
+    size_t   _loadWindow(const ReplayWindow& window, ReplayTickStore& tickStore);
+
+    void     _prefetchNextWindow();
+
+    asio::awaitable<bool> _co_switchToNextWindow();
+
+    /* 批量订阅者, 每个时间戳汇总一次回调; 退订只置空, 下标不变 */
+    struct BatchSub_t {
+
+        std::shared_ptr<SubMarketDepth_t>   subPtr{ nullptr };
+
+        std::vector<MarketDepth*>           mds{};
+    };
+
+    std::vector<BatchSub_t>                     m_batchSubs{};
+
+    std::unordered_map<SubscribeKey_t, size_t>  m_subKey2BatchIdx{};
+
+    std::vector<MarketDepth*>                   m_batchHeld{};      // 当前时间戳进入批量的 md, 回调后 release
+
+    asio::awaitable<void> _co_dispatchBatches();
 
     uint64_t _subscribe(std::shared_ptr<SubMarketDepth_t> subPtr);
 
@@ -50,4 +119,6 @@ private:
 
     std::atomic<QuoteTime_t>                    currentQuoteTime;
 
+    VirtualClock                                m_clock{};     // 每个时间戳前恢复到期的回测协程
+
 };
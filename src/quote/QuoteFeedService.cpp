@@ -76,13 +76,11 @@ std::shared_ptr<QuoteFeed> QuoteFeedService::createQuoteFeed(const QuoteFeedRequ
 
         agcommon::TimeCost tc(std::format("[{}]read Tick {} symbols:{}-{}",req.algoOrderId,req.symbolSet.size(), st_str, end_str));
         
-        auto& dataSource = StockDataManager::getInstance();
-
-        auto lines = dataSource.cacheFromH5Tick(req.symbolSet, req.startTime, req.endTime, quoteFeedPtr->m_quoteTime2Symbol2md);
+        auto lines = quoteFeedPtr->loadTicks();
         
         tc.timeAt(std::format(",readlines:{}",lines));
 
-        if (quoteFeedPtr->m_quoteTime2Symbol2md.size() == 0) {
+        if (quoteFeedPtr->m_tickStore.empty()) {
 
             algoErrMessage = std::format("symbols Data Range [{},{}] NOT FOUND.", st_str, end_str);
 
@@ -0,0 +1,99 @@
+#include "ReplayTickStore.h"
+#include <algorithm>
+
+uint32_t ReplayTickStore::addSymbol(const Symbol_t& symbol) {
+
+    auto [it, inserted] = m_symbol2Idx.try_emplace(symbol, static_cast<uint32_t>(m_symbols.size()));
+
+    if (inserted) {
+        m_symbols.push_back(symbol);
+        m_symbolIds.push_back(SymbolTable::getInstance().intern(symbol));
+        m_priceTicks.push_back(agcommon::PriceTick::ofSymbol(symbol));
+    }
+    return it->second;
+}
+
+uint32_t ReplayTickStore::addSeriesSlot() {
+
+    m_series.push_back(nullptr);
+
+    return static_cast<uint32_t>(m_series.size() - 1);
+}
+
+void ReplayTickStore::append(std::vector<ReplayTickRecord>&& records) {
+
+    if (m_ticks.empty() and m_ticks.capacity() < records.size()) {
+        m_ticks = std::move(records);
+    }
+    else {
+        m_ticks.insert(m_ticks.end(), records.begin(), records.end());
+        std::vector<ReplayTickRecord>().swap(records);
+    }
+}
+
+size_t ReplayTickStore::seal() {
+
+    if (not std::is_sorted(m_ticks.begin(), m_ticks.end(), tickOrder)) {
+        std::sort(m_ticks.begin(), m_ticks.end(), tickOrder);
+    }
+
+    auto last = std::unique(m_ticks.begin(), m_ticks.end(), [this](const ReplayTickRecord& a, const ReplayTickRecord& b) {
+        if (a.createdAt == b.createdAt and a.symbolIdx == b.symbolIdx) {
+            SPDLOG_WARN("double tick:, {},{}", m_symbols[a.symbolIdx], agcommon::qtime::toDateTimeInt(agcommon::qtime::fromUtcSeconds(a.createdAt)));
+            return true;
+        }
+        return false;
+        });
+
+    m_ticks.erase(last, m_ticks.end());
+    m_ticks.shrink_to_fit();
+
+    m_times.clear();
+    m_offsets.clear();
+
+    for (size_t i = 0; i < m_ticks.size(); ++i) {
+        if (i == 0 or m_ticks[i].createdAt != m_ticks[i - 1].createdAt) {
+            m_times.push_back(agcommon::qtime::fromUtcSeconds(m_ticks[i].createdAt));
+            m_offsets.push_back(i);
+        }
+    }
+    m_offsets.push_back(m_ticks.size());
+
+    return m_ticks.size();
+}
+
+void ReplayTickStore::release() {
+
+    std::vector<ReplayTickRecord>().swap(m_ticks);
+    std::vector<QuoteNs_t>().swap(m_times);
+    std::vector<size_t>().swap(m_offsets);
+    std::vector<TickSeriesPtr>().swap(m_series);
+}
+
+size_t ReplayTickStore::lowerBound(const QuoteTime_t& qt) const {
+
+    return std::lower_bound(m_times.begin(), m_times.end(), agcommon::qtime::fromPtime(qt)) - m_times.begin();
+}
+
+size_t ReplayTickStore::upperBound(const QuoteTime_t& qt) const {
+
+    return std::upper_bound(m_times.begin(), m_times.end(), agcommon::qtime::fromPtime(qt)) - m_times.begin();
+}
+
+std::optional<uint32_t> ReplayTickStore::findSymbol(const Symbol_t& symbol) const {
+
+    if (auto it = m_symbol2Idx.find(symbol); it != m_symbol2Idx.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+MarketDepth* ReplayTickStore::createMarketDepth(const ReplayTickRecord& record, MonotonicArena* arena) const {
+
+    const auto& seriesPtr = m_series[record.seriesIdx];
+
+    if (arena) {
+        return MarketDepth::createIn(*arena, m_symbols[record.symbolIdx], m_symbolIds[record.symbolIdx], m_priceTicks[record.symbolIdx], record.tick, seriesPtr->preClose, seriesPtr->shareCirc);
+    }
+    return MarketDepth::create(m_symbols[record.symbolIdx], m_symbolIds[record.symbolIdx], m_priceTicks[record.symbolIdx], record.tick, seriesPtr->preClose, seriesPtr->shareCirc);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <span>
+#include <optional>
+#include "typedefs.h"
+#include "common.h"
+#include "H5DataTypes.h"
+#include "MarketDepth.h"
+#include "TickCache.h"
+
+/*
+* 回测行情存储: 按时间排序的连续 tick 索引数组 + 每个时间戳的偏移索引
+* 替代 std::map<QuoteTime_t, UnorderMarketDepthRawPtrMap>, 回放时顺序遍历, MarketDepth 按需创建
+* tick 数据本身在 TickCache 的 TickSeries 中, 这里持有 TickSeriesPtr 保证回放期间只读视图有效
+*/
+
+struct ReplayTickRecord {
+
+    uint32_t            createdAt{ 0 };     // = tick->created_at, 排序用
+
+    uint32_t            symbolIdx{ 0 };     // ReplayTickStore 内部的 symbol 下标
+
+    uint32_t            seriesIdx{ 0 };     // (交易日, symbol) 序列下标, 提供昨收/流通股本
+
+    const h5data::Tick* tick{ nullptr };
+};
+
+class ReplayTickStore {
+
+public:
+
+    ReplayTickStore() = default;
+
+    ReplayTickStore(const ReplayTickStore&) = delete;
+    ReplayTickStore& operator=(const ReplayTickStore&) = delete;
+
+    /* 流式回放: 后台加载好的下一窗口整体移交给回放线程 */
+    ReplayTickStore(ReplayTickStore&&) = default;
+    ReplayTickStore& operator=(ReplayTickStore&&) = default;
+
+    /* load stage, not thread safe */
+    uint32_t addSymbol(const Symbol_t& symbol);
+
+    /* 以 SecurityStaticInfo price_tick 覆盖缺省规则 */
+    inline void setPriceTick(uint32_t symbolIdx, double tickSize) {
+        if (tickSize > 0.0) {
+            m_priceTicks[symbolIdx] = agcommon::PriceTick(tickSize);
+        }
+    }
+
+    /* 预留一个 (交易日, symbol) 序列位置, 加载线程随后通过 setSeries 填入, 各线程写不同位置 */
+    uint32_t addSeriesSlot();
+
+    inline void setSeries(uint32_t seriesIdx, const TickSeriesPtr& seriesPtr) { m_series[seriesIdx] = seriesPtr; }
+
+    inline void reserve(size_t n) { m_ticks.reserve(n); }
+
+    inline void append(uint32_t symbolIdx, uint32_t seriesIdx, const h5data::Tick& tick) {
+        m_ticks.push_back(ReplayTickRecord{ tick.created_at, symbolIdx, seriesIdx, &tick });
+    }
+
+    /* 已排好序的分块整体追加, 分块之间时间不重叠时 seal 无需再排序 */
+    void append(std::vector<ReplayTickRecord>&& records);
+
+    static inline bool tickOrder(const ReplayTickRecord& a, const ReplayTickRecord& b) {
+        if (a.createdAt != b.createdAt) {
+            return a.createdAt < b.createdAt;
+        }
+        return a.symbolIdx < b.symbolIdx;
+    }
+
+    /* 按 (created_at, symbolIdx) 排序, 去重, 构建时间索引. 返回 tick 数 */
+    size_t seal();
+
+    void   release();
+
+    /* replay stage, read only */
+    inline bool   empty()    const { return m_times.empty(); }
+
+    inline size_t size()     const { return m_ticks.size(); }
+
+    inline size_t timeSize() const { return m_times.size(); }
+
+    inline QuoteNs_t   quoteNsAt(size_t i)   const { return m_times[i]; }
+
+    inline QuoteTime_t quoteTimeAt(size_t i) const { return agcommon::qtime::toPtime(m_times[i]); }
+
+    inline std::span<const ReplayTickRecord> ticksAt(size_t i) const {
+        return std::span<const ReplayTickRecord>(m_ticks.data() + m_offsets[i], m_offsets[i + 1] - m_offsets[i]);
+    }
+
+    inline std::span<const ReplayTickRecord> ticksBetween(size_t beg, size_t end) const {
+        return std::span<const ReplayTickRecord>(m_ticks.data() + m_offsets[beg], m_offsets[end] - m_offsets[beg]);
+    }
+
+    /* 第一个 >= qt 的时间下标 */
+    size_t lowerBound(const QuoteTime_t& qt) const;
+
+    /* 第一个 > qt 的时间下标 */
+    size_t upperBound(const QuoteTime_t& qt) const;
+
+    inline size_t symbolSize() const { return m_symbols.size(); }
+
+    inline const Symbol_t& symbolAt(uint32_t symbolIdx) const { return m_symbols[symbolIdx]; }
+
+    inline SymbolId_t symbolIdAt(uint32_t symbolIdx) const { return m_symbolIds[symbolIdx]; }
+
+    std::optional<uint32_t> findSymbol(const Symbol_t& symbol) const;
+
+    /* refcount 1, caller release. arena 非空时在 arena 中创建 */
+    MarketDepth* createMarketDepth(const ReplayTickRecord& record, MonotonicArena* arena = nullptr) const;
+
+private:
+
+    std::vector<ReplayTickRecord>           m_ticks{};
+
+    std::vector<QuoteNs_t>                  m_times{};      // 交易所本地纳秒, 升序
+
+    std::vector<size_t>                     m_offsets{};    // m_times.size()+1
+
+    std::vector<Symbol_t>                   m_symbols{};
+
+    std::vector<SymbolId_t>                 m_symbolIds{};      // symbolIdx -> SymbolTable id, 加载时登记
+
+    std::vector<agcommon::PriceTick>        m_priceTicks{};     // symbolIdx -> 最小变动价位
+
+    std::unordered_map<Symbol_t, uint32_t>  m_symbol2Idx{};
+
+    std::vector<TickSeriesPtr>              m_series{};
+};
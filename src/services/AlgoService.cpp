@@ -7,6 +7,8 @@
 #include <google/protobuf/text_format.h>
 #include "TCPSession.h"
 #include "Configs.h"
+#include "BacktestScheduler.h"
+#include "BacktestAggregator.h"
 
 AlgoService::AlgoService() :m_isRunning{false} {
 	start();
@@ -63,6 +65,8 @@ void AlgoService::start() {
 		m_workercontextKeys.push_back(contextKey);
 	}
 
+	BacktestScheduler::getInstance().init(m_workerContexts);
+
 	accept();
 }
 
@@ -253,6 +257,8 @@ void AlgoService::onStartAlgoInstanceRequest(const std::shared_ptr<TCPSession> s
 				}
 			}
 
+			createBackTestAggregator(req, algoOrders, resp);
+
 			if (resp->failed_algo_order_id().size() > 0) {
 
 				resp->set_error_msg(fmt::format("[{}]success:{},failed:{}.{}", requestId, resp->success_algo_order_id().size(), resp->failed_algo_order_id().size(), algoErrMessage_all));
@@ -411,32 +417,9 @@ AlgoErrorCode AlgoService::dispatchAlgoOrder(const std::shared_ptr<AlgoOrder>& a
 		algoErrorCode =  AlgoErrorCode::ALGO_DUPLICATE_ERROR;
 	}
 
-	std::shared_ptr<Trader> traderPtr;
-
-	switch (algoOrder->algoCategory)
-	{
-	case AlgoMsg::MsgAlgoCategory::Category_ALGO: {
-		traderPtr = std::make_shared<AlgoTrader>(algoOrder);
-		break;
-	}
-	case AlgoMsg::MsgAlgoCategory::Category_SHOT: {
-		traderPtr = std::make_shared<ShotTrader>(algoOrder);
-		break;
-	}
-	//case AlgoMsg::MsgAlgoCategory::Category_HIT: {
-	//	traderPtr = std::make_shared<ShotTrader>(algoOrder);
-	//	break;
-	//}
-	//case AlgoMsg::MsgAlgoCategory::Category_SPREAD: {
-	//	traderPtr = std::make_shared<PairTrader>(algoOrder);
-	//	break;
-	//}
-	//case AlgoMsg::MsgAlgoCategory::Category_T0: {
-	//	traderPtr = std::make_shared<PairTrader>(algoOrder);
-	//	break;
-	//}
+	std::shared_ptr<Trader> traderPtr = createTrader(algoOrder);
 
-	default:
+	if (not traderPtr) {
 		algoErrMessage = fmt::format("{},unsupport algo_category:{}.", algoOrder->clientAlgoOrderId,AlgoMsg::MsgAlgoCategory_Name(algoOrder->algoCategory));
 		SPDLOG_ERROR(algoErrMessage);
 		return AlgoErrorCode::ALGO_ERROR;
@@ -448,28 +431,9 @@ AlgoErrorCode AlgoService::dispatchAlgoOrder(const std::shared_ptr<AlgoOrder>& a
 
 		if (algoOrder->isBackTestOrder())
 		{
-			auto shouldQueue = m_runningTraders_bt_costMutiContext.load() !=0 or m_runningTraders_bt.load() >= m_numAlgoWorkers;
-
-			if (shouldQueue) {
-
-				m_algoTraderQueue_bt.push_back(traderPtr);
-
-				traderPtr->publishAlgoperformance();
-
-				SPDLOG_INFO("[{}]algoTraderQueue SIZE:{}", AlgoMsg::MsgAlgoCategory_Name(algoOrder->algoCategory), m_algoTraderQueue_bt.size());
-			}
-			else {
+			traderPtr->publishAlgoperformance();
 
-				m_runningTraders.fetch_add(1);
-
-				m_runningTraders_bt.fetch_add(1);
-
-				if (traderPtr->getAlgoCategory() != AlgoMsg::Category_ALGO) {
-					m_runningTraders_bt_costMutiContext.fetch_add(1);
-				}
-				
-				asio::co_spawn(*traderPtr->contextPtr, traderPtr->start(), std::bind(&AlgoService::onAlgoInstanceFinished, this, traderPtr, std::placeholders::_1));
-			}
+			submitBackTest(traderPtr);
 		}
 		else 
 		{
@@ -529,33 +493,131 @@ void AlgoService::onAlgoInstanceFinished(const std::shared_ptr<Trader> traderPtr
 
 		m_runningTraders_bt.fetch_sub(1);
 
-		if (traderPtr->getAlgoCategory() != AlgoMsg::Category_ALGO) {
-			m_runningTraders_bt_costMutiContext.fetch_sub(1);
-		}
+		/* 在 trader 线程取最终绩效, 回 dispatcher 归约 */
+		asio::post(*m_dispatcherContextPtr, [this, algoOrderId, perfMsg = traderPtr->encodePerformanceMessage()]() {
+			onBackTestChildDone(algoOrderId, perfMsg);
+		});
+	}
+
+}
+
+std::shared_ptr<Trader> AlgoService::createTrader(const std::shared_ptr<AlgoOrder>& algoOrder, const std::shared_ptr<asio::io_context>& contextPtr) {
+
+	switch (algoOrder->algoCategory)
+	{
+	case AlgoMsg::MsgAlgoCategory::Category_ALGO: {
+		return std::make_shared<AlgoTrader>(algoOrder, contextPtr);
+	}
+	case AlgoMsg::MsgAlgoCategory::Category_SHOT: {
+		return std::make_shared<ShotTrader>(algoOrder, contextPtr);
+	}
+	//case AlgoMsg::MsgAlgoCategory::Category_HIT: {
+	//	return std::make_shared<ShotTrader>(algoOrder, contextPtr);
+	//}
+	//case AlgoMsg::MsgAlgoCategory::Category_SPREAD: {
+	//	return std::make_shared<PairTrader>(algoOrder, contextPtr);
+	//}
+	//case AlgoMsg::MsgAlgoCategory::Category_T0: {
+	//	return std::make_shared<PairTrader>(algoOrder, contextPtr);
+	//}
+	default:
+		return nullptr;
+	}
+}
 
-		asio::post(*m_dispatcherContextPtr, [this, traderPtr, algoOrderId, algoOrderPtr]() {
+void AlgoService::submitBackTest(const std::shared_ptr<Trader>& traderPtr) {
 
-			if (not m_algoTraderQueue_bt.empty()) {
+	auto algoOrderId = traderPtr->getAlgoOrderId();
 
-				auto& new_trader = m_algoTraderQueue_bt.front();
+	BacktestTask task{ .taskId = algoOrderId, .name = AlgoMsg::MsgAlgoCategory_Name(traderPtr->getAlgoCategory()) };
 
-				asio::co_spawn(*new_trader->contextPtr, new_trader->start(), std::bind(&AlgoService::onAlgoInstanceFinished, this, new_trader, std::placeholders::_1));
-				
-				m_algoTraderQueue_bt.pop_front();
+	/* 调度到某个 worker 后回到 dispatcher 线程启动, algoOrderId2AlgoTrader 只在 dispatcher 线程读写 */
+	task.run = [this, algoOrderId](const AsioContextPtr& contextPtr, const SlotRelease_t& release) {
 
-				m_runningTraders_bt.fetch_add(1);
+		asio::post(*m_dispatcherContextPtr, [this, algoOrderId, contextPtr, release]() {
 
-				m_runningTraders.fetch_add(1);
+			auto it = algoOrderId2AlgoTrader.find(algoOrderId);
 
-				if (traderPtr->getAlgoCategory() != AlgoMsg::Category_ALGO) {
-					m_runningTraders_bt_costMutiContext.fetch_add(1);
-				}
+			if (it == algoOrderId2AlgoTrader.end() or it->second->isStopped()) {
+				onBackTestChildDone(algoOrderId, it != algoOrderId2AlgoTrader.end() ? it->second->encodePerformanceMessage() : nullptr);
+				release();
+				return;
+			}
+
+			auto traderPtr = it->second;
 
-				SPDLOG_INFO("[REPLAY]running size:{},queue size:{}", m_runningTraders_bt.load(), m_algoTraderQueue_bt.size());
+			/* Trader 的定时器等在构造时绑定 context, 排队期间未启动, 在选中的 worker 上重建 */
+			if (traderPtr->contextPtr != contextPtr) {
+				traderPtr = createTrader(traderPtr->getAlgoOrder(), contextPtr);
+				it->second = traderPtr;
 			}
+
+			traderPtr->releaseSchedulerSlot = release;
+
+			m_runningTraders.fetch_add(1);
+			m_runningTraders_bt.fetch_add(1);
+
+			asio::co_spawn(*contextPtr, traderPtr->start(), [this, traderPtr, release](const std::exception_ptr ex) {
+				onAlgoInstanceFinished(traderPtr, ex);
+				release();
+			});
 		});
+	};
+
+	BacktestScheduler::getInstance().submit(std::move(task));
+
+	SPDLOG_INFO("[aId:{}][{}]submit backtest,{}", algoOrderId, AlgoMsg::MsgAlgoCategory_Name(traderPtr->getAlgoCategory()), BacktestScheduler::getInstance().statInfo());
+}
+
+void AlgoService::createBackTestAggregator(const AlgoMsg::MsgAlgoInstanceCreateRequest& req
+	, const std::vector<std::shared_ptr<AlgoOrder>>& algoOrders
+	, const std::shared_ptr<AlgoMsg::MsgAlgoInstanceCreateResponse>& resp) {
+
+	std::unordered_set<AlgoOrderId_t> successIds{ resp->success_algo_order_id().begin(), resp->success_algo_order_id().end() };
+
+	std::vector<std::shared_ptr<AlgoOrder>> children{};
+	std::set<uint32_t> tradeDates{};
+
+	for (auto& algoOrder : algoOrders) {
+		if (algoOrder->isBackTestOrder() and successIds.contains(algoOrder->algoOrderId)) {
+			children.push_back(algoOrder);
+			tradeDates.insert(agcommon::getDateInt(algoOrder->startTime));
+		}
+	}
+
+	/* 单日请求子单结果即最终结果 */
+	if (tradeDates.size() <= 1) {
+		return;
+	}
+
+	auto aggregateId = AlgoOrderIdGenerator::getInstance().NewId();
+	auto aggregator  = std::make_shared<BacktestAggregator>(aggregateId, children.front(), req.algo_order().symbol());
+
+	for (auto& child : children) {
+		aggregator->addChild(child->algoOrderId, agcommon::getDateInt(child->startTime));
+		m_child2BacktestAggregator[child->algoOrderId] = aggregator;
 	}
 
+	resp->set_aggregate_algo_order_id(aggregateId);
+
+	aggregator->publish();
+
+	SPDLOG_INFO("[aId:{}]backtest aggregate,days:{},children:{}", aggregateId, tradeDates.size(), aggregator->childCount());
+}
+
+void AlgoService::onBackTestChildDone(const AlgoOrderId_t algoOrderId, const std::shared_ptr<google::protobuf::Message>& perfMsg) {
+
+	auto it = m_child2BacktestAggregator.find(algoOrderId);
+	if (it == m_child2BacktestAggregator.end()) {
+		return;
+	}
+
+	auto aggregator = it->second;
+	m_child2BacktestAggregator.erase(it);
+
+	if (aggregator->onChildDone(algoOrderId, perfMsg)) {
+		SPDLOG_INFO("[aId:{}]backtest aggregate done,children:{}", aggregator->aggregateId(), aggregator->childCount());
+	}
 }
 
 void AlgoService::onUpdateAlgoInstanceRequest(const std::shared_ptr<TCPSession> session, const AlgoMsg::MessagePkg& recvPkgPtr) {
@@ -633,7 +695,7 @@ void AlgoService::onUpdateAlgoInstanceRequest(const std::shared_ptr<TCPSession>
 					else {
 
 						resp->set_error_code((int32_t)AlgoErrorCode::ALGO_OK);
-						asio::post(*trader->contextPtr, [trader]() {trader->cancel(); });
+						cancelTrader(trader);
 					}
 				}
 			}
@@ -678,8 +740,33 @@ AlgoErrorCode AlgoService::cancelAlgoOrder(const AlgoOrderId_t algoOrderId, Algo
 
 			else {
 
-				asio::post(*trader->contextPtr, [trader]() {trader->cancel(); });
+				cancelTrader(trader);
 				return AlgoErrorCode::ALGO_OK;
 			}
 		}
 }
+
+void AlgoService::cancelTrader(const std::shared_ptr<Trader>& trader) {
+
+	auto algoOrderId = trader->getAlgoOrderId();
+
+	/* 仍在 BacktestScheduler 中排队的回测不会再被调度, 在此结束并通知汇总 */
+	if (trader->getAlgoOrder()->isBackTestOrder() and BacktestScheduler::getInstance().cancel(algoOrderId)) {
+
+		SPDLOG_INFO("[aId:{}]queued backtest canceled,{}", algoOrderId, BacktestScheduler::getInstance().statInfo());
+
+		asio::post(*trader->contextPtr, [this, trader, algoOrderId]() {
+
+			trader->cancel();
+
+			trader->publishAlgoperformance();
+
+			asio::post(*m_dispatcherContextPtr, [this, algoOrderId, perfMsg = trader->encodePerformanceMessage()]() {
+				onBackTestChildDone(algoOrderId, perfMsg);
+			});
+		});
+		return;
+	}
+
+	asio::post(*trader->contextPtr, [trader]() {trader->cancel(); });
+}
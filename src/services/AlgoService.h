@@ -9,6 +9,7 @@ namespace asio = boost::asio;
 class Trader;
 class AlgoOrder;
 class TCPSession;
+class BacktestAggregator;
 
 class AlgoService {
 
@@ -54,6 +55,20 @@ private:
 
 	void onAlgoInstanceFinished(const std::shared_ptr<Trader> trader_ptr,const std::exception_ptr ex);
 
+	std::shared_ptr<Trader> createTrader(const std::shared_ptr<AlgoOrder>& algoOrder, const std::shared_ptr<asio::io_context>& contextPtr = nullptr);
+
+	void submitBackTest(const std::shared_ptr<Trader>& traderPtr);
+
+	/* 排队中的回测从 BacktestScheduler 移除, 其余投递到 trader 线程取消 */
+	void cancelTrader(const std::shared_ptr<Trader>& trader);
+
+	/* 多日回测: 按日子单成功创建后登记汇总, 子单结束后归约 */
+	void createBackTestAggregator(const AlgoMsg::MsgAlgoInstanceCreateRequest& req
+		, const std::vector<std::shared_ptr<AlgoOrder>>& algoOrders
+		, const std::shared_ptr<AlgoMsg::MsgAlgoInstanceCreateResponse>& resp);
+
+	void onBackTestChildDone(const AlgoOrderId_t algoOrderId, const std::shared_ptr<google::protobuf::Message>& perfMsg);
+
 public:
 
 	std::atomic<bool>	  m_isRunning	  { false };
@@ -94,9 +109,9 @@ public:
 	AlgoErrorCode cancelAlgoOrder(const AlgoOrderId_t algoOrderId, AlgoErrorMessage_t& algoErrorMessage);
 
 
-	// only for bt request
-	std::deque<std::shared_ptr<Trader>>	m_algoTraderQueue_bt{}; // 回测请求队列
-	std::atomic<uint32_t>				m_runningTraders_bt;
-	std::atomic<uint32_t>				m_runningTraders_bt_costMutiContext;  // 
+	// only for bt request, 排队由 BacktestScheduler 负责
+	std::atomic<uint32_t>				m_runningTraders_bt{ 0 };
+
+	std::unordered_map<AlgoOrderId_t, std::shared_ptr<BacktestAggregator>>	m_child2BacktestAggregator{};	// 子单 -> 多日汇总, dispatcher 线程
 };
 
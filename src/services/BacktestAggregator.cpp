@@ -0,0 +1,298 @@
+#include "BacktestAggregator.h"
+#include "AlgoOrder.h"
+#include "TCPSession.h"
+#include "StorageService.h"
+
+BacktestAggregator::BacktestAggregator(AlgoOrderId_t aggregateId, const std::shared_ptr<AlgoOrder>& firstChild, const std::string& symbolRange)
+	: m_aggregateId(aggregateId)
+	, m_firstChild(firstChild)
+	, m_symbolRange(symbolRange)
+	, m_isShot(firstChild->algoCategory == AlgoMsg::MsgAlgoCategory::Category_SHOT) {
+}
+
+void BacktestAggregator::addChild(AlgoOrderId_t childId, uint32_t tradeDate) {
+
+	if (m_child2Date.emplace(childId, tradeDate).second) {
+		m_date2Pending[tradeDate]++;
+	}
+}
+
+bool BacktestAggregator::onChildDone(AlgoOrderId_t childId, const PerfMsgPtr& msg) {
+
+	auto it = m_child2Date.find(childId);
+	if (it == m_child2Date.end() or m_date2Pending[it->second] == 0) {
+		return false;
+	}
+
+	auto tradeDate = it->second;
+
+	if (msg) {
+		m_date2Msgs[tradeDate].push_back(msg);
+	}
+	m_done++;
+
+	if (--m_date2Pending[tradeDate] == 0) {
+
+		if (auto dayMsg = _reduce(m_date2Msgs[tradeDate])) {
+
+			int32_t dayStatus = agcommon::AlgoStatus::Finished;
+			for (auto& childMsg : m_date2Msgs[tradeDate]) {
+				auto status = m_isShot ? std::static_pointer_cast<AlgoMsg::MsgShotPerformance>(childMsg)->algo_status()
+					: static_cast<int32_t>(std::static_pointer_cast<AlgoMsg::MsgAlgoPerformance>(childMsg)->algo_status());
+				if (status == agcommon::AlgoStatus::Error) {
+					dayStatus = agcommon::AlgoStatus::Error;
+				}
+			}
+			_stamp(dayMsg, tradeDate, dayStatus);
+
+			StorageService::getInstance().storeDailyBreakdown(m_aggregateId, tradeDate, dayMsg);
+		}
+		SPDLOG_INFO("[aId:{}]backtest day {} done,children done:{}/{}", m_aggregateId, tradeDate, m_done, m_child2Date.size());
+	}
+
+	if (m_done < m_child2Date.size()) {
+		return false;
+	}
+
+	publish();
+	return true;
+}
+
+void BacktestAggregator::publish() const {
+
+	std::vector<PerfMsgPtr> msgs{};
+	int32_t status = m_done < m_child2Date.size() ? agcommon::AlgoStatus::Running : agcommon::AlgoStatus::Finished;
+	size_t errors = 0;
+
+	for (auto& [tradeDate, dayMsgs] : m_date2Msgs) {
+		for (auto& msg : dayMsgs) {
+			auto childStatus = m_isShot ? std::static_pointer_cast<AlgoMsg::MsgShotPerformance>(msg)->algo_status()
+				: static_cast<int32_t>(std::static_pointer_cast<AlgoMsg::MsgAlgoPerformance>(msg)->algo_status());
+			if (childStatus == agcommon::AlgoStatus::Error) {
+				errors++;
+			}
+			msgs.push_back(msg);
+		}
+	}
+
+	if (status == agcommon::AlgoStatus::Finished and errors > 0) {
+		status = agcommon::AlgoStatus::Error;
+	}
+
+	auto msg = _reduce(msgs);
+	if (not msg) {
+		msg = m_isShot ? PerfMsgPtr(std::make_shared<AlgoMsg::MsgShotPerformance>()) : PerfMsgPtr(std::make_shared<AlgoMsg::MsgAlgoPerformance>());
+	}
+	_stamp(msg, 0, status);
+
+	auto algoMsg = fmt::format("days:{},children:{}/{},errors:{}", m_date2Pending.size(), m_done, m_child2Date.size(), errors);
+
+	if (m_isShot) {
+		std::static_pointer_cast<AlgoMsg::MsgShotPerformance>(msg)->set_algo_msg(algoMsg);
+	}
+	else {
+		std::static_pointer_cast<AlgoMsg::MsgAlgoPerformance>(msg)->set_algo_msg(algoMsg);
+	}
+
+	TCPSessionManager::getInstance().sendNotify2C(m_firstChild->getAcctKey()
+		, m_isShot ? AlgoMsg::CMD_NOTIFY_ShotPerformance : AlgoMsg::CMD_NOTIFY_AlgoExecutionInfo
+		, msg
+		, agcommon::AlgoStatus::isFinalStatus(status));
+}
+
+BacktestAggregator::PerfMsgPtr BacktestAggregator::_reduce(const std::vector<PerfMsgPtr>& msgs) const {
+
+	if (msgs.empty()) {
+		return nullptr;
+	}
+
+	if (m_isShot) {
+		std::vector<std::shared_ptr<AlgoMsg::MsgShotPerformance>> shotMsgs{};
+		for (auto& msg : msgs) {
+			shotMsgs.push_back(std::static_pointer_cast<AlgoMsg::MsgShotPerformance>(msg));
+		}
+		return reduceShotPerformance(shotMsgs);
+	}
+
+	std::vector<std::shared_ptr<AlgoMsg::MsgAlgoPerformance>> algoMsgs{};
+	for (auto& msg : msgs) {
+		algoMsgs.push_back(std::static_pointer_cast<AlgoMsg::MsgAlgoPerformance>(msg));
+	}
+	return reduceAlgoPerformance(algoMsgs);
+}
+
+void BacktestAggregator::_stamp(const PerfMsgPtr& msg, uint32_t tradeDate, int32_t algoStatus) const {
+
+	if (m_isShot) {
+		auto shotMsg = std::static_pointer_cast<AlgoMsg::MsgShotPerformance>(msg);
+		shotMsg->set_algo_order_id(m_aggregateId);
+		shotMsg->set_client_algo_order_id(m_firstChild->clientAlgoOrderId);
+		shotMsg->set_algo_category(m_firstChild->algoCategory);
+		shotMsg->set_algo_strategy(m_firstChild->algoStrategy);
+		shotMsg->set_acct(m_firstChild->acct);
+		shotMsg->set_acct_type(m_firstChild->acctType);
+		shotMsg->set_symbol_range(m_symbolRange);
+		shotMsg->set_algo_status(algoStatus);
+		if (tradeDate > 0) {
+			shotMsg->set_trade_date(tradeDate);
+		}
+		else if (not m_date2Pending.empty()) {
+			shotMsg->set_trade_date(m_date2Pending.begin()->first);
+		}
+		return;
+	}
+
+	auto algoMsg = std::static_pointer_cast<AlgoMsg::MsgAlgoPerformance>(msg);
+	algoMsg->set_algo_order_id(m_aggregateId);
+	algoMsg->set_client_algo_order_id(m_firstChild->clientAlgoOrderId);
+	algoMsg->set_algo_category(m_firstChild->algoCategory);
+	algoMsg->set_algo_strategy(m_firstChild->algoStrategy);
+	algoMsg->set_acct(m_firstChild->acct);
+	algoMsg->set_acct_type(m_firstChild->acctType);
+	algoMsg->set_vendor_id(::AlgoMsg::MsgAlgoVendorId::VendorId_DEFAULT);
+	algoMsg->set_symbol(m_symbolRange);
+	algoMsg->set_order_side(m_firstChild->tradeSide);
+	algoMsg->set_algo_status(algoStatus);
+	algoMsg->set_update_time(agcommon::ptime2Integer(agcommon::now()));
+}
+
+std::shared_ptr<AlgoMsg::MsgAlgoPerformance> BacktestAggregator::reduceAlgoPerformance(const std::vector<std::shared_ptr<AlgoMsg::MsgAlgoPerformance>>& msgs) {
+
+	auto result = std::make_shared<AlgoMsg::MsgAlgoPerformance>();
+
+	uint64_t qtyTarget = 0, qty = 0, qtyFilled = 0, qtyCanceled = 0, qtyRejected = 0;
+	uint32_t orderCnt = 0, orderCntFilled = 0, orderCntCanceled = 0, orderCntRejected = 0;
+	uint64_t startTime = std::numeric_limits<uint64_t>::max(), endTime = 0;
+
+	double amt = 0, qtyMaker = 0, qtyMakerFilled = 0, marketVol = 0, povFilled = 0;
+	double arrivePrice = 0, marketVwap = 0, marketTwap = 0, slipArrive = 0, slipVwap = 0, slipTwap = 0;
+
+	for (auto& msg : msgs) {
+
+		qtyTarget   += msg->qty_target();
+		qty         += msg->qty();
+		qtyFilled   += msg->qty_filled();
+		qtyCanceled += msg->qty_canceled();
+		qtyRejected += msg->qty_rejected();
+
+		orderCnt         += msg->ordercnt();
+		orderCntFilled   += msg->ordercnt_filled();
+		orderCntCanceled += msg->ordercnt_canceled();
+		orderCntRejected += msg->ordercnt_rejected();
+
+		amt += msg->amt();
+
+		startTime = std::min(startTime, msg->start_time());
+		endTime   = std::max(endTime, msg->end_time());
+
+		/* 比率按各自分母还原为数量再合计 */
+		auto totalQty = static_cast<double>(msg->qty() + msg->qty_canceled());
+		auto makerQty = msg->maker_rate() * totalQty / 100.0;
+		qtyMaker       += makerQty;
+		qtyMakerFilled += msg->maker_filled_rate() * makerQty / 100.0;
+
+		if (msg->actual_pov() > 0) {
+			marketVol += msg->qty_filled() * 100.0 / msg->actual_pov();
+			povFilled += msg->qty_filled();
+		}
+
+		/* 价格与滑点按成交金额加权 */
+		arrivePrice += msg->arrive_price() * msg->amt();
+		marketVwap  += msg->market_vwap() * msg->amt();
+		marketTwap  += msg->market_twap() * msg->amt();
+		slipArrive  += msg->slippage_arrive_price() * msg->amt();
+		slipVwap    += msg->slippage_market_vwap() * msg->amt();
+		slipTwap    += msg->slippage_market_twap() * msg->amt();
+	}
+
+	auto totalQty = static_cast<double>(qty + qtyCanceled);
+
+	result->set_qty_target(static_cast<uint32_t>(qtyTarget));
+	result->set_qty(static_cast<uint32_t>(qty));
+	result->set_qty_filled(static_cast<uint32_t>(qtyFilled));
+	result->set_qty_canceled(static_cast<uint32_t>(qtyCanceled));
+	result->set_qty_rejected(static_cast<uint32_t>(qtyRejected));
+	result->set_ordercnt(orderCnt);
+	result->set_ordercnt_filled(orderCntFilled);
+	result->set_ordercnt_canceled(orderCntCanceled);
+	result->set_ordercnt_rejected(orderCntRejected);
+	result->set_amt(amt);
+	result->set_avg_price(qtyFilled > 0 ? amt / qtyFilled : 0.0);
+
+	result->set_filled_rate(totalQty > 0 ? qtyFilled * 100.0 / totalQty : 0.0);
+	result->set_cancel_rate(totalQty > 0 ? qtyCanceled * 100.0 / totalQty : 0.0);
+	result->set_maker_rate(totalQty > 0 ? qtyMaker * 100.0 / totalQty : 0.0);
+	result->set_maker_filled_rate(qtyMaker > 0 ? qtyMakerFilled * 100.0 / qtyMaker : 0.0);
+	result->set_actual_pov(marketVol > 0 ? povFilled * 100.0 / marketVol : 0.0);
+
+	result->set_arrive_price(amt > 0 ? arrivePrice / amt : 0.0);
+	result->set_market_vwap(amt > 0 ? marketVwap / amt : 0.0);
+	result->set_market_twap(amt > 0 ? marketTwap / amt : 0.0);
+	result->set_slippage_arrive_price(amt > 0 ? slipArrive / amt : 0.0);
+	result->set_slippage_market_vwap(amt > 0 ? slipVwap / amt : 0.0);
+	result->set_slippage_market_twap(amt > 0 ? slipTwap / amt : 0.0);
+
+	if (not msgs.empty()) {
+		result->set_start_time(startTime);
+		result->set_end_time(endTime);
+		result->set_exec_duration(msgs.front()->exec_duration());
+	}
+	return result;
+}
+
+std::shared_ptr<AlgoMsg::MsgShotPerformance> BacktestAggregator::reduceShotPerformance(const std::vector<std::shared_ptr<AlgoMsg::MsgShotPerformance>>& msgs) {
+
+	auto result = std::make_shared<AlgoMsg::MsgShotPerformance>();
+
+	int32_t symbolCount = 0, signalCount = 0;
+	uint64_t startTime = std::numeric_limits<uint64_t>::max(), endTime = 0, createTime = std::numeric_limits<uint64_t>::max();
+
+	double tradeAmount = 0, wins = 0, losses = 0, pnlWin = 0, pnlLoss = 0;
+	double pnl = 0, pnlThisDay = 0, nextDayOpenReturn = 0;
+
+	for (auto& msg : msgs) {
+
+		symbolCount += msg->symbol_count();
+		signalCount += msg->signal_count();
+		tradeAmount += msg->trade_amount();
+
+		startTime  = std::min(startTime, msg->start_time());
+		endTime    = std::max(endTime, msg->end_time());
+		createTime = std::min(createTime, msg->create_time());
+
+		/* 均值按信号数加权, 盈/亏均值按盈/亏信号数加权 */
+		auto n       = static_cast<double>(msg->signal_count());
+		auto winCnt  = msg->win_rate() * n / 100.0;
+		auto lossCnt = n - winCnt;
+
+		wins    += winCnt;
+		losses  += lossCnt;
+		pnlWin  += msg->avg_pnl_win() * winCnt;
+		pnlLoss += msg->avg_pnl_loss() * lossCnt;
+
+		pnl               += msg->avg_pnl() * n;
+		pnlThisDay        += msg->avg_pnl_this_day() * n;
+		nextDayOpenReturn += msg->avg_next_day_open_return() * n;
+	}
+
+	auto avgPnlWin  = wins   > 0 ? pnlWin / wins : 0.0;
+	auto avgPnlLoss = losses > 0 ? pnlLoss / losses : 0.0;
+
+	result->set_symbol_count(symbolCount);
+	result->set_signal_count(signalCount);
+	result->set_trade_amount(tradeAmount);
+	result->set_win_rate(wins + losses > 0 ? wins * 100.0 / (wins + losses) : 0.0);
+	result->set_avg_pnl_win(avgPnlWin);
+	result->set_avg_pnl_loss(avgPnlLoss);
+	result->set_profit2_loss_ratio(avgPnlWin > 0 and avgPnlLoss < 0 ? avgPnlWin / avgPnlLoss * -1 : 0.0);
+	result->set_avg_pnl(signalCount > 0 ? pnl / signalCount : 0.0);
+	result->set_avg_pnl_this_day(signalCount > 0 ? pnlThisDay / signalCount : 0.0);
+	result->set_avg_next_day_open_return(signalCount > 0 ? nextDayOpenReturn / signalCount : 0.0);
+
+	if (not msgs.empty()) {
+		result->set_start_time(startTime);
+		result->set_end_time(endTime);
+		result->set_create_time(createTime);
+	}
+	return result;
+}
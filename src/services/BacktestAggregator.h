@@ -0,0 +1,62 @@
+#pragma once
+
+#include <map>
+#include "typedefs.h"
+#include "AlgoMessages.pb.h"
+
+class AlgoOrder;
+
+/*
+* 多日回测汇总: 一个请求按交易日拆成的子单各自独立回放, 子单结束后将其最终绩效归约
+*   按日: 当日全部子单结束后归约为日汇总, 经 StorageService 存入 BacktestDailyPerformance
+*   整体: 全部子单结束后归约为一条 MsgAlgoPerformance/MsgShotPerformance, 以 aggregateId 推送并存储
+* 只在 AlgoService dispatcher 线程访问
+*/
+
+class BacktestAggregator {
+
+public:
+
+	using PerfMsgPtr = std::shared_ptr<google::protobuf::Message>;
+
+	BacktestAggregator(AlgoOrderId_t aggregateId, const std::shared_ptr<AlgoOrder>& firstChild, const std::string& symbolRange);
+
+	void addChild(AlgoOrderId_t childId, uint32_t tradeDate);
+
+	/* 返回 true 表示全部子单已结束, 已推送汇总 */
+	bool onChildDone(AlgoOrderId_t childId, const PerfMsgPtr& msg);
+
+	/* 推送当前(运行中)汇总, 客户端据此得知 aggregateId */
+	void publish() const;
+
+	inline AlgoOrderId_t aggregateId() const { return m_aggregateId; }
+
+	inline size_t childCount() const { return m_child2Date.size(); }
+
+	static std::shared_ptr<AlgoMsg::MsgAlgoPerformance> reduceAlgoPerformance(const std::vector<std::shared_ptr<AlgoMsg::MsgAlgoPerformance>>& msgs);
+
+	static std::shared_ptr<AlgoMsg::MsgShotPerformance> reduceShotPerformance(const std::vector<std::shared_ptr<AlgoMsg::MsgShotPerformance>>& msgs);
+
+private:
+
+	PerfMsgPtr _reduce(const std::vector<PerfMsgPtr>& msgs) const;
+
+	/* 填充汇总单自身的标识字段 */
+	void _stamp(const PerfMsgPtr& msg, uint32_t tradeDate, int32_t algoStatus) const;
+
+	AlgoOrderId_t									m_aggregateId{ 0 };
+
+	std::shared_ptr<AlgoOrder>						m_firstChild{ nullptr };
+
+	std::string										m_symbolRange{};
+
+	bool											m_isShot{ false };
+
+	std::unordered_map<AlgoOrderId_t, uint32_t>		m_child2Date{};
+
+	std::map<uint32_t, size_t>						m_date2Pending{};
+
+	std::map<uint32_t, std::vector<PerfMsgPtr>>		m_date2Msgs{};
+
+	size_t											m_done{ 0 };
+};
@@ -0,0 +1,180 @@
+#include "BacktestScheduler.h"
+#include <spdlog/spdlog.h>
+
+void BacktestScheduler::init(const std::vector<AsioContextPtr>& workerContexts, uint32_t slotsPerWorker /*= 1*/) {
+
+	std::scoped_lock lock(m_mutex);
+
+	if (not m_workers.empty()) {
+		SPDLOG_WARN("BacktestScheduler already inited,workers:{}", m_workers.size());
+		return;
+	}
+
+	m_slotsPerWorker = std::max<uint32_t>(slotsPerWorker, 1);
+
+	for (auto& contextPtr : workerContexts) {
+		m_workers.push_back(Worker{ .contextPtr = contextPtr });
+	}
+
+	SPDLOG_INFO("BacktestScheduler init,workers:{},slotsPerWorker:{}", m_workers.size(), m_slotsPerWorker);
+}
+
+size_t BacktestScheduler::_pickWorker() {
+
+	for (size_t i = 0; i < m_workers.size(); i++) {
+		if (m_workers[i].contextPtr->get_executor().running_in_this_thread()) {
+			return i;
+		}
+	}
+
+	size_t idx = 0;
+	size_t minLoad = std::numeric_limits<size_t>::max();
+
+	for (size_t i = 0; i < m_workers.size(); i++) {
+		auto load = m_workers[i].tasks.size() + m_workers[i].running;
+		if (load < minLoad) {
+			minLoad = load;
+			idx = i;
+		}
+	}
+	return idx;
+}
+
+void BacktestScheduler::submit(BacktestTask&& task, bool urgent /*= false*/) {
+
+	std::vector<Launch_t> launches{};
+	{
+		std::scoped_lock lock(m_mutex);
+
+		if (m_workers.empty()) {
+			SPDLOG_ERROR("[{}]BacktestScheduler not inited,task dropped:{}", task.taskId, task.name);
+			return;
+		}
+
+		auto idx = _pickWorker();
+
+		if (urgent) {
+			m_workers[idx].tasks.push_front(std::move(task));
+		}
+		else {
+			m_workers[idx].tasks.push_back(std::move(task));
+		}
+		m_submitted++;
+
+		_dispatch(launches);
+	}
+	_launch(launches);
+}
+
+bool BacktestScheduler::cancel(uint64_t taskId) {
+
+	std::scoped_lock lock(m_mutex);
+
+	for (auto& worker : m_workers) {
+		auto it = std::find_if(worker.tasks.begin(), worker.tasks.end(), [taskId](const BacktestTask& t) { return t.taskId == taskId; });
+		if (it != worker.tasks.end()) {
+			worker.tasks.erase(it);
+			return true;
+		}
+	}
+	return false;
+}
+
+void BacktestScheduler::_dispatch(std::vector<Launch_t>& launches) {
+
+	for (size_t i = 0; i < m_workers.size(); i++) {
+
+		auto& worker = m_workers[i];
+
+		while (worker.running < m_slotsPerWorker) {
+
+			if (not worker.tasks.empty()) {
+				launches.emplace_back(i, std::move(worker.tasks.front()));
+				worker.tasks.pop_front();
+			}
+			else {
+				/* 从最长队列队尾窃取 */
+				auto victim = std::max_element(m_workers.begin(), m_workers.end(), [](const Worker& a, const Worker& b) { return a.tasks.size() < b.tasks.size(); });
+				if (victim == m_workers.end() or victim->tasks.empty()) {
+					break;
+				}
+				launches.emplace_back(i, std::move(victim->tasks.back()));
+				victim->tasks.pop_back();
+				worker.stolen++;
+				m_steals++;
+			}
+			worker.running++;
+			worker.executed++;
+		}
+	}
+}
+
+void BacktestScheduler::_launch(std::vector<Launch_t>& launches) {
+
+	for (auto& [idx, task] : launches) {
+
+		auto released = std::make_shared<std::atomic<bool>>(false);
+
+		SlotRelease_t release = [this, idx, released]() {
+			if (not released->exchange(true)) {
+				_onRelease(idx);
+			}
+		};
+
+		SPDLOG_DEBUG("[{}]backtest task launch on worker:{},{}", task.taskId, idx, task.name);
+
+		asio::post(*m_workers[idx].contextPtr, [contextPtr = m_workers[idx].contextPtr, run = std::move(task.run), release]() {
+			run(contextPtr, release);
+		});
+	}
+}
+
+void BacktestScheduler::_onRelease(size_t workerIdx) {
+
+	std::vector<Launch_t> launches{};
+	{
+		std::scoped_lock lock(m_mutex);
+
+		if (m_workers[workerIdx].running > 0) {
+			m_workers[workerIdx].running--;
+		}
+		_dispatch(launches);
+	}
+	_launch(launches);
+}
+
+size_t BacktestScheduler::queueDepth() {
+
+	std::scoped_lock lock(m_mutex);
+
+	size_t depth = 0;
+	for (auto& worker : m_workers) {
+		depth += worker.tasks.size();
+	}
+	return depth;
+}
+
+uint64_t BacktestScheduler::stealCount() {
+
+	std::scoped_lock lock(m_mutex);
+	return m_steals;
+}
+
+std::string BacktestScheduler::statInfo() {
+
+	std::scoped_lock lock(m_mutex);
+
+	size_t depth = 0;
+	uint32_t running = 0;
+	std::string detail{};
+
+	for (size_t i = 0; i < m_workers.size(); i++) {
+		auto& worker = m_workers[i];
+		depth   += worker.tasks.size();
+		running += worker.running;
+		detail  += fmt::format(" w{}:{}/{}/{}/{}", i + 1, worker.tasks.size(), worker.running, worker.executed, worker.stolen);
+	}
+
+	return fmt::format("submitted:{},queued:{},running:{},steals:{},[queue/running/executed/stolen]{}"
+		, m_submitted, depth, running, m_steals, detail);
+}
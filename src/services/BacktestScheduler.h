@@ -0,0 +1,83 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <functional>
+#include "ContextService.h"
+
+/*
+* 回测任务调度: 每个 worker context 一个任务队列, worker 空闲时先取自己队首, 自己队列为空时从最长队列的队尾窃取
+* 任务 run(ctx, release) 在选中的 ctx 上执行, 回测结束(或转为只做汇总)时调用 release 归还该 worker 的执行槽位
+* 回测任务粒度为秒~分钟级, 队列用一把锁保护即可
+*/
+
+using SlotRelease_t = std::function<void()>;
+
+struct BacktestTask {
+
+	uint64_t		taskId{ 0 };
+
+	std::string		name{};
+
+	std::function<void(const AsioContextPtr&, const SlotRelease_t&)>	run{ nullptr };
+};
+
+class BacktestScheduler {
+
+public:
+
+	static BacktestScheduler& getInstance() {
+		static BacktestScheduler instance{};
+		return instance;
+	}
+
+	BacktestScheduler(const BacktestScheduler&) = delete;
+	BacktestScheduler& operator=(const BacktestScheduler&) = delete;
+
+	void init(const std::vector<AsioContextPtr>& workerContexts, uint32_t slotsPerWorker = 1);
+
+	/* worker 线程内提交的任务进入本 worker 队列, 其他线程提交的进入最空闲 worker 队列; urgent 插入队首 */
+	void submit(BacktestTask&& task, bool urgent = false);
+
+	/* 仅能取消尚未开始的任务 */
+	bool cancel(uint64_t taskId);
+
+	size_t queueDepth();
+
+	uint64_t stealCount();
+
+	std::string statInfo();
+
+private:
+
+	BacktestScheduler() = default;
+
+	struct Worker {
+		AsioContextPtr				contextPtr{ nullptr };
+		std::deque<BacktestTask>	tasks{};
+		uint32_t					running{ 0 };
+		uint64_t					executed{ 0 };
+		uint64_t					stolen{ 0 };	// 从其他 worker 窃取的任务数
+	};
+
+	using Launch_t = std::pair<size_t, BacktestTask>;
+
+	size_t _pickWorker();
+
+	/* 为空闲 worker 分配任务, 需持锁调用; 返回的任务在锁外投递 */
+	void _dispatch(std::vector<Launch_t>& launches);
+
+	void _launch(std::vector<Launch_t>& launches);
+
+	void _onRelease(size_t workerIdx);
+
+	std::mutex				m_mutex;
+
+	std::vector<Worker>		m_workers{};
+
+	uint32_t				m_slotsPerWorker{ 1 };
+
+	uint64_t				m_submitted{ 0 };
+
+	uint64_t				m_steals{ 0 };
+};
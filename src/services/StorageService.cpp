@@ -64,6 +64,23 @@ void StorageService::createTable(sqlite3* db) {
         throw std::runtime_error("Table creation failed");
     }
 
+    createTableSQL = R"(
+        CREATE TABLE IF NOT EXISTS BacktestDailyPerformance (
+            aggregate_algo_order_id INTEGER,
+            trade_date INTEGER,
+            algo_category INTEGER,
+            obj_data BLOB,
+            last_update_time TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+            PRIMARY KEY (aggregate_algo_order_id,trade_date)
+        );
+    )";
+
+    if (sqlite3_exec(db, createTableSQL.data(), nullptr, nullptr, &errmsg) != SQLITE_OK) {
+        SPDLOG_ERROR("Error creating table:{}", errmsg);
+        sqlite3_free(errmsg);
+        throw std::runtime_error("Table creation failed");
+    }
+
     createTableSQL = R"(
         CREATE TABLE IF NOT EXISTS MsgOrder (
             algo_order_id   INTEGER,
@@ -217,4 +234,52 @@ void StorageService::storeMessage(const std::shared_ptr<AlgoMsg::MsgAlgoPerforma
     }
     sqlite3_finalize(stmt);
 
-};
\ No newline at end of file
+};
+
+void StorageService::storeDailyBreakdown(const AlgoOrderId_t aggregateId, const uint32_t tradeDate, const std::shared_ptr<google::protobuf::Message> msg) {
+
+    m_runContextPtr->post([aggregateId, tradeDate, msg, this]() {
+        _storeDailyBreakdown(aggregateId, tradeDate, msg);
+    });
+}
+
+void StorageService::_storeDailyBreakdown(const AlgoOrderId_t aggregateId, const uint32_t tradeDate, const std::shared_ptr<google::protobuf::Message> msg) {
+
+    const char* insertOrReplaceSQL = R"(
+        INSERT OR REPLACE INTO BacktestDailyPerformance (
+            aggregate_algo_order_id,
+            trade_date,
+            algo_category,
+            obj_data
+        )
+        VALUES (?, ?, ?, ?)
+    )";
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db, insertOrReplaceSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+
+        SPDLOG_ERROR("Failed to prepare statement:{}", sqlite3_errmsg(m_db));
+        return;
+    }
+
+    auto algoCategory = dynamic_cast<const AlgoMsg::MsgShotPerformance*>(msg.get()) ? AlgoMsg::MsgAlgoCategory::Category_SHOT : AlgoMsg::MsgAlgoCategory::Category_ALGO;
+
+    sqlite3_bind_int64(stmt, 1, aggregateId);
+
+    sqlite3_bind_int(stmt, 2, tradeDate);
+
+    sqlite3_bind_int(stmt, 3, algoCategory);
+
+    std::string msgstr;
+
+    if (msg->SerializeToString(&msgstr)) {
+
+        sqlite3_bind_blob(stmt, 4, msgstr.data(), msgstr.size(), SQLITE_TRANSIENT);
+    }
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        SPDLOG_ERROR("Failed to execute statement:{}", sqlite3_errmsg(m_db));
+    }
+    sqlite3_finalize(stmt);
+
+};
@@ -18,6 +18,12 @@ public:
 
 	void storeMessage(const AlgoMsg::MsgAlgoCMD cmd, const std::shared_ptr<google::protobuf::Message> msg) {
 
+		/* 行情/订单等不落库, 不投递, 避免每笔通知一次任务分配 */
+		if (cmd != AlgoMsg::CMD_NOTIFY_ShotPerformance and cmd != AlgoMsg::CMD_NOTIFY_ShotSignalInfo
+			and cmd != AlgoMsg::CMD_NOTIFY_AlgoExecutionInfo) {
+			return;
+		}
+
 		m_runContextPtr->post([cmd,msg,this]() {
 
 			switch (cmd)
@@ -45,6 +51,9 @@ public:
 		});
 	}
 
+	/* 多日回测按日汇总, msg 为 MsgAlgoPerformance 或 MsgShotPerformance */
+	void storeDailyBreakdown(const AlgoOrderId_t aggregateId, const uint32_t tradeDate, const std::shared_ptr<google::protobuf::Message> msg);
+
 	void createTable(sqlite3* db);
 
 private:
@@ -64,4 +73,6 @@ private:
 	void storeMessage(const std::shared_ptr<AlgoMsg::MsgShotPerformance> msg);
 
 	void storeMessage(const std::shared_ptr<AlgoMsg::MsgAlgoPerformance> msg);
+
+	void _storeDailyBreakdown(const AlgoOrderId_t aggregateId, const uint32_t tradeDate, const std::shared_ptr<google::protobuf::Message> msg);
 };
\ No newline at end of file
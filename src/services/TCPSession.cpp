@@ -4,6 +4,13 @@
 #include "Order.h"
 #include "IdGenerator.h"
 #include "ContextService.h"
+#include "BacktestScheduler.h"
+#include "EventBus.h"
+#include "Configs.h"
+#include <google/protobuf/io/coded_stream.h>
+#if defined(__linux__)
+#include <netinet/tcp.h>
+#endif
 
 TCPSession::TCPSession(std::shared_ptr<asio::io_context> io_context)
           :m_io_context(io_context)
@@ -12,7 +19,13 @@ TCPSession::TCPSession(std::shared_ptr<asio::io_context> io_context)
 
     m_receivingBuffer.reserve(1024);
 
-    m_sendingBuffer.reserve(2048);
+    auto& configs = agcommon::Configs::getConfigs();
+
+    m_sendBatchBytes = static_cast<size_t>(std::max(configs.getConfigOrDefault("HOSTCONFIG", "SendBatchBytes", 64 * 1024), 1));
+    m_tcpNoDelay     = configs.getConfigOrDefault("HOSTCONFIG", "TcpNoDelay", 1) != 0;
+    m_tcpCork        = configs.getConfigOrDefault("HOSTCONFIG", "TcpCork", 0) != 0;
+
+    m_gatherBuffers.reserve(MaxFramesPerWrite);
 }
 
 void TCPSession::start(const AlgoMessagePkgHandle_t& handler)
@@ -29,9 +42,14 @@ void TCPSession::start(const AlgoMessagePkgHandle_t& handler)
 
     auto port = m_socket.remote_endpoint().port();
 
-    //m_socket.set_option(asio::ip::tcp::no_delay(true));
+    boost::system::error_code ec;
+    m_socket.set_option(asio::ip::tcp::no_delay(m_tcpNoDelay), ec);
+    if (ec) {
+        SPDLOG_WARN("socket {} set TCP_NODELAY failed:{}", (int)m_socketHandle, ec.message());
+    }
 
-    SPDLOG_INFO("new TCPSession::started,socket:{},isOpen:{},remote_ep:{}:{}", (int)m_socketHandle,m_socket.is_open(), ip,port);
+    SPDLOG_INFO("new TCPSession::started,socket:{},isOpen:{},remote_ep:{}:{},noDelay:{},cork:{},sendBatchBytes:{}"
+        , (int)m_socketHandle,m_socket.is_open(), ip,port, m_tcpNoDelay, m_tcpCork, m_sendBatchBytes);
 }
 
 asio::ip::tcp::socket& TCPSession::socket(){
@@ -97,11 +115,11 @@ void TCPSession::do_read_body(size_t body_length) {
         });
 }
 
-void TCPSession::queueSendMessage2C(const std::shared_ptr<AlgoMsg::MessagePkg>& pkgPtr) {
+void TCPSession::queueSendMessage2C(const OutboundMessage& message) {
 
-    asio::post(m_strand, [self= shared_from_this(), pkgPtr]() {
+    asio::post(m_strand, [self= shared_from_this(), message]() {
 
-        self->sendingMessageQueue.emplace_back( pkgPtr);
+        self->sendingMessageQueue.emplace_back(message);
 
         if (self->sendingMessageQueue.size() > 1) {
             return;
@@ -111,67 +129,90 @@ void TCPSession::queueSendMessage2C(const std::shared_ptr<AlgoMsg::MessagePkg>&
     );
 }
 
+/*
+* 聚合写: 队首起连续的帧(不超过 m_sendBatchBytes 字节/MaxFramesPerWrite 帧, 至少一帧)一次 gather 写出
+* 写期间这些帧留在队首, 新消息排在其后, 完成后整体出队
+*/
 void TCPSession::_send() {
 
-    if (sendingMessageQueue.empty()) {
+    if (sendingMessageQueue.empty() or not m_socket.is_open()) {
         return;
     }
 
-    auto& sendPkgPtr = sendingMessageQueue.front();
-
-    auto messageSeqId = sendPkgPtr->head().msg_seq_id();
-
-    size_t pkgBodyByteSize = sendPkgPtr->ByteSizeLong();
-
-    auto buffer_size = 4 + pkgBodyByteSize;
+    size_t frames = 0;
+    size_t bytes  = 0;
 
-    while (m_sendingBuffer.capacity() < buffer_size) {
+    m_gatherBuffers.clear();
 
-        buffer_size = (buffer_size / 1024) * 1024 + 1024;
+    for (const auto& message : sendingMessageQueue) {
 
-        SPDLOG_INFO("m_sendingBuffer capacity {},RESIZE TO :{} ", m_sendingBuffer.capacity(), buffer_size);
-        m_sendingBuffer.clear();
+        const auto frameSize = message.frame->size();
 
-        m_sendingBuffer.reserve(buffer_size);
+        if (frames > 0 and (frames >= MaxFramesPerWrite or bytes + frameSize > m_sendBatchBytes)) {
+            break;
+        }
+        m_gatherBuffers.emplace_back(message.frame->data(), frameSize);
+        bytes += frameSize;
+        ++frames;
     }
 
-    size_t headByteSize = encodeHeader(m_sendingBuffer.data(), pkgBodyByteSize);
-
-    sendPkgPtr->SerializeToArray(m_sendingBuffer.data() + headByteSize, pkgBodyByteSize);
-         
-    size_t send_size = headByteSize + pkgBodyByteSize;
-    if (m_socket.is_open()) {
+    if (m_tcpCork and not m_corked) {
+        _setCork(true);
+    }
 
-        SPDLOG_DEBUG("send cmd {},messageid:{},current:{}", (uint32_t)sendPkgPtr->head().msg_cmd(), messageSeqId, sendingMessageQueue.size());
+    SPDLOG_DEBUG("send frames:{},bytes:{},current:{}", frames, bytes, sendingMessageQueue.size());
 
-        asio::async_write(m_socket, asio::buffer(m_sendingBuffer.data(), send_size),
+    asio::async_write(m_socket, m_gatherBuffers, asio::bind_executor(m_strand,
 
-            [self = shared_from_this(), sendPkgPtr, messageSeqId](boost::system::error_code ec, std::size_t bytes_transferred) {
+        [self = shared_from_this(), frames, bytes](boost::system::error_code ec, std::size_t bytes_transferred) {
 
-                auto cmd = sendPkgPtr->head().msg_cmd();
+            if (!ec) {
 
-                if (!ec) {
-                    TCPSessionManager::getInstance().sendMessagesOffset(sendPkgPtr);
+                std::vector<OutboundMessage> sentMessages{};
+                sentMessages.reserve(frames);
 
+                for (size_t i = 0; i < frames; ++i) {
+                    sentMessages.push_back(std::move(self->sendingMessageQueue.front()));
                     self->sendingMessageQueue.pop_front();
+                }
 
-                    SPDLOG_DEBUG("NotifyOK.cmd {},messageid:{},remain:{}", (uint32_t)cmd, messageSeqId, self->sendingMessageQueue.size());
+                auto& sessionManager = TCPSessionManager::getInstance();
+                sessionManager.onFramesSent(frames, bytes);
+                sessionManager.sendMessagesOffset(std::move(sentMessages));
 
-                    if (not self->sendingMessageQueue.empty()) {
+                SPDLOG_DEBUG("NotifyOK.frames:{},bytes:{},remain:{}", frames, bytes, self->sendingMessageQueue.size());
 
-                        asio::post(self->m_strand, [self]() {self->_send(); });
-                    }
+                if (not self->sendingMessageQueue.empty()) {
+                    self->_send();
                 }
-                else
-                {
-                    SPDLOG_INFO("send Failed.cmd {},messageid:{}", (uint32_t)cmd, messageSeqId);
+                else if (self->m_corked) {
+                    self->_setCork(false);      // 队列排空, 立即发出不足一个报文段的尾部
+                }
+            }
+            else
+            {
+                const auto& message = self->sendingMessageQueue.front();
 
-                    SPDLOG_INFO("socket {} with error:{}", (int)self->m_socketHandle, ec.message());
+                SPDLOG_INFO("send Failed.frames:{},cmd {},messageid:{}", frames, (uint32_t)message.cmd, message.messageSeqId);
 
-                    self->safeDisConnect();
-                }
-            });
+                SPDLOG_INFO("socket {} with error:{}", (int)self->m_socketHandle, ec.message());
+
+                self->safeDisConnect();
+            }
+        }));
+}
+
+void TCPSession::_setCork(bool cork) {
+
+#if defined(__linux__)
+    int value = cork ? 1 : 0;
+    if (::setsockopt(m_socket.native_handle(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value)) != 0) {
+        SPDLOG_WARN("socket {} set TCP_CORK {} failed:{}", (int)m_socketHandle, value, errno);
+        m_tcpCork = false;
+        return;
     }
+#endif
+    m_corked = cork;
 }
  
 void TCPSession::safeDisConnect() {
@@ -209,6 +250,32 @@ size_t TCPSession::encodeHeader(unsigned char* buf, size_t body_length) {
     return 4;
 }
 
+std::shared_ptr<const MessagePool::Frame> TCPSessionManager::encodeFrame(const AlgoMsg::MessagePkg& pkg, const google::protobuf::Message& body) {
+
+    using google::protobuf::io::CodedOutputStream;
+
+    constexpr uint32_t BodyTag = (3 << 3) | 2;     // MessagePkg.body, length-delimited
+
+    const size_t pkgByteSize  = pkg.ByteSizeLong();
+    const size_t bodyByteSize = body.ByteSizeLong();
+
+    /* body 为 optional bytes(显式存在性), 经 mutable_body() 置位后总会编码: 长度为 0 时也写 tag 与长度(1a 00) */
+    const size_t bodyField    = CodedOutputStream::VarintSize32(BodyTag) + CodedOutputStream::VarintSize32(static_cast<uint32_t>(bodyByteSize)) + bodyByteSize;
+
+    auto frame = MessagePool::getInstance().acquireFrame(4 + pkgByteSize + bodyField);
+
+    auto pos = frame->data();
+    pos += TCPSession::encodeHeader(pos, pkgByteSize + bodyField);
+    pos  = pkg.SerializeWithCachedSizesToArray(pos);
+
+    pos = CodedOutputStream::WriteVarint32ToArray(BodyTag, pos);
+    pos = CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(bodyByteSize), pos);
+    pos = body.SerializeWithCachedSizesToArray(pos);
+    assert(pos == frame->data() + frame->size());
+
+    return frame;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
@@ -261,11 +328,24 @@ void TCPSessionManager::printStatInfo() {
             , acctCnt
             , remainMessageCnt
             , m_sentMessageCnt.load());
+
+        auto writes = m_sendWrites.load();
+        SPDLOG_INFO("[Send]writes:{},msgs/write:{:.2f},bytes/write:{:.0f},maxMsgs/write:{}"
+            , writes
+            , writes > 0 ? static_cast<double>(m_sentMessageCnt.load()) / writes : 0.0
+            , writes > 0 ? static_cast<double>(m_sendBytes.load()) / writes : 0.0
+            , m_sendMaxFramesPerWrite.load());
         
-        SPDLOG_INFO("MarketDepth alives:{},Order alives:{},Trade alives:{}"
-            , MarketDepth::totalAliveObjectCount.load()
-            , Order::totalAliveObjectCount.load()
-            , Trade::totalAliveObjectCount.load());
+        SPDLOG_INFO("[Pool]MarketDepth {};Order {};Trade {}"
+            , MarketDepth::poolStat().to_string()
+            , Order::poolStat().to_string()
+            , Trade::poolStat().to_string());
+
+        SPDLOG_INFO("[MessagePool]{}", MessagePool::getInstance().to_string());
+
+        SPDLOG_INFO("[Backtest]{}", BacktestScheduler::getInstance().statInfo());
+
+        SPDLOG_INFO("[Bus]{}", EventBusStat::getInstance().statInfo());
     }
 
     m_timer.expires_after(std::chrono::seconds(15));
@@ -383,7 +463,14 @@ void TCPSessionManager::send(const std::shared_ptr<TCPSession>& session
 
     m_strand.post([this, session, acctKey, direction, cmd, messageBody, shouldCache]() {
 
-        auto sendPkgPtr   = std::make_shared<AlgoMsg::MessagePkg>();
+        /* body 在 Arena 上时 pkg 分配在同一 Arena; pkg 只用于编码, 不进缓存 */
+        std::shared_ptr<AlgoMsg::MessagePkg> sendPkgPtr{ nullptr };
+        if (auto arena = messageBody->GetArena()) {
+            sendPkgPtr = std::shared_ptr<AlgoMsg::MessagePkg>(messageBody, google::protobuf::Arena::CreateMessage<AlgoMsg::MessagePkg>(arena));
+        }
+        else {
+            sendPkgPtr = MessagePool::getInstance().create<AlgoMsg::MessagePkg>();
+        }
 
         auto messageSeqId = MessageIdGenerator::getInstance().NewId();
 
@@ -394,12 +481,12 @@ void TCPSessionManager::send(const std::shared_ptr<TCPSession>& session
         sendPkgPtr->mutable_clientkey()->set_acct(acctKey.acct);
         sendPkgPtr->mutable_clientkey()->set_broker(acctKey.broker);
 
-        messageBody->SerializeToString(sendPkgPtr->mutable_body());
+        const OutboundMessage message{ messageSeqId, cmd, acctKey, encodeFrame(*sendPkgPtr, *messageBody) };
 
         SPDLOG_DEBUG("sendNotify2C,cmd:{},messageSeqId:{}", (uint32_t)cmd, messageSeqId);
 
         if (shouldCache) {
-            auto containerIt = messageId2Pkg.emplace_hint(messageId2Pkg.end(), messageSeqId, sendPkgPtr);
+            auto containerIt = messageId2Pkg.emplace_hint(messageId2Pkg.end(), messageSeqId, message);
 
             auto& m_it = acct2MessageIter[acctKey];
 
@@ -408,7 +495,7 @@ void TCPSessionManager::send(const std::shared_ptr<TCPSession>& session
 
         if (session != nullptr) {
 
-            session->queueSendMessage2C(sendPkgPtr);
+            session->queueSendMessage2C(message);
         }
         else {
 
@@ -418,7 +505,7 @@ void TCPSessionManager::send(const std::shared_ptr<TCPSession>& session
 
                 for (auto& [socketHandle,session] : sessions->second) {
 
-                    session->queueSendMessage2C(sendPkgPtr);
+                    session->queueSendMessage2C(message);
                 }
             }
             //else {
@@ -429,18 +516,26 @@ void TCPSessionManager::send(const std::shared_ptr<TCPSession>& session
 	});
 }
 
-void TCPSessionManager::sendMessagesOffset(const std::shared_ptr<AlgoMsg::MessagePkg>& pkgPtr) {
+void TCPSessionManager::sendMessagesOffset(std::vector<OutboundMessage>&& messages) {
 
+    m_strand.post([this, messages = std::move(messages)]() {
 
-    m_strand.post([this, pkgPtr]() {
+        for (const auto& message : messages) {
 
-        auto  messageSeqId  = pkgPtr->head().msg_seq_id();
-        auto& clientKey     = pkgPtr->clientkey();
-        auto  acctKey       = AcctKey_t(clientKey.acct_type(), clientKey.acct(), clientKey.broker());
+            acctSentAcknMaxMessageId[message.acctKey] = message.messageSeqId;     // 存储最近发送成功的 NOTIFY  重登录从 acct2MessageIter 发送 messageSeqId 之后的消息
+        }
+    });
+}
 
-        acctSentAcknMaxMessageId[acctKey] = messageSeqId;     // 存储最近发送成功的 NOTIFY  重登录从 acct2MessageIter 发送 messageSeqId 之后的消息
+void TCPSessionManager::onFramesSent(size_t frames, size_t bytes) {
 
-    });
+    m_sentMessageCnt += frames;
+    m_sendWrites++;
+    m_sendBytes += bytes;
+
+    auto maxFrames = m_sendMaxFramesPerWrite.load(std::memory_order_relaxed);
+    while (frames > maxFrames and not m_sendMaxFramesPerWrite.compare_exchange_weak(maxFrames, frames, std::memory_order_relaxed)) {
+    }
 }
 
 
@@ -462,25 +557,25 @@ void TCPSessionManager::reSend(const std::shared_ptr<TCPSession>& session
 
         for (auto& [messageSeqId, containerIt] : messages_it) {
 
-            auto& sendPkgPtr = containerIt->second;
+            auto& message    = containerIt->second;
 
-            if (sendPkgPtr->head().msg_cmd() == AlgoMsg::MsgAlgoCMD::CMD_NOTIFY_Order and messageSeqId >= begMessageId_order) {
+            if (message.cmd == AlgoMsg::MsgAlgoCMD::CMD_NOTIFY_Order and messageSeqId >= begMessageId_order) {
 
-                session->queueSendMessage2C(sendPkgPtr);
+                session->queueSendMessage2C(message);
 
                 continue;
             }
 
-            if (sendPkgPtr->head().msg_cmd() == AlgoMsg::MsgAlgoCMD::CMD_NOTIFY_Trade and messageSeqId >= begMessageId_trade) {
+            if (message.cmd == AlgoMsg::MsgAlgoCMD::CMD_NOTIFY_Trade and messageSeqId >= begMessageId_trade) {
 
-                session->queueSendMessage2C(sendPkgPtr);
+                session->queueSendMessage2C(message);
 
                 continue;
             }
 
-            if (sendPkgPtr->head().msg_cmd() >= AlgoMsg::MsgAlgoCMD::CMD_NOTIFY_AlgoExecutionInfo and messageSeqId >= begMessageId_algo) {
+            if (message.cmd >= AlgoMsg::MsgAlgoCMD::CMD_NOTIFY_AlgoExecutionInfo and messageSeqId >= begMessageId_algo) {
 
-                session->queueSendMessage2C(sendPkgPtr);
+                session->queueSendMessage2C(message);
             }
         }
     });
@@ -5,12 +5,28 @@
 #include <map>
 #include "typedefs.h"
 #include "AlgoMessages.pb.h"
+#include "MessagePool.h"
 
 namespace asio = boost::asio;
 
 typedef asio::ip::tcp::socket::native_handle_type sockect_handel_t;
 
-typedef std::map<uint64_t, std::shared_ptr<AlgoMsg::MessagePkg>>	MessageContainer;
+/*
+* 出站消息: frame 为带长度头及 body 的完整帧, 序列化一次由各会话共享
+* 缓存/重发只需 seqId/cmd/acctKey, 不持有 pkg, body 所在 Arena 在编码后即可归还
+*/
+struct OutboundMessage {
+
+    uint64_t                                    messageSeqId{ 0 };
+
+    AlgoMsg::MsgAlgoCMD                         cmd{};
+
+    AcctKey_t                                   acctKey{};
+
+    std::shared_ptr<const MessagePool::Frame>   frame{ nullptr };
+};
+
+typedef std::map<uint64_t, OutboundMessage>	MessageContainer;
 
 class TCPSessionManager;
 
@@ -32,7 +48,7 @@ public:
 
     static size_t encodeHeader(unsigned char* buf, size_t body_length);
 
-    void queueSendMessage2C(const std::shared_ptr<AlgoMsg::MessagePkg>&);
+    void queueSendMessage2C(const OutboundMessage&);
 
     asio::ip::tcp::socket& socket();
 
@@ -56,14 +72,26 @@ private:
 
     std::vector<unsigned char>        m_receivingBuffer;
 
-    std::vector<unsigned char>        m_sendingBuffer;
+    static constexpr size_t           MaxFramesPerWrite = 64;       // 单次 gather 写的帧数上限(iovec)
+
+    size_t                            m_sendBatchBytes{ 64 * 1024 };
 
-    std::deque<std::shared_ptr<AlgoMsg::MessagePkg>>  sendingMessageQueue{};
+    bool                              m_tcpNoDelay{ true };
+
+    bool                              m_tcpCork{ false };           // 仅 Linux
+
+    bool                              m_corked{ false };
+
+    std::vector<asio::const_buffer>   m_gatherBuffers{};
+
+    std::deque<OutboundMessage>       sendingMessageQueue{};
 
     std::set<AcctKey_t>               loginAcctKeys{};
 
     void _send();
 
+    void _setCork(bool cork);
+
     void safeDisConnect();
 
 };
@@ -104,10 +132,16 @@ public:
         , bool shouldCache
     );
 
-    void sendMessagesOffset(const std::shared_ptr<AlgoMsg::MessagePkg>&);
+    void sendMessagesOffset(std::vector<OutboundMessage>&&);
+
+    /* 一次聚合写完成: frames 条消息, bytes 字节 */
+    void onFramesSent(size_t frames, size_t bytes);
 
     void printStatInfo();
 
+    /* 长度头 + pkg + body(字段 3) 直接序列化进池化帧, 不经中间 string */
+    static std::shared_ptr<const MessagePool::Frame> encodeFrame(const AlgoMsg::MessagePkg& pkg, const google::protobuf::Message& body);
+
 private:
 
     TCPSessionManager();
@@ -119,6 +153,9 @@ private:
     asio::steady_timer                  m_timer;
     std::mutex                          m_mutex;
     std::atomic<uint64_t>               m_sentMessageCnt{0};
+    std::atomic<uint64_t>               m_sendWrites{0};
+    std::atomic<uint64_t>               m_sendBytes{0};
+    std::atomic<size_t>                 m_sendMaxFramesPerWrite{0};
     bool                                m_cacheAllMessage{ false };
 
     std::map<sockect_handel_t, std::shared_ptr<TCPSession>>       TCPSessions{};
@@ -9,17 +9,17 @@ ShotSignal::ShotSignal(const AlgoOrderId_t algoOrderId, MarketDepth* signal_at_m
     , algoOrderId(algoOrderId)
     , symbol(signal_at_md->symbol)
     , signalTime(signal_at_md->quoteTime)
-    , signal_at_md{ signal_at_md } {
+    , signal_at_md{ MarketDepth::keepAlive(signal_at_md) } {
 }
 
 
 void ShotSignal::update(const MarketDepth* md, const bool useAvgTradePrice) {
 
     //if (useAvgTradePrice and AshareMarketTime::getMarketDuration(signal_at_md->quoteTime, md->quoteTime) <= 60) {
-    //    avgBuyPrice = md->volume - signal_at_md->volume > 0 ? (md->amount - signal_at_md->amount) / (md->volume - signal_at_md->volume) : signal_at_md->askPrice1;
+    //    avgBuyPrice = md->volume - signal_at_md->volume > 0 ? (md->amount - signal_at_md->amount) / (md->volume - signal_at_md->volume) : signal_at_md->askPrices[0];
     //}
     //else if (avgBuyPrice == 0 and md->quoteTime < AshareMarketTime::getClosingCallAuctionBeginTime(md->quoteTime)) {
-    //    avgBuyPrice = md->askPrice1;
+    //    avgBuyPrice = md->askPrices[0];
     //}
 
     lastPrice = md->price;
@@ -3,6 +3,8 @@
 #include "OrderBook.h"
 #include "common.h"
 #include "TCPSession.h"
+#include "BacktestScheduler.h"
+#include "SubTaskPartitioner.h"
 
 using namespace agcommon;
 
@@ -12,7 +14,7 @@ ShotTrader::ShotTrader(const std::shared_ptr<AlgoOrder>& _algoOrderPtr
     
     algoOrderPtr(_algoOrderPtr)
     , symbols(_symbols)
-    , Trader(contextPtr)
+    , Trader(c)
     , maxQuoteTime(posix_time::min_date_time)
     
 {
@@ -171,24 +173,21 @@ asio::awaitable<void> ShotTrader::start() {
             co_return;
         }
 
-        auto self = keep_alive_this<ShotTrader>();
-
-        auto onMarketDepth = [ self ](MarketDepth* md) { self->onMarketDepth(md); };
+        auto onMarketDepth = nullptr;
 
         auto co_onMarketDepth = nullptr;
 
         auto subscribeMarketDepthReq = std::make_shared<SubMarketDepth_t>(algoOrderPtr->algoOrderId, symbols,
             onMarketDepth, co_onMarketDepth, algoOrderPtr->getAcctKey(), false, contextPtr);
 
-        quoteFeedPtr->regesterOnQuoteFeedFinish([self]() {
-                self->stop("");
-            },contextPtr);
-
-        if (quoteFeedPtr->subscribe(subscribeMarketDepthReq) != algoOrderPtr->algoOrderId) {
+        auto stream = quoteFeedPtr->subscribeStream(subscribeMarketDepthReq);
+        if (not stream) {
             SPDLOG_ERROR("[aId:{}]subscribe error:{}", algoOrderPtr->algoOrderId, algoPerf.errMsg);
             stop(algoPerf.errMsg);
             co_return;
         }
+
+        asio::co_spawn(*contextPtr, co_consumeMarketDepths(stream), asio::detached);
     }
 
     auto timer = asio::steady_timer(*contextPtr);
@@ -209,23 +208,21 @@ asio::awaitable<void> ShotTrader::start() {
 
 void  ShotTrader::createSubTask(int max_symbolSize_perTask) {
 
-    auto workerContexts = ContextService::getInstance().getWorkerContext();
-
-    const int symbolSize_perTask = max_symbolSize_perTask;
+    auto workerCount = ContextService::getInstance().getWorkerContext().size();
+    auto tradeDate   = agcommon::getDateInt(algoOrderPtr->startTime);
 
-    std::vector<std::string> symbolPoolVec { symbols.begin(), symbols.end() };
+    TickCountSource costSource = TickCountSource::None;
 
-    size_t subTaskCount = symbolPoolVec.size() / symbolSize_perTask;
-    subTaskCount = symbolPoolVec.size() - symbolSize_perTask * subTaskCount > 0 ? subTaskCount + 1 : subTaskCount;
+    auto plans = SubTaskPartitioner::getInstance().partition(symbols, tradeDate, workerCount, max_symbolSize_perTask, costSource);
 
-    SPDLOG_INFO("[aId:{}]max_symbolSize_perTask:{},will create subTaskCount:{}", algoOrderPtr->algoOrderId, max_symbolSize_perTask, subTaskCount);
+    SPDLOG_INFO("[aId:{}]max_symbolSize_perTask:{},workers:{},costSource:{},will create subTaskCount:{}"
+        , algoOrderPtr->algoOrderId, max_symbolSize_perTask, workerCount, static_cast<int>(costSource), plans.size());
 
-    for (size_t i = 0; i < subTaskCount; i++) {
+    remainSubTasks = plans.size();
 
-        size_t lower = i * symbolSize_perTask;
-        size_t upper = std::min(i * symbolSize_perTask + symbolSize_perTask, symbols.size());
+    auto self = keep_alive_this<ShotTrader>();
 
-        std::unordered_set<Symbol_t> subTask_symbols{ symbolPoolVec.begin() + lower, symbolPoolVec.begin() + upper };
+    for (auto& plan : plans) {
 
         auto subAlgoOrderPtr = std::make_shared<AlgoOrder>(*algoOrderPtr);
 
@@ -233,33 +230,54 @@ void  ShotTrader::createSubTask(int max_symbolSize_perTask) {
         subAlgoOrderPtr->parentAlgoOrderId = algoOrderPtr->algoOrderId;
         subAlgoOrderPtr->isParentOrder = false;
 
-        subAlgoOrders.push_back({ subAlgoOrderPtr,subTask_symbols });
-    }
+        SPDLOG_INFO("[aId:{}]subTask symbols:{},cost:{},predicted:{:.0f}ms,paId:{}"
+            , subAlgoOrderPtr->algoOrderId, plan.symbols.size(), plan.cost, plan.predictedMs, algoOrderPtr->algoOrderId);
 
-    SPDLOG_INFO("[aId:{}]max_symbolSize_perTask:{},will spawn subTaskCount:{}", algoOrderPtr->algoOrderId, max_symbolSize_perTask, subAlgoOrders.size());
+        BacktestTask task{ .taskId = subAlgoOrderPtr->algoOrderId, .name = "SHOT_SUB" };
 
-    auto self = keep_alive_this<ShotTrader>();
+        /* 子任务在调度选中的 worker 上创建, 空闲 worker 从本队列窃取 */
+        task.run = [self, subOrder = subAlgoOrderPtr, plan = std::move(plan), costSource](const AsioContextPtr& ioContext, const SlotRelease_t& release) {
 
-    for (auto& ioContext : workerContexts) {
-        if (subAlgoOrders.size() == 0) {
-            break;
-        }
-        const auto& [subOrder, subTask_symbols] = subAlgoOrders.back();
+            auto trader = std::make_shared<ShotTrader>(subOrder, ioContext, plan.symbols);
+
+            if (self->isStopped() or trader->preStartCheck() != "") {
+                self->onSubTaskBackTestDone(trader, nullptr);
+                release();
+                return;
+            }
+
+            asio::dispatch(*self->contextPtr, [self, trader]() { self->subTraders.insert({ trader->getAlgoOrderId(),trader }); });
+
+            auto begin = std::chrono::steady_clock::now();
+
+            asio::co_spawn(*ioContext, trader->start(), [self, trader, release, begin, cost = plan.cost, predictedMs = plan.predictedMs, costSource](const std::exception_ptr ex) {
+
+                auto actualMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
 
-        auto trader = std::make_shared<ShotTrader>(subOrder, ioContext, subTask_symbols);
+                SPDLOG_INFO("[aId:{}]subTask cost:{},predicted:{:.0f}ms,actual:{:.0f}ms,paId:{}"
+                    , trader->getAlgoOrderId(), cost, predictedMs, actualMs, trader->algoOrderPtr->parentAlgoOrderId);
 
-        if (trader->preStartCheck() == "") {
-            asio::co_spawn(*ioContext, trader->start(), [self, trader](const std::exception_ptr ex) {
+                if (not ex) {
+                    SubTaskPartitioner::getInstance().onSubTaskDone(cost, costSource, actualMs);
+                }
                 self->onSubTaskBackTestDone(trader, ex);
+                release();
                 }
             );
-            subTraders.insert({ subOrder->algoOrderId,trader });
-        }
 
-        subAlgoOrders.pop_back();
+            SPDLOG_INFO("[aId:{}]spawned,symbol size:{},paId:{} ", subOrder->algoOrderId, plan.symbols.size(), subOrder->parentAlgoOrderId);
+        };
+
+        /* 子任务优先于排队中的其他回测 */
+        BacktestScheduler::getInstance().submit(std::move(task), true);
+    }
 
-        SPDLOG_INFO("[aId:{}]spawned,symbol size:{},paId:{} ", subOrder->algoOrderId, subTask_symbols.size(), subOrder->parentAlgoOrderId);
+    /* 父任务只做汇总, 让出执行槽位 */
+    if (releaseSchedulerSlot) {
+        releaseSchedulerSlot();
     }
+
+    SPDLOG_INFO("[aId:{}]submit subTaskCount:{},{}", algoOrderPtr->algoOrderId, plans.size(), BacktestScheduler::getInstance().statInfo());
 }
 
 void ShotTrader::onSubTaskBackTestDone(const std::shared_ptr<ShotTrader>& trader_ptr, const std::exception_ptr ex) {
@@ -278,7 +296,7 @@ void ShotTrader::onSubTaskBackTestDone(const std::shared_ptr<ShotTrader>& trader
             SPDLOG_ERROR("[aId:{}]exception:{}", subAlgoOrderId, e.what());
         }
     }
-    asio::dispatch(*contextPtr, [this, trader_ptr]() {
+    asio::dispatch(*contextPtr, [this, self = keep_alive_this<ShotTrader>(), trader_ptr]() {
 
         for (const auto& [symbol, sss] : trader_ptr->symbol2Signals) {
             auto& vec = symbol2Signals[symbol];
@@ -289,26 +307,13 @@ void ShotTrader::onSubTaskBackTestDone(const std::shared_ptr<ShotTrader>& trader
         }
         trader_ptr->symbol2Signals.clear();
 
-        if (not subAlgoOrders.empty()) {
-
-            auto& [shOrder, part_symbols] = subAlgoOrders.back();
-            auto trader = std::make_shared<ShotTrader>(shOrder,trader_ptr->contextPtr, part_symbols);
-
-            if (trader->preStartCheck() == "") {
+        subTraders.erase(trader_ptr->getAlgoOrderId());
 
-                auto self = keep_alive_this<ShotTrader>();
-                asio::co_spawn(*trader_ptr->contextPtr, trader->start(), 
-                    [self,trader](const std::exception_ptr ex) {
-                        self->onSubTaskBackTestDone(trader, ex);
-                    }
-                );
-                subTraders.insert({ shOrder->algoOrderId,trader });
-            }
-            subAlgoOrders.pop_back();
+        if (remainSubTasks > 0) {
+            remainSubTasks--;
         }
-        subTraders.erase(trader_ptr->getAlgoOrderId());
-        SPDLOG_INFO("[aid{}]Remain subAlgoOrders size:{},running traders:{}", algoOrderPtr->algoOrderId, subAlgoOrders.size(), subTraders.size());
-        if(subTraders.size()==0) {
+        SPDLOG_INFO("[aid{}]Remain subTasks:{},running traders:{}", algoOrderPtr->algoOrderId, remainSubTasks, subTraders.size());
+        if (remainSubTasks == 0) {
             stop("");
         }
     }
@@ -346,7 +351,6 @@ void ShotTrader::stop(const std::string& reason) {
         for (const auto& [symbol, sss] : symbol2Signals) {
             for (const auto& [id,ss] : sss) {
                 SPDLOG_INFO(ss->to_string());
-                ss->signal_at_md->release();
             }
         }
     }
@@ -356,10 +360,7 @@ void ShotTrader::stop(const std::string& reason) {
 
 void ShotTrader::release() {
 
-    for (auto& [symbol, queue] : symbol2MdQueue) {
-        queue->release();
-    }
-    symbol2MdQueue.clear();
+    m_symbolStates.clear();
 
     orderBookPtr = nullptr;
     quoteFeedPtr = nullptr;
@@ -407,12 +408,47 @@ void  ShotTrader::onMarketDepth(MarketDepth* md) {
     algoShot(md);
 }
 
+asio::awaitable<void> ShotTrader::co_consumeMarketDepths(std::shared_ptr<MarketDepthStream> stream) {
+
+    auto self = keep_alive_this<ShotTrader>();
+
+    MarketDepthStream::Batch batch{};
+    std::vector<MarketDepth*> mds{};
+
+    /* 回放结束时流中可能仍有未消费的批, 取空(next 返回 false)后再结束 */
+    while (co_await stream->next(batch)) {
+
+        mds.clear();
+        for (auto& md : batch) {
+            mds.push_back(md.get());
+        }
+        onMarketDepths(mds);
+    }
+    SPDLOG_DEBUG("[aId:{}]stream consume done,{}", algoOrderPtr->algoOrderId, stream->stat().to_string());
+
+    stop("");
+}
+
+void ShotTrader::onMarketDepths(std::span<MarketDepth* const> mds) {
+
+    for (auto md : mds) {
+        if (md->quoteTime > algoOrderPtr->endTime) {
+            stop("");
+            return;
+        }
+        if (isStopped()) {
+            return;
+        }
+        algoShot(md);
+    }
+}
+
 void ShotTrader::algoShot(MarketDepth* md) {
 
-    if (md->quoteTime < agcommon::AshareMarketTime::getMarketOpenTime(md->quoteTime)) {
+    if (md->quoteNs < agcommon::AshareMarketTime::getMarketOpenTime(md->quoteNs)) {
         return;
     }
-    if (agcommon::AshareMarketTime::isAfternoonBreakTime(md->quoteTime)) {
+    if (agcommon::AshareMarketTime::isAfternoonBreakTime(md->quoteNs)) {
         return;
     }
     auto preMaxQuoteTime = maxQuoteTime;
@@ -420,21 +456,28 @@ void ShotTrader::algoShot(MarketDepth* md) {
         maxQuoteTime = md->quoteTime;
     }
 
-    int SHOT_Shot_Window_TickSize  = algoOrderPtr->getOrDefault("SHOT_Watch_Window_TickSize", 120);
-    int SHOT_Refer_Window_TickSize = algoOrderPtr->getOrDefault("SHOT_Refer_Window_TickSize",0);
+    auto& state = m_symbolStates[md->symbolId];
+    if (not state.mdQueue) {
+        int SHOT_Shot_Window_TickSize  = algoOrderPtr->getOrDefault("SHOT_Watch_Window_TickSize", 120);
+        int SHOT_Refer_Window_TickSize = algoOrderPtr->getOrDefault("SHOT_Refer_Window_TickSize",0);
 
-    auto [it, inserted] = symbol2MdQueue.try_emplace(md->symbol, std::make_shared<LimitedQueue>(SHOT_Shot_Window_TickSize,SHOT_Refer_Window_TickSize));
-    auto& mdQueue = it->second;
+        state.mdQueue = std::make_shared<LimitedQueue>(SHOT_Shot_Window_TickSize, SHOT_Refer_Window_TickSize);
+        state.signals = &symbol2Signals[md->symbol];
+        if (auto it = localSecurityInfoMap.find(md->symbol); it != localSecurityInfoMap.end()) {
+            state.ssinfo = it->second;
+        }
+    }
+    auto& mdQueue = state.mdQueue;
     mdQueue->append(md);
 
-    auto& signalMap = symbol2Signals[md->symbol];
+    auto& signalMap = *state.signals;
 
     for (auto& [id, ss] : signalMap) {
         ss->update(md, true);
     }
     
     if (md->quoteTime< algoOrderPtr->startTime or md->quoteTime>algoOrderPtr->endTime or
-        md->quoteTime >= agcommon::AshareMarketTime::getClosingCallAuctionBeginTime(md->quoteTime)) {
+        md->quoteNs >= agcommon::AshareMarketTime::getClosingCallAuctionBeginTime(md->quoteNs)) {
         return;
     }
 
@@ -448,7 +491,7 @@ void ShotTrader::algoShot(MarketDepth* md) {
         double SHOT_Watch_Window_Range_Percent = algoOrderPtr->getOrDefault("SHOT_Watch_Window_Range_Percent", 2.0);
         double SHOT_Confirm_Duration_Seconds = algoOrderPtr->getOrDefault("SHOT_Confirm_Duration_Seconds", 60.0 * 5);
 
-        auto base_md = mdQueue->get_item(0);
+        const auto base_md = mdQueue->front();
 
         const auto [shotAmt, shotAvgAmt]   = mdQueue->getShotAmount();
         const auto [referAmt, referAvgAmt] = mdQueue->getShotAmount();
@@ -458,7 +501,7 @@ void ShotTrader::algoShot(MarketDepth* md) {
             return;
         }
 
-        auto& ssinfo = localSecurityInfoMap.find(md->symbol)->second;
+        auto& ssinfo = state.ssinfo;
 
         if (underWater > 0) {
             if (ssinfo->lowLimitPrice == 0) {
@@ -483,11 +526,11 @@ void ShotTrader::algoShot(MarketDepth* md) {
 
         if (istrig) {
 
-            double midPrice     = base_md->getMidPrice();
+            double midPrice     = base_md.midPrice;
             double shotChange   = mdQueue->getShotChageRate();
-            double shotDuration = AshareMarketTime::getMarketDuration(base_md->quoteTime, md->quoteTime);
+            double shotDuration = AshareMarketTime::getMarketDuration(base_md.quoteNs, md->quoteNs);
 
-            double buyPrice = std::max(md->price, md->askPrice1);
+            double buyPrice = std::max(md->price, md->askPrices[0]);
 
             std::size_t times = signalMap.size() + 1;
 
@@ -516,7 +559,7 @@ void ShotTrader::algoShot(MarketDepth* md) {
 
                 ss->sigArrivePrice  = md->price;
                 ss->sigArriveChange = md->changeP;
-                ss->buyPrice = md->askPrice1;
+                ss->buyPrice = md->askPrices[0];
 
                 ss->avgBuyPrice = 0;
                 ss->lastPrice  =  md->price;
@@ -670,7 +713,7 @@ void ShotTrader::performanceSummary(bool backTestDone /*=false*/) {
  
 void ShotTrader::publishSignalMessage(const ShotSignal* ss) const {
 
-    auto msgPtr = std::make_shared<AlgoMsg::MsgShotSignalInfo>();
+    auto msgPtr = MessagePool::getInstance().create<AlgoMsg::MsgShotSignalInfo>();
 
     msgPtr->set_algo_order_id(algoOrderPtr->algoOrderId);
 
@@ -723,7 +766,16 @@ void ShotTrader::publishAlgoperformance() const {
     if (not algoOrderPtr->isParentOrder)
         return;
 
-    auto msgPtr = std::make_shared<AlgoMsg::MsgShotPerformance>();
+    auto msgPtr = encode2ShotMessage();
+
+    auto shouldCache = agcommon::AlgoStatus::isFinalStatus(algoPerf.algoStatus);
+
+    TCPSessionManager::getInstance().sendNotify2C(algoOrderPtr->getAcctKey(), AlgoMsg::CMD_NOTIFY_ShotPerformance, msgPtr, shouldCache);
+}
+
+std::shared_ptr<AlgoMsg::MsgShotPerformance> ShotTrader::encode2ShotMessage() const {
+
+    auto msgPtr = MessagePool::getInstance().create<AlgoMsg::MsgShotPerformance>();
     msgPtr->set_algo_order_id(algoPerf.algoOrderId);
     msgPtr->set_client_algo_order_id(algoPerf.clientAlgoOrderId);
     msgPtr->set_algo_category(algoOrderPtr->algoCategory);
@@ -748,8 +800,5 @@ void ShotTrader::publishAlgoperformance() const {
     msgPtr->set_algo_msg(algoPerf.errMsg);
     msgPtr->set_create_time(agcommon::getDateTimeInt(algoPerf.createTime));
 
-    auto shouldCache = agcommon::AlgoStatus::isFinalStatus(algoPerf.algoStatus);
-
-    TCPSessionManager::getInstance().sendNotify2C(algoOrderPtr->getAcctKey(), AlgoMsg::CMD_NOTIFY_ShotPerformance, msgPtr, shouldCache);
-    
+    return msgPtr;
 }
\ No newline at end of file
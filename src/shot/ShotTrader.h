@@ -2,12 +2,14 @@
 
 #include <vector>
 #include <unordered_map>
+#include <span>
 #include "common.h"
 #include "AlgoOrder.h"
 #include "ShotSignal.h"
 #include "AlgoPlacer.h"
 #include "StockDataManager.h"
 #include "LimitedQueue.h"
+#include "MarketDepthStream.h"
 
 class OrderBook;
 class QuoteFeed;
@@ -28,6 +30,12 @@ public:
 
     void onMarketDepth(MarketDepth* md)   override;
 
+    /* 同一时间戳的全市场 MarketDepth 一次处理 */
+    void onMarketDepths(std::span<MarketDepth* const> mds);
+
+    /* 拉取式订阅, 按自身节奏取批 */
+    asio::awaitable<void> co_consumeMarketDepths(std::shared_ptr<MarketDepthStream> stream);
+
     void onOrderUpdate(const Order* order) override;
 
     bool isStopped() const override { return agcommon::AlgoStatus::isFinalStatus(algoPerf.algoStatus); }
@@ -56,6 +64,10 @@ private:
 
     void publishAlgoperformance() const override;
 
+    std::shared_ptr<google::protobuf::Message> encodePerformanceMessage() const override { return encode2ShotMessage(); }
+
+    std::shared_ptr<AlgoMsg::MsgShotPerformance> encode2ShotMessage() const;
+
     std::shared_ptr<AlgoOrder>      algoOrderPtr;
 
     ShotPerformance                 algoPerf;
@@ -66,8 +78,6 @@ private:
 
     std::unordered_map<Symbol_t, std::shared_ptr<SecurityStaticInfo>>   localSecurityInfoMap{};
 
-    std::unordered_map<std::string, std::shared_ptr<LimitedQueue>>      symbol2MdQueue{};
-
     std::shared_ptr<OrderBook> orderBookPtr{ nullptr };
 
     std::shared_ptr<QuoteFeed>  quoteFeedPtr{ nullptr };
@@ -76,6 +86,18 @@ private:
 
     SignalContainer symbol2Signals{};
 
+    /* algoShot 逐 tick 使用的 symbol 状态, SymbolId 下标, 首个 tick 时建立 */
+    struct SymbolState {
+
+        std::shared_ptr<LimitedQueue>           mdQueue{ nullptr };
+
+        SignalContainer::mapped_type*           signals{ nullptr };     // symbol2Signals 的节点, rehash 不失效
+
+        std::shared_ptr<SecurityStaticInfo>     ssinfo{ nullptr };
+    };
+
+    SymbolVector<SymbolState>   m_symbolStates{};
+
     QuoteTime_t     maxQuoteTime{};
 
 private:
@@ -96,5 +118,5 @@ private:
 
     std::unordered_map<AlgoOrderId_t, std::shared_ptr<ShotTrader>> subTraders;
 
-    std::vector<std::pair<std::shared_ptr<AlgoOrder>, std::unordered_set<Symbol_t>>> subAlgoOrders;
+    size_t remainSubTasks{ 0 };     // 未完成的子任务数, 仅在本 context 读写
 };
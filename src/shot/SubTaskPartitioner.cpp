@@ -0,0 +1,90 @@
+#include "SubTaskPartitioner.h"
+#include <queue>
+#include "Configs.h"
+
+SubTaskPartitioner::SubTaskPartitioner() {
+
+    /* tick 数来源的初始吞吐, 之后按实际耗时修正; 日线成交量没有先验, 首个子任务完成后才有预测 */
+    auto ticksPerSecond = agcommon::Configs::getConfigs().getConfigOrDefault("DATACONFIG", "ReplayTicksPerSecond", 200000);
+
+    m_costPerMs[static_cast<size_t>(TickCountSource::Snapshot)] = ticksPerSecond / 1000.0;
+    m_costPerMs[static_cast<size_t>(TickCountSource::H5)]       = ticksPerSecond / 1000.0;
+}
+
+std::vector<SubTaskPlan> SubTaskPartitioner::partition(const std::unordered_set<Symbol_t>& symbols
+    , const uint32_t tradeDate
+    , const size_t workerCount
+    , const size_t maxSymbolsPerTask
+    , TickCountSource& source) {
+
+    auto symbol2Count = StockDataManager::getInstance().getSymbolTickCounts(symbols, tradeDate, source);
+
+    /* 取不到成本的 symbol 按已知成本的中位数计, 全部未知时等权 */
+    uint64_t defaultCost = 1;
+    if (not symbol2Count.empty()) {
+        std::vector<uint64_t> counts{};
+        counts.reserve(symbol2Count.size());
+        for (auto& [symbol, count] : symbol2Count) {
+            counts.push_back(count);
+        }
+        std::nth_element(counts.begin(), counts.begin() + counts.size() / 2, counts.end());
+        defaultCost = std::max<uint64_t>(counts[counts.size() / 2], 1);
+    }
+
+    std::vector<std::pair<uint64_t, Symbol_t>> costs{};
+    costs.reserve(symbols.size());
+    for (auto& symbol : symbols) {
+        auto it = symbol2Count.find(symbol);
+        costs.emplace_back(it != symbol2Count.end() ? it->second : defaultCost, symbol);
+    }
+    std::sort(costs.begin(), costs.end(), std::greater<>());
+
+    auto workers    = std::max<size_t>(workerCount, 1);
+    auto minTasks   = (symbols.size() + maxSymbolsPerTask - 1) / std::max<size_t>(maxSymbolsPerTask, 1);
+    auto waves      = std::max<size_t>((minTasks + workers - 1) / workers, 1);
+    auto taskCount  = std::min(symbols.size(), workers * waves);
+
+    std::vector<SubTaskPlan> plans(taskCount);
+
+    /* 小顶堆: (当前成本, 子任务下标) */
+    using Bin_t = std::pair<uint64_t, size_t>;
+    std::priority_queue<Bin_t, std::vector<Bin_t>, std::greater<>> bins{};
+    for (size_t i = 0; i < taskCount; i++) {
+        bins.emplace(0, i);
+    }
+
+    for (auto& [cost, symbol] : costs) {
+        auto [binCost, idx] = bins.top();
+        bins.pop();
+        plans[idx].symbols.insert(symbol);
+        plans[idx].cost += cost;
+        bins.emplace(binCost + cost, idx);
+    }
+
+    for (auto& plan : plans) {
+        plan.predictedMs = predictMs(plan.cost, source);
+    }
+    return plans;
+}
+
+double SubTaskPartitioner::predictMs(const uint64_t cost, const TickCountSource source) {
+
+    std::scoped_lock lock(m_mutex);
+
+    auto costPerMs = m_costPerMs[static_cast<size_t>(source)];
+    return costPerMs > 0 ? cost / costPerMs : 0;
+}
+
+void SubTaskPartitioner::onSubTaskDone(const uint64_t cost, const TickCountSource source, const double actualMs) {
+
+    if (cost == 0 or actualMs <= 0 or source == TickCountSource::None) {
+        return;
+    }
+
+    std::scoped_lock lock(m_mutex);
+
+    auto& costPerMs = m_costPerMs[static_cast<size_t>(source)];
+    auto  observed  = cost / actualMs;
+
+    costPerMs = costPerMs > 0 ? costPerMs * 0.7 + observed * 0.3 : observed;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include "typedefs.h"
+#include "StockDataManager.h"
+
+/*
+* ShotTrader 回测子任务划分: 以 symbol 当日 tick 数作为回放成本, 按成本从大到小依次放入当前成本最小的子任务(LPT)
+* 子任务数取 worker 数的整数倍, 保证每个子任务平均 symbol 数不超过 maxSymbolsPerTask
+* 预测耗时 = 成本 / 吞吐, 吞吐按成本来源分别用已完成子任务的实际耗时做指数平滑
+*/
+
+struct SubTaskPlan {
+
+    std::unordered_set<Symbol_t>    symbols{};
+
+    uint64_t                        cost{ 0 };
+
+    double                          predictedMs{ 0 };   // 0: 尚无吞吐数据
+};
+
+class SubTaskPartitioner {
+
+public:
+
+    static SubTaskPartitioner& getInstance() {
+        static SubTaskPartitioner instance{};
+        return instance;
+    }
+
+    SubTaskPartitioner(const SubTaskPartitioner&) = delete;
+    SubTaskPartitioner& operator=(const SubTaskPartitioner&) = delete;
+
+    std::vector<SubTaskPlan> partition(const std::unordered_set<Symbol_t>& symbols
+        , const uint32_t tradeDate
+        , const size_t workerCount
+        , const size_t maxSymbolsPerTask
+        , TickCountSource& source);
+
+    double predictMs(const uint64_t cost, const TickCountSource source);
+
+    /* 用实际耗时更新该来源的吞吐 */
+    void onSubTaskDone(const uint64_t cost, const TickCountSource source, const double actualMs);
+
+private:
+
+    SubTaskPartitioner();
+
+    std::mutex                  m_mutex;
+
+    std::array<double, 4>       m_costPerMs{};      // 按 TickCountSource 下标, 0: 未知
+};
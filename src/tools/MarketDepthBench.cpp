@@ -0,0 +1,117 @@
+
+#include <random>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+#include "MarketDepth.h"
+
+/*
+* MarketDepth::calDelta 微基准: 定长 DeltaDepth vs 原 std::map<double,int> 实现
+* usage: marketDepthBench [行情对数, 默认 100000] [轮数, 默认 20]
+*/
+
+/* 原实现, 仅用于对比 */
+static std::map<double, int> calDeltaMap(const MarketDepth& md, const MarketDepth& lastMd) {
+
+    std::map<double, int> deltaDepth;
+
+    for (auto& [p, v] : md.getAskQuotes()) {
+        std::unordered_map<double, int> p2vs{};
+        for (auto& [lp, lv] : lastMd.getAskQuotes()) {
+            p2vs.emplace(lp, lv);
+        }
+        if (p2vs.find(p) != p2vs.end()) {
+            deltaDepth[p] = v - p2vs[p];
+        }
+    }
+    for (auto& [p, v] : md.getBidQuotes()) {
+        std::unordered_map<double, int> p2vs{};
+        for (auto& [lp, lv] : lastMd.getBidQuotes()) {
+            p2vs.emplace(lp, lv);
+        }
+        if (p2vs.find(p) != p2vs.end()) {
+            deltaDepth[p] = v - p2vs[p];
+        }
+    }
+    return deltaDepth;
+}
+
+static void fillBook(MarketDepth& md, double mid, std::mt19937& rng) {
+
+    std::uniform_int_distribution<int> volDist(1, 500);
+
+    for (size_t i = 0; i < MarketDepth::Levels; ++i) {
+        md.askPrices[i] = std::round((mid + 0.01 * (i + 1)) * 100) / 100;
+        md.bidPrices[i] = std::round((mid - 0.01 * i) * 100) / 100;
+        md.askVols[i]   = volDist(rng) * 100;
+        md.bidVols[i]   = volDist(rng) * 100;
+    }
+    md.syncTicks();
+}
+
+int main(int argc, char* argv[]) {
+
+    size_t pairs  = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 20;
+
+    std::mt19937 rng(20240101);
+    std::uniform_int_distribution<int> moveDist(-2, 2);
+
+    /* 相邻两笔行情中间价随机移动 0~2 个价位 */
+    std::vector<MarketDepth> lastMds(pairs);
+    std::vector<MarketDepth> mds(pairs);
+
+    for (size_t i = 0; i < pairs; ++i) {
+        double mid = 10.0 + (i % 100) * 0.1;
+        fillBook(lastMds[i], mid, rng);
+        fillBook(mds[i], mid + moveDist(rng) * 0.01, rng);
+        lastMds[i].quoteTime = boost::posix_time::time_from_string("2024-01-02 09:30:00");
+        mds[i].quoteTime     = lastMds[i].quoteTime + boost::posix_time::seconds(3);
+        lastMds[i].quoteNs   = agcommon::qtime::fromPtime(lastMds[i].quoteTime);
+        mds[i].quoteNs       = agcommon::qtime::fromPtime(mds[i].quoteTime);
+    }
+
+    /* 结果一致性校验 */
+    for (size_t i = 0; i < pairs; ++i) {
+        auto expected = calDeltaMap(mds[i], lastMds[i]);
+        const auto& actual = mds[i].calDelta(&lastMds[i]);
+
+        bool same = expected.size() == actual.size();
+        size_t k = 0;
+        for (auto it = expected.begin(); same and it != expected.end(); ++it, ++k) {
+            same = actual[k].first == mds[i].toTicks(it->first) and actual[k].second == it->second;
+        }
+        if (not same) {
+            SPDLOG_ERROR("calDelta mismatch at {}: map size {}, inline size {}", i, expected.size(), actual.size());
+            return 1;
+        }
+    }
+
+    int64_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < pairs; ++i) {
+            auto delta = calDeltaMap(mds[i], lastMds[i]);
+            checksum += delta.size();
+        }
+    }
+    auto mapNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < pairs; ++i) {
+            const auto& delta = mds[i].calDelta(&lastMds[i]);
+            checksum += delta.size();
+        }
+    }
+    auto inlineNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    auto ops = static_cast<double>(pairs * rounds);
+
+    SPDLOG_INFO("calDelta pairs:{},rounds:{},checksum:{}", pairs, rounds, checksum);
+    SPDLOG_INFO("  std::map    : {:.1f} ns/op", mapNs / ops);
+    SPDLOG_INFO("  DeltaDepth  : {:.1f} ns/op", inlineNs / ops);
+    SPDLOG_INFO("  speedup     : {:.2f}x", inlineNs > 0 ? static_cast<double>(mapNs) / inlineNs : 0.0);
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+
+#include <spdlog/spdlog.h>
+#include <highfive/highfive.hpp>
+#include "H5DataTypes.h"
+#include "TickSnapshot.h"
+
+/*
+* Tick{yyyymmdd}.h5 -> Tick{yyyymmdd}.tks 离线转换
+* usage: tickSnapshotConverter <Tick*.h5 文件或目录> [输出目录, 默认与输入相同]
+* 已存在的 .tks 跳过, 需要重建时先删除
+*/
+
+static std::string symbolFromH5Key(const std::string& key) {
+
+    /* SZSE000001 -> 000001.SZ, SHSE600000 -> 600000.SH */
+    if (key.size() == 10 and key.starts_with("SZSE")) {
+        return key.substr(4) + ".SZ";
+    }
+    if (key.size() == 10 and key.starts_with("SHSE")) {
+        return key.substr(4) + ".SH";
+    }
+    return key;
+}
+
+static bool convertFile(const std::filesystem::path& h5Path, const std::filesystem::path& outDir) {
+
+    auto stem = h5Path.stem().string();
+    if (stem.size() < 12) {
+        SPDLOG_WARN("skip {}, can not parse trade date", h5Path.string());
+        return false;
+    }
+    auto tradeDate = static_cast<uint32_t>(std::stoul(stem.substr(stem.size() - 8)));
+    auto outPath   = TickSnapshotFile::snapshotPath(outDir, tradeDate);
+
+    if (std::filesystem::exists(outPath)) {
+        SPDLOG_INFO("skip {}, snapshot exists", outPath.string());
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::map<Symbol_t, std::vector<h5data::Tick>> series{};
+    size_t tickCount = 0;
+
+    try {
+        HighFive::File file(h5Path.string(), HighFive::File::ReadOnly);
+
+        for (const auto& key : file.listObjectNames()) {
+
+            std::vector<h5data::Tick> ticks{};
+            file.getDataSet(key).read<std::vector<h5data::Tick>>(ticks);
+
+            std::stable_sort(ticks.begin(), ticks.end(), [](const h5data::Tick& a, const h5data::Tick& b) { return a.created_at < b.created_at; });
+
+            tickCount += ticks.size();
+            series.emplace(symbolFromH5Key(key), std::move(ticks));
+        }
+    }
+    catch (const std::exception& e) {
+        SPDLOG_ERROR("read {} failed:{}", h5Path.string(), e.what());
+        return false;
+    }
+
+    std::string errMsg{};
+    if (not TickSnapshotFile::write(outPath, tradeDate, series, errMsg)) {
+        SPDLOG_ERROR("write {} failed:{}", outPath.string(), errMsg);
+        return false;
+    }
+
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    SPDLOG_INFO("{} -> {},symbols:{},ticks:{},cost:{}ms", h5Path.string(), outPath.string(), series.size(), tickCount, cost);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2) {
+        SPDLOG_ERROR("usage: {} <Tick*.h5 file or dir> [output dir]", argv[0]);
+        return 1;
+    }
+
+    std::filesystem::path input(argv[1]);
+
+    std::vector<std::filesystem::path> h5Files{};
+
+    if (std::filesystem::is_directory(input)) {
+        for (const auto& file : std::filesystem::directory_iterator(input)) {
+            auto fileName = file.path().filename().string();
+            if (file.is_regular_file() and fileName.starts_with("Tick") and fileName.ends_with(".h5")) {
+                h5Files.push_back(file.path());
+            }
+        }
+        std::sort(h5Files.begin(), h5Files.end());
+    }
+    else if (std::filesystem::is_regular_file(input)) {
+        h5Files.push_back(input);
+    }
+    else {
+        SPDLOG_ERROR("input not exist:{}", input.string());
+        return 1;
+    }
+
+    std::filesystem::path outDir = argc > 2 ? std::filesystem::path(argv[2])
+        : (std::filesystem::is_directory(input) ? input : input.parent_path());
+
+    std::filesystem::create_directories(outDir);
+
+    int failed = 0;
+    for (const auto& h5Path : h5Files) {
+        if (not convertFile(h5Path, outDir)) {
+            failed++;
+        }
+    }
+
+    SPDLOG_INFO("converted {} files, failed:{}", h5Files.size() - failed, failed);
+
+    return failed == 0 ? 0 : 2;
+}